@@ -9,7 +9,6 @@
 //  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
 //
 
-#include <mmintrin.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <fstream>
@@ -37,6 +36,7 @@
 #include <QtCore/QJsonDocument>
 #include <QtCore/QJsonObject>
 #include <QtCore/QJsonValue>
+#include <QtCore/QRunnable>
 #include <QtCore/QTimer>
 #include <QtNetwork/QNetworkRequest>
 #include <QtNetwork/QNetworkReply>
@@ -50,6 +50,7 @@
 #include <StdDev.h>
 #include <UUID.h>
 
+#include "AudioMixKernels.h"
 #include "AudioRingBuffer.h"
 #include "AudioMixerClientData.h"
 #include "AvatarAudioRingBuffer.h"
@@ -67,6 +68,79 @@ void attachNewBufferToNode(Node *newNode) {
     }
 }
 
+/// Works through a contiguous slice of the frame's listeners, either finding what each of them can hear or mixing them.
+/// Each job only writes the inputs and mixes of the listeners in its own slice so that several jobs can run at once on the
+/// mixer's thread pool.
+class AudioMixerJob : public QRunnable {
+public:
+    AudioMixerJob(AudioMixer* mixer);
+    
+    void setSlice(AudioMixer::FramePhase phase, const QVector<SharedNodePointer>* listeners, int begin, int end,
+                  AudioMixer::ListenerInputs* listenerInputs, const int* listenerMixIndices, float* listenerMixes);
+    int takeNumMixes() { int numMixes = _numMixes; _numMixes = 0; return numMixes; }
+    
+    void run();
+    
+private:
+    AudioMixer* _mixer;
+    AudioMixer::FramePhase _phase;
+    const QVector<SharedNodePointer>* _listeners;
+    int _begin;
+    int _end;
+    AudioMixer::ListenerInputs* _listenerInputs;
+    const int* _listenerMixIndices;
+    float* _listenerMixes;
+    int _numMixes;
+    QVector<AudioSource> _sources;
+};
+
+AudioMixerJob::AudioMixerJob(AudioMixer* mixer) :
+    _mixer(mixer),
+    _phase(AudioMixer::FindListenerInputs),
+    _listeners(NULL),
+    _begin(0),
+    _end(0),
+    _listenerInputs(NULL),
+    _listenerMixIndices(NULL),
+    _listenerMixes(NULL),
+    _numMixes(0)
+{
+    // jobs are re-used every frame, the mixer owns them
+    setAutoDelete(false);
+}
+
+void AudioMixerJob::setSlice(AudioMixer::FramePhase phase, const QVector<SharedNodePointer>* listeners,
+                             int begin, int end, AudioMixer::ListenerInputs* listenerInputs, const int* listenerMixIndices,
+                             float* listenerMixes) {
+    _phase = phase;
+    _listeners = listeners;
+    _begin = begin;
+    _end = end;
+    _listenerInputs = listenerInputs;
+    _listenerMixIndices = listenerMixIndices;
+    _listenerMixes = listenerMixes;
+}
+
+void AudioMixerJob::run() {
+    for (int i = _begin; i < _end; i++) {
+        if (_phase == AudioMixer::FindListenerInputs) {
+            _mixer->findListenerInputs(_listeners->at(i).data(), _listenerInputs[i], _sources);
+        } else if (_listenerMixIndices[i] == i) {
+            // this listener has its own mix, or is the first of a group that shares one
+            float* clientSamples = _listenerMixes + (i * NETWORK_BUFFER_LENGTH_SAMPLES_STEREO);
+            
+            if (_listenerInputs[i].canShareMix) {
+                _numMixes += _mixer->mixSharedSources(_listenerInputs[i].sources, clientSamples);
+            } else {
+                _numMixes += _mixer->prepareMixForListeningNode(_listeners->at(i).data(), clientSamples, _sources);
+            }
+        }
+    }
+    
+    // let the mixer thread know this slice is done
+    _mixer->_finishedMixerJobs.release();
+}
+
 bool AudioMixer::_useDynamicJitterBuffers = false;
 
 AudioMixer::AudioMixer(const QByteArray& packet) :
@@ -77,6 +151,7 @@ AudioMixer::AudioMixer(const QByteArray& packet) :
     _numStatFrames(0),
     _sumListeners(0),
     _sumMixes(0),
+    _sumSharedMixListeners(0),
     _sourceUnattenuatedZone(NULL),
     _listenerUnattenuatedZone(NULL),
     _lastSendAudioStreamStatsTime(usecTimestampNow())
@@ -87,14 +162,100 @@ AudioMixer::AudioMixer(const QByteArray& packet) :
 AudioMixer::~AudioMixer() {
     delete _sourceUnattenuatedZone;
     delete _listenerUnattenuatedZone;
+    
+    _mixerThreadPool.waitForDone();
+    qDeleteAll(_mixerJobs);
 }
 
 const float ATTENUATION_BEGINS_AT_DISTANCE = 1.0f;
 const float ATTENUATION_AMOUNT_PER_DOUBLING_IN_DISTANCE = 0.18f;
 const float ATTENUATION_EPSILON_DISTANCE = 0.1f;
 
-void AudioMixer::addBufferToMixForListeningNodeWithBuffer(PositionalAudioRingBuffer* bufferToAdd,
-                                                          AvatarAudioRingBuffer* listeningNodeBuffer) {
+void AudioMixer::computeSpatialization(PositionalAudioRingBuffer* bufferToAdd, AvatarAudioRingBuffer* listeningNodeBuffer,
+                                       float radius, AudioSourceSpatialization& spatialization) {
+    float attenuationCoefficient = 1.0f;
+    float bearingRelativeAngleToSource = 0.0f;
+    int numSamplesDelay = 0;
+    float weakChannelAmplitudeRatio = 1.0f;
+    
+    glm::vec3 relativePosition = bufferToAdd->getPosition() - listeningNodeBuffer->getPosition();
+    float distanceBetween = glm::length(relativePosition);
+    
+    glm::quat inverseOrientation = glm::inverse(listeningNodeBuffer->getOrientation());
+    
+    float distanceSquareToSource = glm::dot(relativePosition, relativePosition);
+    
+    if (radius == 0 || (distanceSquareToSource > radius * radius)) {
+        // this is either not a spherical source, or the listener is outside the sphere
+        
+        if (radius > 0) {
+            // this is a spherical source - the distance used for the coefficient
+            // needs to be the closest point on the boundary to the source
+            
+            // ovveride the distance to the node with the distance to the point on the
+            // boundary of the sphere
+            distanceSquareToSource -= (radius * radius);
+            
+        } else {
+            // calculate the angle delivery for off-axis attenuation
+            glm::vec3 rotatedListenerPosition = glm::inverse(bufferToAdd->getOrientation()) * relativePosition;
+            
+            float angleOfDelivery = glm::angle(glm::vec3(0.0f, 0.0f, -1.0f),
+                                               glm::normalize(rotatedListenerPosition));
+            
+            const float MAX_OFF_AXIS_ATTENUATION = 0.2f;
+            const float OFF_AXIS_ATTENUATION_FORMULA_STEP = (1 - MAX_OFF_AXIS_ATTENUATION) / 2.0f;
+            
+            float offAxisCoefficient = MAX_OFF_AXIS_ATTENUATION +
+                (OFF_AXIS_ATTENUATION_FORMULA_STEP * (angleOfDelivery / PI_OVER_TWO));
+            
+            // multiply the current attenuation coefficient by the calculated off axis coefficient
+            attenuationCoefficient *= offAxisCoefficient;
+        }
+        
+        glm::vec3 rotatedSourcePosition = inverseOrientation * relativePosition;
+        
+        if (distanceBetween >= ATTENUATION_BEGINS_AT_DISTANCE) {
+            // calculate the distance coefficient using the distance to this node
+            float distanceCoefficient = 1 - (logf(distanceBetween / ATTENUATION_BEGINS_AT_DISTANCE) / logf(2.0f)
+                                             * ATTENUATION_AMOUNT_PER_DOUBLING_IN_DISTANCE);
+            
+            if (distanceCoefficient < 0) {
+                distanceCoefficient = 0;
+            }
+            
+            // multiply the current attenuation coefficient by the distance coefficient
+            attenuationCoefficient *= distanceCoefficient;
+        }
+        
+        // project the rotated source position vector onto the XZ plane
+        rotatedSourcePosition.y = 0.0f;
+        
+        // produce an oriented angle about the y-axis
+        bearingRelativeAngleToSource = glm::orientedAngle(glm::vec3(0.0f, 0.0f, -1.0f),
+                                                          glm::normalize(rotatedSourcePosition),
+                                                          glm::vec3(0.0f, 1.0f, 0.0f));
+        
+        const float PHASE_AMPLITUDE_RATIO_AT_90 = 0.5;
+        
+        // figure out the number of samples of delay and the ratio of the amplitude
+        // in the weak channel for audio spatialization
+        float sinRatio = fabsf(sinf(bearingRelativeAngleToSource));
+        numSamplesDelay = SAMPLE_PHASE_DELAY_AT_90 * sinRatio;
+        weakChannelAmplitudeRatio = 1 - (PHASE_AMPLITUDE_RATIO_AT_90 * sinRatio);
+    }
+    
+    spatialization.attenuationCoefficient = attenuationCoefficient;
+    spatialization.bearingRelativeAngleToSource = bearingRelativeAngleToSource;
+    spatialization.numSamplesDelay = numSamplesDelay;
+    spatialization.weakChannelAmplitudeRatio = weakChannelAmplitudeRatio;
+    spatialization.setComputedFor(bufferToAdd, listeningNodeBuffer, radius);
+}
+
+bool AudioMixer::addBufferToMixForListeningNodeWithBuffer(PositionalAudioRingBuffer* bufferToAdd,
+                                                          AvatarAudioRingBuffer* listeningNodeBuffer,
+                                                          AudioMixerClientData* listenerClientData,
+                                                          float* clientSamples) {
     float bearingRelativeAngleToSource = 0.0f;
     float attenuationCoefficient = 1.0f;
     int numSamplesDelay = 0;
@@ -116,205 +277,328 @@ void AudioMixer::addBufferToMixForListeningNodeWithBuffer(PositionalAudioRingBuf
         if (bufferToAdd->getNextOutputTrailingLoudness() / distanceBetween <= _minAudibilityThreshold) {
             // according to mixer performance we have decided this does not get to be mixed in
             // bail out
-            return;
+            return false;
         }
         
-        ++_sumMixes;
-        
         if (bufferToAdd->getListenerUnattenuatedZone()) {
             shouldAttenuate = !bufferToAdd->getListenerUnattenuatedZone()->contains(listeningNodeBuffer->getPosition());
         }
         
+        float radius = 0.0f;
+        
         if (bufferToAdd->getType() == PositionalAudioRingBuffer::Injector) {
-            attenuationCoefficient *= reinterpret_cast<InjectedAudioRingBuffer*>(bufferToAdd)->getAttenuationRatio();
+            InjectedAudioRingBuffer* injectedBuffer = reinterpret_cast<InjectedAudioRingBuffer*>(bufferToAdd);
+            attenuationCoefficient *= injectedBuffer->getAttenuationRatio();
+            radius = injectedBuffer->getRadius();
         }
         
         shouldAttenuate = shouldAttenuate && distanceBetween > ATTENUATION_EPSILON_DISTANCE;
         
         if (shouldAttenuate) {
-            glm::quat inverseOrientation = glm::inverse(listeningNodeBuffer->getOrientation());
-            
-            float distanceSquareToSource = glm::dot(relativePosition, relativePosition);
-            float radius = 0.0f;
+            // the spatialization only depends on where the two buffers are and which way they face,
+            // so re-use what we computed last frame unless one of them has moved
+            AudioSourceSpatialization& spatialization = listenerClientData->getSourceSpatialization(bufferToAdd);
             
-            if (bufferToAdd->getType() == PositionalAudioRingBuffer::Injector) {
-                radius = reinterpret_cast<InjectedAudioRingBuffer*>(bufferToAdd)->getRadius();
+            if (!spatialization.matches(bufferToAdd, listeningNodeBuffer, radius)) {
+                computeSpatialization(bufferToAdd, listeningNodeBuffer, radius, spatialization);
             }
             
-            if (radius == 0 || (distanceSquareToSource > radius * radius)) {
-                // this is either not a spherical source, or the listener is outside the sphere
-                
-                if (radius > 0) {
-                    // this is a spherical source - the distance used for the coefficient
-                    // needs to be the closest point on the boundary to the source
-                    
-                    // ovveride the distance to the node with the distance to the point on the
-                    // boundary of the sphere
-                    distanceSquareToSource -= (radius * radius);
-                    
-                } else {
-                    // calculate the angle delivery for off-axis attenuation
-                    glm::vec3 rotatedListenerPosition = glm::inverse(bufferToAdd->getOrientation()) * relativePosition;
-                    
-                    float angleOfDelivery = glm::angle(glm::vec3(0.0f, 0.0f, -1.0f),
-                                                       glm::normalize(rotatedListenerPosition));
-                    
-                    const float MAX_OFF_AXIS_ATTENUATION = 0.2f;
-                    const float OFF_AXIS_ATTENUATION_FORMULA_STEP = (1 - MAX_OFF_AXIS_ATTENUATION) / 2.0f;
-                    
-                    float offAxisCoefficient = MAX_OFF_AXIS_ATTENUATION +
-                        (OFF_AXIS_ATTENUATION_FORMULA_STEP * (angleOfDelivery / PI_OVER_TWO));
-                    
-                    // multiply the current attenuation coefficient by the calculated off axis coefficient
-                    attenuationCoefficient *= offAxisCoefficient;
-                }
-                
-                glm::vec3 rotatedSourcePosition = inverseOrientation * relativePosition;
-                
-                if (distanceBetween >= ATTENUATION_BEGINS_AT_DISTANCE) {
-                    // calculate the distance coefficient using the distance to this node
-                    float distanceCoefficient = 1 - (logf(distanceBetween / ATTENUATION_BEGINS_AT_DISTANCE) / logf(2.0f)
-                                                     * ATTENUATION_AMOUNT_PER_DOUBLING_IN_DISTANCE);
-                    
-                    if (distanceCoefficient < 0) {
-                        distanceCoefficient = 0;
-                    }
-                    
-                    // multiply the current attenuation coefficient by the distance coefficient
-                    attenuationCoefficient *= distanceCoefficient;
-                }
-                
-                // project the rotated source position vector onto the XZ plane
-                rotatedSourcePosition.y = 0.0f;
-                
-                // produce an oriented angle about the y-axis
-                bearingRelativeAngleToSource = glm::orientedAngle(glm::vec3(0.0f, 0.0f, -1.0f),
-                                                                  glm::normalize(rotatedSourcePosition),
-                                                                  glm::vec3(0.0f, 1.0f, 0.0f));
-                
-                const float PHASE_AMPLITUDE_RATIO_AT_90 = 0.5;
-                
-                // figure out the number of samples of delay and the ratio of the amplitude
-                // in the weak channel for audio spatialization
-                float sinRatio = fabsf(sinf(bearingRelativeAngleToSource));
-                numSamplesDelay = SAMPLE_PHASE_DELAY_AT_90 * sinRatio;
-                weakChannelAmplitudeRatio = 1 - (PHASE_AMPLITUDE_RATIO_AT_90 * sinRatio);
-            }
+            attenuationCoefficient *= spatialization.attenuationCoefficient;
+            bearingRelativeAngleToSource = spatialization.bearingRelativeAngleToSource;
+            numSamplesDelay = spatialization.numSamplesDelay;
+            weakChannelAmplitudeRatio = spatialization.weakChannelAmplitudeRatio;
         }
     }
     
-    const int16_t* nextOutputStart = bufferToAdd->getNextOutput();
+    if (!shouldAttenuate) {
+        attenuationCoefficient = 1.0f;
+    }
     
-    if (!bufferToAdd->isStereo() && shouldAttenuate) {
-        // this is a mono buffer, which means it gets full attenuation and spatialization
-        
-        // if the bearing relative angle to source is > 0 then the delayed channel is the right one
-        int delayedChannelOffset = (bearingRelativeAngleToSource > 0.0f) ? 1 : 0;
-        int goodChannelOffset = delayedChannelOffset == 0 ? 1 : 0;
-        
-        const int16_t* bufferStart = bufferToAdd->getBuffer();
-        int ringBufferSampleCapacity = bufferToAdd->getSampleCapacity();
-        
-        int16_t correctBufferSample[2], delayBufferSample[2];
-        int delayedChannelIndex = 0;
-        
-        const int SINGLE_STEREO_OFFSET = 2;
+    // work out the gain each channel should reach by the end of this frame
+    float channelGains[2] = { attenuationCoefficient, attenuationCoefficient };
+    
+    bool isSpatialized = !bufferToAdd->isStereo() && shouldAttenuate;
+    
+    // if the bearing relative angle to source is > 0 then the delayed channel is the right one
+    int delayedChannelOffset = (bearingRelativeAngleToSource > 0.0f) ? 1 : 0;
+    int goodChannelOffset = delayedChannelOffset == 0 ? 1 : 0;
+    
+    if (isSpatialized) {
+        channelGains[delayedChannelOffset] = attenuationCoefficient * weakChannelAmplitudeRatio;
+    }
+    
+    // ramp each channel from the gain it ended last frame at, so that a change in gain
+    // (or a cached gain being replaced) doesn't step in the middle of the waveform
+    float startGains[2] = { channelGains[0], channelGains[1] };
+    
+    if (bufferToAdd != listeningNodeBuffer) {
+        AudioSourceSpatialization& spatialization = listenerClientData->getSourceSpatialization(bufferToAdd);
         
-        for (int s = 0; s < NETWORK_BUFFER_LENGTH_SAMPLES_STEREO; s += 4) {
-            
-            // setup the int16_t variables for the two sample sets
-            correctBufferSample[0] = nextOutputStart[s / 2] * attenuationCoefficient;
-            correctBufferSample[1] = nextOutputStart[(s / 2) + 1] * attenuationCoefficient;
-            
-            delayedChannelIndex = s + (numSamplesDelay * 2) + delayedChannelOffset;
-            
-            delayBufferSample[0] = correctBufferSample[0] * weakChannelAmplitudeRatio;
-            delayBufferSample[1] = correctBufferSample[1] * weakChannelAmplitudeRatio;
-            
-            _clientSamples[s + goodChannelOffset] += correctBufferSample[0];
-            _clientSamples[s + goodChannelOffset + SINGLE_STEREO_OFFSET] += correctBufferSample[1];
-            _clientSamples[delayedChannelIndex] += delayBufferSample[0];
-            _clientSamples[delayedChannelIndex + SINGLE_STEREO_OFFSET] += delayBufferSample[1];
+        if (spatialization.hasMixed) {
+            startGains[0] = spatialization.lastChannelGains[0];
+            startGains[1] = spatialization.lastChannelGains[1];
         }
         
-        // The following code is pretty gross and redundant, but AFAIK it's the best way to avoid
-        // too many conditionals in handling the delay samples at the beginning of _clientSamples.
-        // Basically we try to take the samples in batches of four, and then handle the remainder
-        // conditionally to get rid of the rest.
+        spatialization.lastChannelGains[0] = channelGains[0];
+        spatialization.lastChannelGains[1] = channelGains[1];
+        spatialization.hasMixed = true;
+        spatialization.wasMixedThisFrame = true;
+    }
+    
+    float gainSteps[2] = {
+        (channelGains[0] - startGains[0]) / NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL,
+        (channelGains[1] - startGains[1]) / NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL
+    };
+    
+    const int16_t* nextOutputStart = bufferToAdd->getNextOutput();
+    
+    if (isSpatialized) {
+        // this is a mono buffer, which means it gets full attenuation and spatialization
+        float delayedStartGain = startGains[delayedChannelOffset];
+        float delayedGainStep = gainSteps[delayedChannelOffset];
         
-        const int DOUBLE_STEREO_OFFSET = 4;
-        const int TRIPLE_STEREO_OFFSET = 6;
+        // the good channel gets every sample of this frame
+        mixMonoToStereoChannel(clientSamples + goodChannelOffset, nextOutputStart,
+                               NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL,
+                               startGains[goodChannelOffset], gainSteps[goodChannelOffset]);
         
         if (numSamplesDelay > 0) {
             // if there was a sample delay for this buffer, we need to pull samples prior to the nextOutput
-            // to stick at the beginning
-            float attenuationAndWeakChannelRatio = attenuationCoefficient * weakChannelAmplitudeRatio;
+            // to stick at the beginning of the delayed channel
+            const int16_t* bufferStart = bufferToAdd->getBuffer();
             const int16_t* delayNextOutputStart = nextOutputStart - numSamplesDelay;
             if (delayNextOutputStart < bufferStart) {
-                delayNextOutputStart = bufferStart + ringBufferSampleCapacity - numSamplesDelay;
+                delayNextOutputStart = bufferStart + bufferToAdd->getSampleCapacity() - numSamplesDelay;
             }
             
-            for (int i = 0; i < numSamplesDelay; i++) {
-                int parentIndex = i * 2;
-                _clientSamples[parentIndex + delayedChannelOffset] += delayNextOutputStart[i] * attenuationAndWeakChannelRatio;
-            }
+            mixMonoToStereoChannel(clientSamples + delayedChannelOffset, delayNextOutputStart,
+                                   numSamplesDelay, delayedStartGain, delayedGainStep);
         }
+        
+        // the rest of the delayed channel is this frame shifted by the delay, what falls past the end of the frame is dropped
+        mixMonoToStereoChannel(clientSamples + (numSamplesDelay * 2) + delayedChannelOffset, nextOutputStart,
+                               NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL - numSamplesDelay,
+                               delayedStartGain + (delayedGainStep * numSamplesDelay), delayedGainStep);
     } else {
         // this is a stereo buffer or an unattenuated buffer, don't perform spatialization
-        for (int s = 0; s < NETWORK_BUFFER_LENGTH_SAMPLES_STEREO; s += 4) {
-            
-            int stereoDivider = bufferToAdd->isStereo() ? 1 : 2;
-            
-            if (!shouldAttenuate) {
-                attenuationCoefficient = 1.0f;
-            }
-            
-            _clientSamples[s] = glm::clamp(_clientSamples[s]
-                                           + (int) (nextOutputStart[(s / stereoDivider)] * attenuationCoefficient),
-                                           MIN_SAMPLE_VALUE, MAX_SAMPLE_VALUE);
-            _clientSamples[s + 1] = glm::clamp(_clientSamples[s + 1]
-                                               + (int) (nextOutputStart[(s / stereoDivider) + (1 / stereoDivider)]
-                                                        * attenuationCoefficient),
-                                               MIN_SAMPLE_VALUE, MAX_SAMPLE_VALUE);
-            _clientSamples[s + 2] = glm::clamp(_clientSamples[s + 2]
-                                               + (int) (nextOutputStart[(s / stereoDivider) + (2 / stereoDivider)]
-                                                        * attenuationCoefficient),
-                                               MIN_SAMPLE_VALUE, MAX_SAMPLE_VALUE);
-            _clientSamples[s + 3] = glm::clamp(_clientSamples[s + 3]
-                                               + (int) (nextOutputStart[(s / stereoDivider) + (3 / stereoDivider)]
-                                                        * attenuationCoefficient),
-                                               MIN_SAMPLE_VALUE, MAX_SAMPLE_VALUE);
+        // both channels end up at the same gain, so ramp from where they were on average
+        float startGain = (startGains[0] + startGains[1]) / 2.0f;
+        float gainStep = (attenuationCoefficient - startGain) / NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL;
+        
+        if (bufferToAdd->isStereo()) {
+            mixStereoToStereo(clientSamples, nextOutputStart, NETWORK_BUFFER_LENGTH_SAMPLES_STEREO, startGain, gainStep);
+        } else {
+            mixMonoToStereo(clientSamples, nextOutputStart, NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL, startGain, gainStep);
         }
     }
+    
+    return true;
 }
 
-void AudioMixer::prepareMixForListeningNode(Node* node) {
-    AvatarAudioRingBuffer* nodeRingBuffer = ((AudioMixerClientData*) node->getLinkedData())->getAvatarAudioRingBuffer();
+int AudioMixer::prepareMixForListeningNode(Node* node, float* clientSamples, QVector<AudioSource>& sources) {
+    AudioMixerClientData* listenerClientData = (AudioMixerClientData*) node->getLinkedData();
+    AvatarAudioRingBuffer* nodeRingBuffer = listenerClientData->getAvatarAudioRingBuffer();
 
     // zero out the client mix for this node
-    memset(_clientSamples, 0, NETWORK_BUFFER_LENGTH_BYTES_STEREO);
-
-    // loop through all other nodes that have sufficient audio to mix
-    foreach (const SharedNodePointer& otherNode, NodeList::getInstance()->getNodeHash()) {
-        if (otherNode->getLinkedData()) {
+    memset(clientSamples, 0, NETWORK_BUFFER_LENGTH_SAMPLES_STEREO * sizeof(float));
+    
+    int numMixes = 0;
+    
+    // only look at the sources in grid cells that could be loud enough to hear from here
+    sources.resize(0);
+    _sourceGrid.findAudibleSources(nodeRingBuffer->getPosition(), _minAudibilityThreshold, sources);
 
-            AudioMixerClientData* otherNodeClientData = (AudioMixerClientData*) otherNode->getLinkedData();
+    for (int i = 0; i < sources.size(); i++) {
+        const AudioSource& source = sources[i];
+        
+        if (*source.node != *node || source.buffer->shouldLoopbackForNode()) {
+            if (addBufferToMixForListeningNodeWithBuffer(source.buffer, nodeRingBuffer, listenerClientData, clientSamples)) {
+                ++numMixes;
+            }
+        }
+    }
+    
+    // forget the sources this listener didn't hear this frame
+    listenerClientData->removeUnmixedSourceSpatializations();
+    
+    return numMixes;
+}
 
-            // enumerate the ARBs attached to the otherNode and add all that should be added to mix
-            for (int i = 0; i < otherNodeClientData->getRingBuffers().size(); i++) {
-                PositionalAudioRingBuffer* otherNodeBuffer = otherNodeClientData->getRingBuffers()[i];
+void AudioMixer::buildSourceGrid(const NodeHash& nodeHash) {
+    _sourceGrid.clear();
+    
+    // loop through all nodes that have sufficient audio to mix
+    foreach (const SharedNodePointer& node, nodeHash) {
+        if (node->getLinkedData()) {
+            AudioMixerClientData* nodeClientData = (AudioMixerClientData*) node->getLinkedData();
+            
+            // enumerate the ARBs attached to the node and add all that will be added to a mix
+            for (int i = 0; i < nodeClientData->getRingBuffers().size(); i++) {
+                PositionalAudioRingBuffer* nodeBuffer = nodeClientData->getRingBuffers()[i];
                 
-                if ((*otherNode != *node
-                     || otherNodeBuffer->shouldLoopbackForNode())
-                    && otherNodeBuffer->willBeAddedToMix()
-                    && otherNodeBuffer->getNextOutputTrailingLoudness() > 0.0f) {
-                    addBufferToMixForListeningNodeWithBuffer(otherNodeBuffer, nodeRingBuffer);
+                if (nodeBuffer->willBeAddedToMix() && nodeBuffer->getNextOutputTrailingLoudness() > 0.0f) {
+                    _sourceGrid.addSource(node.data(), nodeBuffer);
                 }
             }
         }
     }
 }
 
+void AudioMixer::findListenerInputs(Node* node, ListenerInputs& inputs, QVector<AudioSource>& sources) {
+    AudioMixerClientData* listenerClientData = (AudioMixerClientData*) node->getLinkedData();
+    AvatarAudioRingBuffer* nodeRingBuffer = listenerClientData->getAvatarAudioRingBuffer();
+    const glm::vec3& listenerPosition = nodeRingBuffer->getPosition();
+    
+    inputs.canShareMix = true;
+    inputs.sources.resize(0);
+    
+    sources.resize(0);
+    _sourceGrid.findAudibleSources(listenerPosition, _minAudibilityThreshold, sources);
+    
+    for (int i = 0; i < sources.size(); i++) {
+        const AudioSource& source = sources[i];
+        
+        if (*source.node == *node && !source.buffer->shouldLoopbackForNode()) {
+            continue;
+        }
+        
+        if (source.buffer == nodeRingBuffer) {
+            // nobody else hears our own loopback the way we do
+            inputs.canShareMix = false;
+            break;
+        }
+        
+        // the same audibility test addBufferToMixForListeningNodeWithBuffer makes
+        float distanceBetween = glm::distance(source.buffer->getPosition(), listenerPosition);
+        if (distanceBetween < EPSILON) {
+            distanceBetween = EPSILON;
+        }
+        
+        if (source.buffer->getNextOutputTrailingLoudness() / distanceBetween <= _minAudibilityThreshold) {
+            continue;
+        }
+        
+        // a source is mixed in at full volume with no spatialization for listeners in its unattenuated zone,
+        // anything else depends on where this listener is
+        AABox* unattenuatedZone = source.buffer->getListenerUnattenuatedZone();
+        if (!unattenuatedZone || !unattenuatedZone->contains(listenerPosition)) {
+            inputs.canShareMix = false;
+            break;
+        }
+        
+        inputs.sources.append(source.buffer);
+    }
+    
+    if (inputs.canShareMix) {
+        // the spatializations kept for this listener won't be used or kept up to date while it shares a mix
+        listenerClientData->clearSourceSpatializations();
+        
+        inputs.sourcesHash = 0;
+        for (int i = 0; i < inputs.sources.size(); i++) {
+            inputs.sourcesHash = (inputs.sourcesHash * 31) + qHash(inputs.sources[i]);
+        }
+    }
+}
+
+int AudioMixer::mixSharedSources(const QVector<PositionalAudioRingBuffer*>& sources, float* clientSamples) {
+    memset(clientSamples, 0, NETWORK_BUFFER_LENGTH_SAMPLES_STEREO * sizeof(float));
+    
+    // every source here is unattenuated for the listeners sharing this mix
+    for (int i = 0; i < sources.size(); i++) {
+        PositionalAudioRingBuffer* buffer = sources[i];
+        
+        if (buffer->isStereo()) {
+            mixStereoToStereo(clientSamples, buffer->getNextOutput(), NETWORK_BUFFER_LENGTH_SAMPLES_STEREO, 1.0f);
+        } else {
+            mixMonoToStereo(clientSamples, buffer->getNextOutput(), NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL, 1.0f);
+        }
+    }
+    
+    return sources.size();
+}
+
+void AudioMixer::groupListenersWithSharedMixes() {
+    // listeners that hear exactly the same unattenuated sources (or nothing at all) get the same mix,
+    // the first of them mixes it and the rest point their mix index at that listener
+    QMultiHash<uint, int> groupLeaders;
+    
+    for (int i = 0; i < _listenerInputs.size(); i++) {
+        const ListenerInputs& inputs = _listenerInputs.at(i);
+        _listenerMixIndices[i] = i;
+        
+        if (!inputs.canShareMix) {
+            continue;
+        }
+        
+        QMultiHash<uint, int>::const_iterator leader = groupLeaders.constFind(inputs.sourcesHash);
+        while (leader != groupLeaders.constEnd() && leader.key() == inputs.sourcesHash) {
+            // the grid hands out sources in the same order to everyone, so equal inputs compare equal as lists
+            if (_listenerInputs.at(leader.value()).sources == inputs.sources) {
+                _listenerMixIndices[i] = leader.value();
+                ++_sumSharedMixListeners;
+                break;
+            }
+            ++leader;
+        }
+        
+        if (_listenerMixIndices[i] == i) {
+            groupLeaders.insert(inputs.sourcesHash, i);
+        }
+    }
+}
+
+void AudioMixer::runMixerJobs(FramePhase phase, const QVector<SharedNodePointer>& listeners) {
+    // give each job an equal slice of the listeners, we don't use more jobs than we have listeners
+    int numJobs = std::max(1, std::min(_mixerJobs.size(), listeners.size()));
+    int listenersPerJob = (listeners.size() + numJobs - 1) / numJobs;
+    
+    for (int i = 0; i < numJobs; i++) {
+        int begin = std::min(i * listenersPerJob, listeners.size());
+        int end = std::min(begin + listenersPerJob, listeners.size());
+        _mixerJobs[i]->setSlice(phase, &listeners, begin, end, _listenerInputs.data(), _listenerMixIndices.constData(),
+                                _listenerMixes.data());
+        
+        if (i > 0) {
+            _mixerThreadPool.start(_mixerJobs[i]);
+        }
+    }
+    
+    // the first slice is always handled on this thread, while the pool handles the rest
+    _mixerJobs[0]->run();
+    
+    // wait for every job to finish this phase before we move on
+    _finishedMixerJobs.acquire(numJobs);
+    
+    for (int i = 0; i < numJobs; i++) {
+        _sumMixes += _mixerJobs[i]->takeNumMixes();
+    }
+}
+
+void AudioMixer::mixListeners(const QVector<SharedNodePointer>& listeners) {
+    _listenerMixes.resize(listeners.size() * NETWORK_BUFFER_LENGTH_SAMPLES_STEREO);
+    _listenerInputs.resize(listeners.size());
+    _listenerMixIndices.resize(listeners.size());
+    
+    runMixerJobs(FindListenerInputs, listeners);
+    groupListenersWithSharedMixes();
+    runMixerJobs(MixListeners, listeners);
+}
+
+void AudioMixer::setupMixerJobs(int numMixerThreads) {
+    if (numMixerThreads < 1) {
+        numMixerThreads = 1;
+    }
+    
+    for (int i = 0; i < numMixerThreads; i++) {
+        _mixerJobs.append(new AudioMixerJob(this));
+    }
+    
+    // the mixer thread mixes one slice itself, so the pool only needs threads for the others
+    // and we keep those threads around for the life of the mixer instead of respawning them each frame
+    _mixerThreadPool.setMaxThreadCount(std::max(1, numMixerThreads - 1));
+    _mixerThreadPool.setExpiryTimeout(-1);
+}
+
 
 void AudioMixer::readPendingDatagrams() {
     QByteArray receivedPacket;
@@ -323,30 +607,39 @@ void AudioMixer::readPendingDatagrams() {
     
     while (readAvailableDatagram(receivedPacket, senderSockAddr)) {
         if (nodeList->packetVersionAndHashMatch(receivedPacket)) {
-            // pull any new audio data from nodes off of the network stack
-            PacketType mixerPacketType = packetTypeForPacket(receivedPacket);
-            if (mixerPacketType == PacketTypeMicrophoneAudioNoEcho
-                || mixerPacketType == PacketTypeMicrophoneAudioWithEcho
-                || mixerPacketType == PacketTypeInjectAudio
-                || mixerPacketType == PacketTypeSilentAudioFrame
-                || mixerPacketType == PacketTypeAudioStreamStats) {
-                
-                nodeList->findNodeAndUpdateWithDataFromPacket(receivedPacket);
-            } else if (mixerPacketType == PacketTypeMuteEnvironment) {
-                QByteArray packet = receivedPacket;
-                populatePacketHeader(packet, PacketTypeMuteEnvironment);
-                
-                foreach (const SharedNodePointer& node, nodeList->getNodeHash()) {
-                    if (node->getType() == NodeType::Agent && node->getActiveSocket() && node->getLinkedData() && node != nodeList->sendingNodeForPacket(receivedPacket)) {
-                        nodeList->writeDatagram(packet, packet.size(), node);
-                    }
-                }
+            processDatagram(receivedPacket, senderSockAddr);
+        }
+    }
+}
 
-            } else {
-                // let processNodeData handle it.
-                nodeList->processNodeData(senderSockAddr, receivedPacket);
+void AudioMixer::processDatagram(const QByteArray& receivedPacket, const HifiSockAddr& senderSockAddr) {
+    NodeList* nodeList = NodeList::getInstance();
+    
+    // pull any new audio data from nodes off of the network stack
+    PacketType mixerPacketType = packetTypeForPacket(receivedPacket);
+    if (mixerPacketType == PacketTypeMicrophoneAudioNoEcho
+        || mixerPacketType == PacketTypeMicrophoneAudioWithEcho
+        || mixerPacketType == PacketTypeInjectAudio
+        || mixerPacketType == PacketTypeSilentAudioFrame
+        || mixerPacketType == PacketTypeAudioStreamStats) {
+        
+        nodeList->findNodeAndUpdateWithDataFromPacket(receivedPacket);
+    } else if (mixerPacketType == PacketTypeMuteEnvironment) {
+        QByteArray packet = receivedPacket;
+        populatePacketHeader(packet, PacketTypeMuteEnvironment);
+        
+        SharedNodePointer sendingNode = nodeList->sendingNodeForPacket(receivedPacket);
+        NodeHashSnapshotPointer nodeHashSnapshot = nodeList->getNodeHashSnapshot();
+        
+        foreach (const SharedNodePointer& node, nodeHashSnapshot->nodesOfType(NodeType::Agent)) {
+            if (node->getActiveSocket() && node->getLinkedData() && node != sendingNode) {
+                nodeList->writeDatagram(packet, packet.size(), node);
             }
         }
+
+    } else {
+        // let processNodeData handle it.
+        nodeList->processNodeData(senderSockAddr, receivedPacket);
     }
 }
 
@@ -354,6 +647,8 @@ void AudioMixer::sendStatsPacket() {
     static QJsonObject statsObject;
     statsObject["trailing_sleep_percentage"] = _trailingSleepRatio * 100.0f;
     statsObject["performance_throttling_ratio"] = _performanceThrottlingRatio;
+    statsObject["mixer_threads"] = _mixerJobs.size();
+    statsObject["receive_threads"] = _datagramReceiver.getNumThreads();
 
     statsObject["average_listeners_per_frame"] = (float) _sumListeners / (float) _numStatFrames;
     
@@ -362,10 +657,13 @@ void AudioMixer::sendStatsPacket() {
     } else {
         statsObject["average_mixes_per_listener"] = 0.0;
     }
+    
+    statsObject["average_shared_mix_listeners_per_frame"] = (float) _sumSharedMixListeners / (float) _numStatFrames;
 
     ThreadedAssignment::addPacketStatsAndSendStatsPacket(statsObject);
     _sumListeners = 0;
     _sumMixes = 0;
+    _sumSharedMixListeners = 0;
     _numStatFrames = 0;
 
 
@@ -453,6 +751,9 @@ void AudioMixer::run() {
     // check the settings object to see if we have anything we can parse out
     const QString AUDIO_GROUP_KEY = "audio";
     
+    int numMixerThreads = 1;
+    int numReceiveThreads = 0;
+    
     if (settingsObject.contains(AUDIO_GROUP_KEY)) {
         QJsonObject audioGroupObject = settingsObject[AUDIO_GROUP_KEY].toObject();
         
@@ -489,6 +790,25 @@ void AudioMixer::run() {
         } else {
             qDebug() << "Dynamic jitter buffers disabled, using old behavior.";
         }
+        
+        // check the payload to see if we have been asked to mix listeners on more than one thread
+        const QString MIXER_THREADS_JSON_KEY = "mixer-threads";
+        numMixerThreads = audioGroupObject[MIXER_THREADS_JSON_KEY].toVariant().toInt();
+        
+        // and whether we should read datagrams on threads of their own instead of between frames
+        const QString RECEIVE_THREADS_JSON_KEY = "receive-threads";
+        numReceiveThreads = audioGroupObject[RECEIVE_THREADS_JSON_KEY].toVariant().toInt();
+    }
+    
+    if (numMixerThreads < 1) {
+        numMixerThreads = 1;
+    }
+    
+    qDebug() << "Mixing listeners on" << numMixerThreads << "thread(s).";
+    setupMixerJobs(numMixerThreads);
+    
+    if (numReceiveThreads > 0 && !startReceiveThreads(numReceiveThreads)) {
+        qDebug() << "Receive threads aren't available here, reading datagrams between frames.";
     }
     
     int nextFrame = 0;
@@ -505,7 +825,16 @@ void AudioMixer::run() {
 
     while (!_isFinished) {
         
-        foreach (const SharedNodePointer& node, nodeList->getNodeHash()) {
+        if (_datagramReceiver.isRunning()) {
+            // take in everything the receive threads read while we slept, so it makes this frame's mix
+            processReceivedDatagrams();
+        }
+        
+        // grab one snapshot of the node hash for the whole frame
+        NodeHashSnapshotPointer nodeHashSnapshot = nodeList->getNodeHashSnapshot();
+        const NodeHash& nodeHash = nodeHashSnapshot->getNodeHash();
+        
+        foreach (const SharedNodePointer& node, nodeHash) {
             if (node->getLinkedData()) {
                 ((AudioMixerClientData*) node->getLinkedData())->checkBuffersBeforeFrameSend(_sourceUnattenuatedZone,
                                                                                              _listenerUnattenuatedZone);
@@ -571,42 +900,65 @@ void AudioMixer::run() {
             sendAudioStreamStats = true;
         }
 
-        foreach (const SharedNodePointer& node, nodeList->getNodeHash()) {
-            if (node->getType() == NodeType::Agent && node->getActiveSocket() && node->getLinkedData()
+        // index this frame's sources by position, the mixer jobs share the grid to find what each listener can hear
+        buildSourceGrid(nodeHash);
+        
+        QVector<SharedNodePointer> listeners;
+        foreach (const SharedNodePointer& node, nodeHashSnapshot->nodesOfType(NodeType::Agent)) {
+            if (node->getActiveSocket() && node->getLinkedData()
                 && ((AudioMixerClientData*) node->getLinkedData())->getAvatarAudioRingBuffer()) {
-
-                AudioMixerClientData* nodeData = (AudioMixerClientData*)node->getLinkedData();
-
-                prepareMixForListeningNode(node.data());
-                
-                // pack header
-                int numBytesPacketHeader = populatePacketHeader(clientMixBuffer, PacketTypeMixedAudio);
-                char* dataAt = clientMixBuffer + numBytesPacketHeader;
-
-                // pack sequence number
-                quint16 sequence = nodeData->getOutgoingSequenceNumber();
-                memcpy(dataAt, &sequence, sizeof(quint16));
-                dataAt += sizeof(quint16);
-
-                // pack mixed audio samples
-                memcpy(dataAt, _clientSamples, NETWORK_BUFFER_LENGTH_BYTES_STEREO);
-                dataAt += NETWORK_BUFFER_LENGTH_BYTES_STEREO;
-
-                // send mixed audio packet
-                nodeList->writeDatagram(clientMixBuffer, dataAt - clientMixBuffer, node);
-                nodeData->incrementOutgoingMixedAudioSequenceNumber();
-                
-                // send an audio stream stats packet if it's time
-                if (sendAudioStreamStats) {
-                    nodeData->sendAudioStreamStatsPackets(node);
-                }
-
-                ++_sumListeners;
+                listeners.append(node);
             }
         }
         
+        mixListeners(listeners);
+        
+        // send the listeners that share a mix one after the other, so that their mix is only clamped once
+        // and each of them after the first only needs a new sequence number
+        QVector<QPair<int, int> > sendOrder(listeners.size());
+        for (int i = 0; i < listeners.size(); i++) {
+            sendOrder[i] = qMakePair(_listenerMixIndices[i], i);
+        }
+        qSort(sendOrder);
+        
+        int numBytesPacketHeader = populatePacketHeader(clientMixBuffer, PacketTypeMixedAudio);
+        char* sequenceAt = clientMixBuffer + numBytesPacketHeader;
+        char* samplesAt = sequenceAt + sizeof(quint16);
+        int packetSize = numBytesPacketHeader + sizeof(quint16) + NETWORK_BUFFER_LENGTH_BYTES_STEREO;
+        int packedMixIndex = -1;
+        
+        for (int i = 0; i < sendOrder.size(); i++) {
+            int mixIndex = sendOrder[i].first;
+            const SharedNodePointer& node = listeners[sendOrder[i].second];
+            AudioMixerClientData* nodeData = (AudioMixerClientData*)node->getLinkedData();
+            
+            // pack sequence number
+            quint16 sequence = nodeData->getOutgoingSequenceNumber();
+            memcpy(sequenceAt, &sequence, sizeof(quint16));
+            
+            if (mixIndex != packedMixIndex) {
+                // pack mixed audio samples, this is the only place the mix is clamped to the sample range
+                clampMixToSamples(_listenerMixes.constData() + (mixIndex * NETWORK_BUFFER_LENGTH_SAMPLES_STEREO),
+                                  reinterpret_cast<int16_t*>(samplesAt), NETWORK_BUFFER_LENGTH_SAMPLES_STEREO);
+                packedMixIndex = mixIndex;
+            }
+            
+            // queue the mixed audio packet, the whole frame goes out together once every listener is packed
+            nodeList->queueDatagram(_datagramBatch, clientMixBuffer, packetSize, node);
+            nodeData->incrementOutgoingMixedAudioSequenceNumber();
+            
+            // send an audio stream stats packet if it's time
+            if (sendAudioStreamStats) {
+                nodeData->sendAudioStreamStatsPackets(node);
+            }
+
+            ++_sumListeners;
+        }
+        
+        nodeList->flushDatagramBatch(_datagramBatch);
+        
         // push forward the next output pointers for any audio buffers we used
-        foreach (const SharedNodePointer& node, nodeList->getNodeHash()) {
+        foreach (const SharedNodePointer& node, nodeHash) {
             if (node->getLinkedData()) {
                 ((AudioMixerClientData*) node->getLinkedData())->pushBuffersAfterFrameSend();
             }
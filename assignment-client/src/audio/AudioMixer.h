@@ -12,12 +12,21 @@
 #ifndef hifi_AudioMixer_h
 #define hifi_AudioMixer_h
 
+#include <QtCore/QSemaphore>
+#include <QtCore/QThreadPool>
+
 #include <AABox.h>
 #include <AudioRingBuffer.h>
+#include <LimitedNodeList.h>
 #include <ThreadedAssignment.h>
 
+#include "AudioSourceGrid.h"
+
 class PositionalAudioRingBuffer;
 class AvatarAudioRingBuffer;
+class AudioMixerClientData;
+class AudioMixerJob;
+class AudioSourceSpatialization;
 
 const int SAMPLE_PHASE_DELAY_AT_90 = 20;
 
@@ -29,6 +38,8 @@ class AudioMixer : public ThreadedAssignment {
 public:
     AudioMixer(const QByteArray& packet);
     ~AudioMixer();
+    
+    void processDatagram(const QByteArray& receivedPacket, const HifiSockAddr& senderSockAddr);
 public slots:
     /// threaded run of assignment
     void run();
@@ -40,16 +51,74 @@ public slots:
     static bool getUseDynamicJitterBuffers() { return _useDynamicJitterBuffers; }
 
 private:
-    /// adds one buffer to the mix for a listening node
-    void addBufferToMixForListeningNodeWithBuffer(PositionalAudioRingBuffer* bufferToAdd,
-                                                  AvatarAudioRingBuffer* listeningNodeBuffer);
+    friend class AudioMixerJob;
+    
+    /// what a listener hears this frame, if every source it hears is unattenuated for it then its mix is
+    /// the same as that of any other listener that hears exactly the same sources
+    class ListenerInputs {
+    public:
+        ListenerInputs() : canShareMix(false), sources(), sourcesHash(0) { }
+        
+        bool canShareMix;
+        QVector<PositionalAudioRingBuffer*> sources;
+        uint sourcesHash;
+    };
+    
+    /// the mixer jobs run twice a frame, once to find what each listener hears and once to mix
+    enum FramePhase {
+        FindListenerInputs,
+        MixListeners
+    };
+    
+    /// computes the distance attenuation, off-axis attenuation and phase delay of a source for a listener
+    void computeSpatialization(PositionalAudioRingBuffer* bufferToAdd, AvatarAudioRingBuffer* listeningNodeBuffer,
+                               float radius, AudioSourceSpatialization& spatialization);
+    
+    /// adds one buffer to the passed mix for a listening node, returns true if the buffer was mixed in
+    bool addBufferToMixForListeningNodeWithBuffer(PositionalAudioRingBuffer* bufferToAdd,
+                                                  AvatarAudioRingBuffer* listeningNodeBuffer,
+                                                  AudioMixerClientData* listenerClientData,
+                                                  float* clientSamples);
+    
+    /// prepares the mix for one Node into the passed client samples, returns the number of buffers mixed
+    /// sources is scratch space for the sources that might be audible to the node, so callers can re-use it
+    int prepareMixForListeningNode(Node* node, float* clientSamples, QVector<AudioSource>& sources);
+    
+    /// adds every buffer that will be mixed this frame to _sourceGrid
+    void buildSourceGrid(const NodeHash& nodeHash);
+    
+    /// works out whether a listener can share its mix, and if so which sources go into it
+    void findListenerInputs(Node* node, ListenerInputs& inputs, QVector<AudioSource>& sources);
+    
+    /// mixes unattenuated sources into a mix shared by several listeners, returns the number of buffers mixed
+    int mixSharedSources(const QVector<PositionalAudioRingBuffer*>& sources, float* clientSamples);
+    
+    /// points the mix index of every listener that can share a mix at the first listener with the same inputs
+    void groupListenersWithSharedMixes();
+    
+    /// runs one phase of the frame for every listener, spreading the listeners across the mixer jobs
+    void runMixerJobs(FramePhase phase, const QVector<SharedNodePointer>& listeners);
+    
+    /// mixes every listener for this frame into _listenerMixes, listeners with the same inputs share a single mix
+    void mixListeners(const QVector<SharedNodePointer>& listeners);
+    
+    /// sets up the jobs (and the thread pool that runs them) used to mix listeners in parallel
+    void setupMixerJobs(int numMixerThreads);
+    
+    QList<AudioMixerJob*> _mixerJobs;
+    QThreadPool _mixerThreadPool;
+    QSemaphore _finishedMixerJobs;
+    
+    AudioSourceGrid _sourceGrid;
     
-    /// prepares and sends a mix to one Node
-    void prepareMixForListeningNode(Node* node);
+    // the unclamped mix of each listener this frame, NETWORK_BUFFER_LENGTH_SAMPLES_STEREO samples per listener
+    // a listener that shares its mix uses the mix of the listener at its index in _listenerMixIndices
+    QVector<float> _listenerMixes;
+    QVector<ListenerInputs> _listenerInputs;
+    QVector<int> _listenerMixIndices;
     
-    // client samples capacity is larger than what will be sent to optimize mixing
-    // we are MMX adding 4 samples at a time so we need client samples to have an extra 4
-    int16_t _clientSamples[NETWORK_BUFFER_LENGTH_SAMPLES_STEREO + (SAMPLE_PHASE_DELAY_AT_90 * 2)];
+    // the mixed audio packets for this frame, sent together after every listener has been packed
+    DatagramBatch _datagramBatch;
     
     float _trailingSleepRatio;
     float _minAudibilityThreshold;
@@ -57,6 +126,7 @@ private:
     int _numStatFrames;
     int _sumListeners;
     int _sumMixes;
+    int _sumSharedMixListeners;
     AABox* _sourceUnattenuatedZone;
     AABox* _listenerUnattenuatedZone;
     static bool _useDynamicJitterBuffers;
@@ -23,10 +23,63 @@
 const int INCOMING_SEQ_STATS_HISTORY_LENGTH = INCOMING_SEQ_STATS_HISTORY_LENGTH_SECONDS /
     (TOO_LONG_SINCE_LAST_SEND_AUDIO_STREAM_STATS / USECS_PER_SECOND);
 
+// a source or listener has to move at least this far (in meters) before the spatialization between them is recomputed
+const float SPATIALIZATION_POSITION_EPSILON = 0.01f;
+
+// or turn far enough that the dot product of its orientations drops below this, which is roughly half a degree
+const float SPATIALIZATION_ORIENTATION_EPSILON = 0.99999f;
+
+static bool positionMatches(const glm::vec3& position, const glm::vec3& otherPosition) {
+    glm::vec3 difference = position - otherPosition;
+    return glm::dot(difference, difference) < SPATIALIZATION_POSITION_EPSILON * SPATIALIZATION_POSITION_EPSILON;
+}
+
+static bool orientationMatches(const glm::quat& orientation, const glm::quat& otherOrientation) {
+    // q and -q are the same rotation
+    return fabsf(glm::dot(orientation, otherOrientation)) > SPATIALIZATION_ORIENTATION_EPSILON;
+}
+
+AudioSourceSpatialization::AudioSourceSpatialization() :
+    sourcePosition(),
+    sourceOrientation(),
+    listenerPosition(),
+    listenerOrientation(),
+    sourceRadius(0.0f),
+    isComputed(false),
+    attenuationCoefficient(1.0f),
+    bearingRelativeAngleToSource(0.0f),
+    numSamplesDelay(0),
+    weakChannelAmplitudeRatio(1.0f),
+    hasMixed(false),
+    wasMixedThisFrame(false)
+{
+    lastChannelGains[0] = lastChannelGains[1] = 0.0f;
+}
+
+bool AudioSourceSpatialization::matches(const PositionalAudioRingBuffer* source,
+                                        const PositionalAudioRingBuffer* listener, float radius) const {
+    return isComputed && radius == sourceRadius
+        && positionMatches(source->getPosition(), sourcePosition)
+        && positionMatches(listener->getPosition(), listenerPosition)
+        && orientationMatches(source->getOrientation(), sourceOrientation)
+        && orientationMatches(listener->getOrientation(), listenerOrientation);
+}
+
+void AudioSourceSpatialization::setComputedFor(const PositionalAudioRingBuffer* source,
+                                               const PositionalAudioRingBuffer* listener, float radius) {
+    sourcePosition = source->getPosition();
+    sourceOrientation = source->getOrientation();
+    listenerPosition = listener->getPosition();
+    listenerOrientation = listener->getOrientation();
+    sourceRadius = radius;
+    isComputed = true;
+}
+
 AudioMixerClientData::AudioMixerClientData() :
     _ringBuffers(),
     _outgoingMixedAudioSequenceNumber(0),
-    _incomingAvatarAudioSequenceNumberStats(INCOMING_SEQ_STATS_HISTORY_LENGTH)
+    _incomingAvatarAudioSequenceNumberStats(INCOMING_SEQ_STATS_HISTORY_LENGTH),
+    _sourceSpatializations()
 {
     
 }
@@ -49,6 +102,18 @@ AvatarAudioRingBuffer* AudioMixerClientData::getAvatarAudioRingBuffer() const {
     return NULL;
 }
 
+void AudioMixerClientData::removeUnmixedSourceSpatializations() {
+    AudioSourceSpatializationHash::iterator spatialization = _sourceSpatializations.begin();
+    while (spatialization != _sourceSpatializations.end()) {
+        if (spatialization.value().wasMixedThisFrame) {
+            spatialization.value().wasMixedThisFrame = false;
+            ++spatialization;
+        } else {
+            spatialization = _sourceSpatializations.erase(spatialization);
+        }
+    }
+}
+
 int AudioMixerClientData::parseData(const QByteArray& packet) {
 
     // parse sequence number for this packet
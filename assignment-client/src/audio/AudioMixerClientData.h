@@ -12,6 +12,11 @@
 #ifndef hifi_AudioMixerClientData_h
 #define hifi_AudioMixerClientData_h
 
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+#include <QtCore/QHash>
+
 #include <AABox.h>
 #include <NodeData.h>
 #include <PositionalAudioRingBuffer.h>
@@ -23,6 +28,40 @@
 
 const int INCOMING_SEQ_STATS_HISTORY_LENGTH_SECONDS = 30;
 
+/// The spatialization of one source for one listener, kept from frame to frame so it is only recomputed when one of
+/// them has moved, along with the gains the source was last mixed at so a change in gain can be ramped over a frame.
+class AudioSourceSpatialization {
+public:
+    AudioSourceSpatialization();
+
+    /// true if the source and listener are close enough to where they were when this was computed to re-use it
+    bool matches(const PositionalAudioRingBuffer* source, const PositionalAudioRingBuffer* listener, float radius) const;
+    void setComputedFor(const PositionalAudioRingBuffer* source, const PositionalAudioRingBuffer* listener, float radius);
+
+    // what the spatialization was computed for
+    glm::vec3 sourcePosition;
+    glm::quat sourceOrientation;
+    glm::vec3 listenerPosition;
+    glm::quat listenerOrientation;
+    float sourceRadius;
+    bool isComputed;
+
+    // the distance and off-axis attenuation, not including any attenuation ratio of an injector
+    float attenuationCoefficient;
+    float bearingRelativeAngleToSource;
+    int numSamplesDelay;
+    float weakChannelAmplitudeRatio;
+
+    // the gain each channel ended the last frame at, only valid if hasMixed
+    float lastChannelGains[2];
+    bool hasMixed;
+
+    // set every frame the source is mixed for this listener, entries left unset are dropped after the mix
+    bool wasMixedThisFrame;
+};
+
+typedef QHash<const PositionalAudioRingBuffer*, AudioSourceSpatialization> AudioSourceSpatializationHash;
+
 class AudioMixerClientData : public NodeData {
 public:
     AudioMixerClientData();
@@ -43,6 +82,15 @@ public:
     void incrementOutgoingMixedAudioSequenceNumber() { _outgoingMixedAudioSequenceNumber++; }
     quint16 getOutgoingSequenceNumber() const { return _outgoingMixedAudioSequenceNumber; }
 
+    /// the cached spatialization of sourceBuffer for this listener, only touched by the job mixing this listener
+    AudioSourceSpatialization& getSourceSpatialization(const PositionalAudioRingBuffer* sourceBuffer)
+        { return _sourceSpatializations[sourceBuffer]; }
+
+    /// drops the spatialization of every source that wasn't mixed for this listener since the last call, so a source
+    /// that comes back (or a new buffer at the same address) starts over
+    void removeUnmixedSourceSpatializations();
+    void clearSourceSpatializations() { _sourceSpatializations.clear(); }
+
 private:
     QList<PositionalAudioRingBuffer*> _ringBuffers;
 
@@ -51,6 +99,8 @@ private:
     QHash<QUuid, SequenceNumberStats> _incomingInjectedAudioSequenceNumberStatsMap;
 
     AudioStreamStats _downstreamAudioStreamStats;
+
+    AudioSourceSpatializationHash _sourceSpatializations;
 };
 
 #endif // hifi_AudioMixerClientData_h
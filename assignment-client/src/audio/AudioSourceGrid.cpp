@@ -0,0 +1,89 @@
+//
+//  AudioSourceGrid.cpp
+//  assignment-client/src/audio
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <algorithm>
+#include <math.h>
+
+#include "AudioSourceGrid.h"
+
+AudioSourceGrid::AudioSourceGrid(float cellSize) :
+    _cellSize(cellSize),
+    _numSources(0),
+    _cells(),
+    _cellIndices()
+{
+
+}
+
+void AudioSourceGrid::clear() {
+    _numSources = 0;
+    _cells.clear();
+    _cellIndices.clear();
+}
+
+quint64 AudioSourceGrid::keyForPosition(const glm::vec3& position) const {
+    // pack the 21 low bits of each cell coordinate into the key, that covers far more of the world than we'll ever mix
+    const quint64 CELL_COORDINATE_MASK = 0x1FFFFF;
+    const int CELL_COORDINATE_BITS = 21;
+
+    quint64 x = (qint64) floorf(position.x / _cellSize) & CELL_COORDINATE_MASK;
+    quint64 y = (qint64) floorf(position.y / _cellSize) & CELL_COORDINATE_MASK;
+    quint64 z = (qint64) floorf(position.z / _cellSize) & CELL_COORDINATE_MASK;
+
+    return (x << (CELL_COORDINATE_BITS * 2)) | (y << CELL_COORDINATE_BITS) | z;
+}
+
+void AudioSourceGrid::addSource(const Node* node, PositionalAudioRingBuffer* buffer) {
+    const glm::vec3& position = buffer->getPosition();
+    float loudness = buffer->getNextOutputTrailingLoudness();
+
+    quint64 key = keyForPosition(position);
+    QHash<quint64, int>::const_iterator cellIndex = _cellIndices.constFind(key);
+
+    if (cellIndex == _cellIndices.constEnd()) {
+        // first source in this cell, the cell's bounds start out as just this source
+        Cell newCell;
+        newCell.minimum = position;
+        newCell.maximum = position;
+        newCell.maxLoudness = loudness;
+        newCell.sources.append(AudioSource(node, buffer));
+
+        _cellIndices.insert(key, _cells.size());
+        _cells.append(newCell);
+    } else {
+        // keep the bounds tight around the sources, so the cell can be culled from further away
+        Cell& cell = _cells[cellIndex.value()];
+        cell.minimum = glm::min(cell.minimum, position);
+        cell.maximum = glm::max(cell.maximum, position);
+        cell.maxLoudness = std::max(cell.maxLoudness, loudness);
+        cell.sources.append(AudioSource(node, buffer));
+    }
+
+    ++_numSources;
+}
+
+void AudioSourceGrid::findAudibleSources(const glm::vec3& position, float minAudibilityThreshold,
+                                         QVector<AudioSource>& sources) const {
+    for (int i = 0; i < _cells.size(); i++) {
+        const Cell& cell = _cells[i];
+
+        // the closest any source in this cell can be to the listener
+        glm::vec3 closestPoint = glm::clamp(position, cell.minimum, cell.maximum);
+        float distanceToCell = glm::distance(position, closestPoint);
+
+        // this is the test AudioMixer::addBufferToMixForListeningNodeWithBuffer makes, done with the loudest source and
+        // the shortest distance - if it fails here it fails for every source in the cell
+        if (cell.maxLoudness <= minAudibilityThreshold * distanceToCell) {
+            continue;
+        }
+
+        sources += cell.sources;
+    }
+}
@@ -0,0 +1,67 @@
+//
+//  AudioSourceGrid.h
+//  assignment-client/src/audio
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_AudioSourceGrid_h
+#define hifi_AudioSourceGrid_h
+
+#include <glm/glm.hpp>
+
+#include <QtCore/QHash>
+#include <QtCore/QVector>
+
+#include <Node.h>
+#include <PositionalAudioRingBuffer.h>
+
+const float DEFAULT_AUDIO_SOURCE_GRID_CELL_SIZE = 25.0f; // meters
+
+/// a ring buffer that will be added to the mix this frame, along with the node it belongs to
+class AudioSource {
+public:
+    AudioSource() : node(NULL), buffer(NULL) { }
+    AudioSource(const Node* node, PositionalAudioRingBuffer* buffer) : node(node), buffer(buffer) { }
+
+    const Node* node;
+    PositionalAudioRingBuffer* buffer;
+};
+
+/// A uniform grid of the audio sources for one frame. Each cell remembers the loudest source in it, so a listener can skip
+/// every cell that is too far away for even its loudest source to pass the mixer's audibility threshold.
+class AudioSourceGrid {
+public:
+    AudioSourceGrid(float cellSize = DEFAULT_AUDIO_SOURCE_GRID_CELL_SIZE);
+
+    void clear();
+    void addSource(const Node* node, PositionalAudioRingBuffer* buffer);
+
+    /// appends every source that could be loud enough to be heard at position, the sources still need the exact
+    /// per listener audibility check
+    void findAudibleSources(const glm::vec3& position, float minAudibilityThreshold, QVector<AudioSource>& sources) const;
+
+    int getNumSources() const { return _numSources; }
+    int getNumCells() const { return _cells.size(); }
+
+private:
+    class Cell {
+    public:
+        glm::vec3 minimum;
+        glm::vec3 maximum;
+        float maxLoudness;
+        QVector<AudioSource> sources;
+    };
+
+    quint64 keyForPosition(const glm::vec3& position) const;
+
+    float _cellSize;
+    int _numSources;
+    QVector<Cell> _cells;
+    QHash<quint64, int> _cellIndices;
+};
+
+#endif // hifi_AudioSourceGrid_h
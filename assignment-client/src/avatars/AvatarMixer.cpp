@@ -9,14 +9,27 @@
 //  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
 //
 
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
 #include <QtCore/QCoreApplication>
 #include <QtCore/QDateTime>
+#include <QtCore/QEventLoop>
+#include <QtCore/QJsonDocument>
 #include <QtCore/QJsonObject>
+#include <QtCore/QRunnable>
+#include <QtCore/QtAlgorithms>
 #include <QtCore/QTimer>
 #include <QtCore/QThread>
+#include <QtNetwork/QNetworkReply>
+#include <QtNetwork/QNetworkRequest>
 
+#include <AvatarDataDelta.h>
 #include <Logging.h>
+#include <NetworkAccessManager.h>
 #include <NodeList.h>
+#include <OctreeConstants.h>
 #include <PacketHeaders.h>
 #include <SharedUtil.h>
 #include <UUID.h>
@@ -32,13 +45,17 @@ const unsigned int AVATAR_DATA_SEND_INTERVAL_MSECS = (1.0f / 60.0f) * 1000;
 AvatarMixer::AvatarMixer(const QByteArray& packet) :
     ThreadedAssignment(packet),
     _broadcastThread(),
+    _frameTimestamp(0),
     _lastFrameTimestamp(QDateTime::currentMSecsSinceEpoch()),
     _trailingSleepRatio(1.0f),
     _performanceThrottlingRatio(0.0f),
     _sumListeners(0),
     _numStatFrames(0),
     _sumBillboardPackets(0),
-    _sumIdentityPackets(0)
+    _sumIdentityPackets(0),
+    _sumContendedAvatars(0),
+    _sumSkippedAvatarUpdates(0),
+    _sumOverBudgetAvatarUpdates(0)
 {
     // make sure we hear about node kills so we can tell the other nodes
     connect(NodeList::getInstance(), &NodeList::nodeKilled, this, &AvatarMixer::nodeKilled);
@@ -47,6 +64,9 @@ AvatarMixer::AvatarMixer(const QByteArray& packet) :
 AvatarMixer::~AvatarMixer() {
     _broadcastThread.quit();
     _broadcastThread.wait();
+    
+    _broadcastThreadPool.waitForDone();
+    qDeleteAll(_broadcastJobs);
 }
 
 void attachAvatarDataToNode(Node* newNode) {
@@ -55,11 +75,339 @@ void attachAvatarDataToNode(Node* newNode) {
     }
 }
 
-const float BILLBOARD_AND_IDENTITY_SEND_PROBABILITY = 1.0f / 300.0f;
+// besides whenever they change, each listener is sent every avatar's billboard and identity again about this often, in
+// case the first ones were lost - at most one avatar's per listener per frame, so they trickle out rather than bunch up
+const quint64 BILLBOARD_AND_IDENTITY_RESEND_INTERVAL_MSECS = 5000;
+
+// the most avatar data we'll put in a listener's bulk packets in one frame, the highest priority avatars go in first
+const int MAX_AVATAR_BYTES_PER_LISTENER_PER_FRAME = 4 * MAX_PACKET_SIZE;
+
+// avatars closer than this are weighted to go out every frame, beyond it the weight falls off with distance
+const float FULL_RATE_DISTANCE = 2.0f;
+
+// how much an avatar right behind the listener and one standing still are weighted, relative to one that is
+// straight ahead or moving at FULL_WEIGHT_SPEED or faster
+const float BEHIND_LISTENER_WEIGHT = 0.5f;
+const float STILL_AVATAR_WEIGHT = 0.5f;
+const float FULL_WEIGHT_SPEED = 1.0f; // meters per second
+
+// added to how long an avatar has waited to be sent, to absorb the jitter in when frames start
+const quint64 HALF_FRAME_MSECS = AVATAR_DATA_SEND_INTERVAL_MSECS / 2;
+
+// avatars outside a listener's view frustum (and its keyhole) are only sent this often, which is well inside the time
+// the client waits before it decides an avatar is gone
+const quint64 OUT_OF_VIEW_HEARTBEAT_INTERVAL_MSECS = 1000;
+const float OUT_OF_VIEW_WEIGHT = (float) AVATAR_DATA_SEND_INTERVAL_MSECS / OUT_OF_VIEW_HEARTBEAT_INTERVAL_MSECS;
+
+// roughly the sphere an avatar fills, for checking it against view frustums
+const float AVATAR_BOUNDING_RADIUS = 1.5f;
+
+// how often each listener is sent a full keyframe of each other avatar, in between it is sent deltas against the keyframe
+const quint64 AVATAR_KEYFRAME_INTERVAL_MSECS = 1000;
+
+/// Sends the frame's avatars to a contiguous slice of the frame's listeners. The jobs only read the mixer's avatar
+/// snapshots and each one queues its packets in its own batch, so several of them can run at once on the mixer's pool.
+class AvatarMixerJob : public QRunnable {
+public:
+    AvatarMixerJob(AvatarMixer* mixer);
+    
+    void setSlice(int begin, int end) { _begin = begin; _end = end; }
+    DatagramBatch& getDatagramBatch() { return _datagramBatch; }
+    
+    /// adds the counts for the last slice to the passed sums and resets them
+    void takeStats(int& sumBillboardPackets, int& sumIdentityPackets, int& sumSkippedAvatarUpdates,
+                   int& sumOverBudgetAvatarUpdates);
+    
+    void run();
+    
+private:
+    /// how quickly other should be re-sent to listener, 1.0 is every frame
+    float computeSendWeight(const AvatarMixer::AvatarSnapshot& listener, const AvatarMixer::AvatarSnapshot& other) const;
+    
+    /// writes other into _avatarRecord as a delta against the listener's keyframe if it can, otherwise as a new keyframe
+    /// returns true if it wrote a keyframe, sendState is left for the caller to update once the record is sent
+    bool writeAvatarRecord(const AvatarMixer::AvatarSnapshot& other, const AvatarSendState& sendState);
+    
+    void queueAvatarsForListener(const AvatarMixer::AvatarSnapshot& listener);
+    
+    /// queues the billboards and identities that have changed since they were last sent to listener, along with the one
+    /// that is most overdue for a resend
+    void queueBillboardsAndIdentitiesForListener(const AvatarMixer::AvatarSnapshot& listener);
+    
+    AvatarMixer* _mixer;
+    int _begin;
+    int _end;
+    QByteArray _mixedAvatarByteArray;
+    QByteArray _avatarRecord;
+    int _numPacketHeaderBytes;
+    DatagramBatch _datagramBatch;
+    QVector<QPair<float, int> > _sendPriorities;
+    int _numBillboardPackets;
+    int _numIdentityPackets;
+    int _numSkippedAvatarUpdates;
+    int _numOverBudgetAvatarUpdates;
+};
+
+AvatarMixerJob::AvatarMixerJob(AvatarMixer* mixer) :
+    _mixer(mixer),
+    _begin(0),
+    _end(0),
+    _mixedAvatarByteArray(),
+    _avatarRecord(),
+    _numPacketHeaderBytes(0),
+    _datagramBatch(),
+    _sendPriorities(),
+    _numBillboardPackets(0),
+    _numIdentityPackets(0),
+    _numSkippedAvatarUpdates(0),
+    _numOverBudgetAvatarUpdates(0)
+{
+    // jobs are re-used every frame, the mixer owns them
+    setAutoDelete(false);
+    
+    // keep a whole packet's worth of room, so resetting the packet between listeners never gives it back
+    _mixedAvatarByteArray.reserve(MAX_PACKET_SIZE);
+    _avatarRecord.reserve(MAX_PACKET_SIZE);
+}
+
+void AvatarMixerJob::takeStats(int& sumBillboardPackets, int& sumIdentityPackets, int& sumSkippedAvatarUpdates,
+                               int& sumOverBudgetAvatarUpdates) {
+    sumBillboardPackets += _numBillboardPackets;
+    sumIdentityPackets += _numIdentityPackets;
+    sumSkippedAvatarUpdates += _numSkippedAvatarUpdates;
+    sumOverBudgetAvatarUpdates += _numOverBudgetAvatarUpdates;
+    
+    _numBillboardPackets = 0;
+    _numIdentityPackets = 0;
+    _numSkippedAvatarUpdates = 0;
+    _numOverBudgetAvatarUpdates = 0;
+}
+
+void AvatarMixerJob::run() {
+    _numPacketHeaderBytes = populatePacketHeader(_mixedAvatarByteArray, PacketTypeBulkAvatarData);
+    
+    for (int i = _begin; i < _end; i++) {
+        const AvatarMixer::AvatarSnapshot& listener = _mixer->_avatarSnapshots[_mixer->_listenerIndices[i]];
+        queueAvatarsForListener(listener);
+        queueBillboardsAndIdentitiesForListener(listener);
+    }
+    
+    // let the broadcast thread know this slice is done
+    _mixer->_finishedBroadcastJobs.release();
+}
+
+float AvatarMixerJob::computeSendWeight(const AvatarMixer::AvatarSnapshot& listener,
+                                        const AvatarMixer::AvatarSnapshot& other) const {
+    // the listener can't see this avatar, so it only has to hear about it often enough to keep it around
+    if (listener.hasViewFrustum
+        && listener.viewFrustum.sphereInFrustum(other.position, AVATAR_BOUNDING_RADIUS) == ViewFrustum::OUTSIDE) {
+        return OUT_OF_VIEW_WEIGHT;
+    }
+    
+    glm::vec3 toOther = other.position - listener.position;
+    float distanceToAvatar = glm::length(toOther);
+    
+    float weight = 1.0f;
+    
+    if (distanceToAvatar > FULL_RATE_DISTANCE) {
+        weight = FULL_RATE_DISTANCE / distanceToAvatar;
+        
+        // avatars in front of the listener are more likely to be looked at than the ones behind
+        float facing = (glm::dot(listener.front, toOther / distanceToAvatar) + 1.0f) * 0.5f;
+        weight *= BEHIND_LISTENER_WEIGHT + ((1.0f - BEHIND_LISTENER_WEIGHT) * facing);
+        
+        // and an avatar that is moving changes more between frames than one that is standing still
+        weight *= STILL_AVATAR_WEIGHT
+            + ((1.0f - STILL_AVATAR_WEIGHT) * glm::min(other.speed / FULL_WEIGHT_SPEED, 1.0f));
+    }
+    
+    // when we're struggling everything goes out less often, but never less often than the avatars out of view, so
+    // however far away or throttled an avatar is its listener doesn't decide it's gone
+    return std::max(weight * (1.0f - _mixer->_performanceThrottlingRatio), OUT_OF_VIEW_WEIGHT);
+}
+
+bool AvatarMixerJob::writeAvatarRecord(const AvatarMixer::AvatarSnapshot& other, const AvatarSendState& sendState) {
+    // the encodings start with the session UUID, which goes out as it is ahead of the record
+    const char* avatarData = other.avatarByteArray.constData() + NUM_BYTES_RFC4122_UUID;
+    int avatarDataLength = other.avatarByteArray.size() - NUM_BYTES_RFC4122_UUID;
+    
+    _avatarRecord.resize(0);
+    _avatarRecord.append(other.avatarByteArray.constData(), NUM_BYTES_RFC4122_UUID);
+    
+    if (!sendState.keyframe.isEmpty()
+        && _mixer->_frameTimestamp - sendState.keyframeTimestamp < AVATAR_KEYFRAME_INTERVAL_MSECS) {
+        _avatarRecord.append((char) AVATAR_DELTA_RECORD);
+        _avatarRecord.append((char) sendState.keyframeSequence);
+        
+        // leave room for the length, we only know it once the delta is written
+        int deltaLengthOffset = _avatarRecord.size();
+        _avatarRecord.resize(deltaLengthOffset + sizeof(quint16));
+        
+        if (AvatarDataDelta::writeDelta(sendState.keyframe.constData() + NUM_BYTES_RFC4122_UUID,
+                                        sendState.keyframe.size() - NUM_BYTES_RFC4122_UUID,
+                                        avatarData, avatarDataLength, _avatarRecord)) {
+            quint16 deltaLength = _avatarRecord.size() - deltaLengthOffset - sizeof(quint16);
+            memcpy(_avatarRecord.data() + deltaLengthOffset, &deltaLength, sizeof(deltaLength));
+            return false;
+        }
+        
+        // the delta wouldn't save anything, so this is a good time for a new keyframe
+        _avatarRecord.resize(NUM_BYTES_RFC4122_UUID);
+    }
+    
+    _avatarRecord.append((char) AVATAR_KEYFRAME_RECORD);
+    _avatarRecord.append((char) (quint8) (sendState.keyframeSequence + 1));
+    _avatarRecord.append(avatarData, avatarDataLength);
+    return true;
+}
+
+void AvatarMixerJob::queueAvatarsForListener(const AvatarMixer::AvatarSnapshot& listener) {
+    NodeList* nodeList = NodeList::getInstance();
+    const SharedNodePointer& node = listener.node;
+    AvatarMixerClientData* nodeData = reinterpret_cast<AvatarMixerClientData*>(node->getLinkedData());
+    QHash<QUuid, AvatarSendState>& sendStates = nodeData->getAvatarSendStates();
+    quint64 now = _mixer->_frameTimestamp;
+    
+    // an avatar's priority is how long it has waited since it was last sent to this listener, scaled by its weight
+    // it is due once that reaches a frame, so a weight of one is sent every frame and a weight of a half every other
+    // the wait gets half a frame of slack, a coarse timer can fire a msec early and that shouldn't cost a turn
+    _sendPriorities.resize(0);
+    
+    for (int i = 0; i < _mixer->_avatarSnapshots.size(); i++) {
+        const AvatarMixer::AvatarSnapshot& other = _mixer->_avatarSnapshots[i];
+        if (&other == &listener) {
+            continue;
+        }
+        
+        QHash<QUuid, AvatarSendState>::const_iterator sendState = sendStates.constFind(other.node->getUUID());
+        if (sendState == sendStates.constEnd() || sendState->lastSentTimestamp == 0) {
+            // this listener has never been sent this avatar, it goes ahead of everything else
+            _sendPriorities.append(qMakePair(std::numeric_limits<float>::max(), i));
+            continue;
+        }
+        
+        float priority = (float) (now - sendState->lastSentTimestamp + HALF_FRAME_MSECS)
+            * computeSendWeight(listener, other);
+        if (priority >= (float) AVATAR_DATA_SEND_INTERVAL_MSECS) {
+            _sendPriorities.append(qMakePair(priority, i));
+        } else {
+            ++_numSkippedAvatarUpdates;
+        }
+    }
+    
+    qSort(_sendPriorities.begin(), _sendPriorities.end(), qGreater<QPair<float, int> >());
+    
+    // reset packet pointers for this node
+    _mixedAvatarByteArray.resize(_numPacketHeaderBytes);
+    int numAvatarBytes = 0;
+    
+    // send back a packet with other active node data to this node, until we're out of budget for this frame
+    for (int i = 0; i < _sendPriorities.size(); i++) {
+        const AvatarMixer::AvatarSnapshot& other = _mixer->_avatarSnapshots[_sendPriorities[i].second];
+        AvatarSendState& sendState = sendStates[other.node->getUUID()];
+        bool isKeyframe = writeAvatarRecord(other, sendState);
+        
+        if (numAvatarBytes + _avatarRecord.size() > MAX_AVATAR_BYTES_PER_LISTENER_PER_FRAME) {
+            // everything from here on waits for a later frame, where it will have a higher priority
+            _numOverBudgetAvatarUpdates += _sendPriorities.size() - i;
+            break;
+        }
+        
+        if (_avatarRecord.size() + _mixedAvatarByteArray.size() > MAX_PACKET_SIZE) {
+            nodeList->queueDatagram(_datagramBatch, _mixedAvatarByteArray, node);
+            
+            // reset the packet
+            _mixedAvatarByteArray.resize(_numPacketHeaderBytes);
+        }
+        
+        // copy the avatar into the mixedAvatarByteArray packet
+        _mixedAvatarByteArray.append(_avatarRecord);
+        numAvatarBytes += _avatarRecord.size();
+        sendState.lastSentTimestamp = now;
+        
+        if (isKeyframe) {
+            // the encoding is shared with the snapshot, so holding onto it doesn't copy anything
+            sendState.keyframe = other.avatarByteArray;
+            sendState.keyframeTimestamp = now;
+            ++sendState.keyframeSequence;
+        }
+    }
+    
+    nodeList->queueDatagram(_datagramBatch, _mixedAvatarByteArray, node);
+    
+    if (sendStates.size() >= _mixer->_avatarSnapshots.size() + _mixer->_contendedAvatars.size()) {
+        // there are avatars in here whose nodes are gone, forget them - one that was only left out because it was
+        // contended keeps what it was sent, so next frame it picks up from there instead of starting over
+        QHash<QUuid, AvatarSendState>::iterator sendState = sendStates.begin();
+        while (sendState != sendStates.end()) {
+            if (_mixer->_avatarSnapshotIndices.contains(sendState.key())
+                || _mixer->_contendedAvatars.contains(sendState.key())) {
+                ++sendState;
+            } else {
+                sendState = sendStates.erase(sendState);
+            }
+        }
+    }
+}
+
+void AvatarMixerJob::queueBillboardsAndIdentitiesForListener(const AvatarMixer::AvatarSnapshot& listener) {
+    NodeList* nodeList = NodeList::getInstance();
+    const SharedNodePointer& node = listener.node;
+    AvatarMixerClientData* nodeData = reinterpret_cast<AvatarMixerClientData*>(node->getLinkedData());
+    QHash<QUuid, AvatarSendState>& sendStates = nodeData->getAvatarSendStates();
+    quint64 now = _mixer->_frameTimestamp;
+    
+    AvatarSendState* mostOverdueState = NULL;
+    const AvatarMixer::AvatarSnapshot* mostOverdue = NULL;
+    
+    for (int i = 0; i < _mixer->_avatarSnapshots.size(); i++) {
+        const AvatarMixer::AvatarSnapshot& other = _mixer->_avatarSnapshots[i];
+        if (&other == &listener || (other.billboardChangeTimestamp == 0 && other.identityChangeTimestamp == 0)) {
+            continue;
+        }
+        
+        AvatarSendState& sendState = sendStates[other.node->getUUID()];
+        bool didSend = false;
+        
+        // this covers a listener that has just connected too, it hasn't been sent anything yet
+        if (other.billboardChangeTimestamp > sendState.billboardSentChangeTimestamp) {
+            nodeList->queueDatagram(_datagramBatch, other.billboardPacket, node);
+            sendState.billboardSentChangeTimestamp = other.billboardChangeTimestamp;
+            didSend = true;
+            ++_numBillboardPackets;
+        }
+        
+        if (other.identityChangeTimestamp > sendState.identitySentChangeTimestamp) {
+            nodeList->queueDatagram(_datagramBatch, other.identityPacket, node);
+            sendState.identitySentChangeTimestamp = other.identityChangeTimestamp;
+            didSend = true;
+            ++_numIdentityPackets;
+        }
+        
+        if (didSend) {
+            sendState.lastResendTimestamp = now;
+        } else if (now - sendState.lastResendTimestamp >= BILLBOARD_AND_IDENTITY_RESEND_INTERVAL_MSECS
+                   && (!mostOverdueState || sendState.lastResendTimestamp < mostOverdueState->lastResendTimestamp)) {
+            mostOverdueState = &sendState;
+            mostOverdue = &other;
+        }
+    }
+    
+    if (mostOverdue) {
+        if (mostOverdue->billboardChangeTimestamp > 0) {
+            nodeList->queueDatagram(_datagramBatch, mostOverdue->billboardPacket, node);
+            ++_numBillboardPackets;
+        }
+        
+        if (mostOverdue->identityChangeTimestamp > 0) {
+            nodeList->queueDatagram(_datagramBatch, mostOverdue->identityPacket, node);
+            ++_numIdentityPackets;
+        }
+        
+        mostOverdueState->lastResendTimestamp = now;
+    }
+}
 
-// NOTE: some additional optimizations to consider.
-//    1) use the view frustum to cull those avatars that are out of view. Since avatar data doesn't need to be present
-//       if the avatar is not in view or in the keyhole.
 void AvatarMixer::broadcastAvatarData() {
     
     int idleTime = QDateTime::currentMSecsSinceEpoch() - _lastFrameTimestamp;
@@ -113,105 +461,116 @@ void AvatarMixer::broadcastAvatarData() {
         ++framesSinceCutoffEvent;
     }
     
-    static QByteArray mixedAvatarByteArray;
+    NodeList* nodeList = NodeList::getInstance();
     
-    int numPacketHeaderBytes = populatePacketHeader(mixedAvatarByteArray, PacketTypeBulkAvatarData);
+    // copy out everything the jobs need while holding each avatar's lock, so the jobs themselves don't need any
+    takeAvatarSnapshots(nodeList->getNodeHashSnapshot());
+    runBroadcastJobs();
     
-    NodeList* nodeList = NodeList::getInstance();
+    // send everything this frame queued up, the socket is only written from this thread
+    for (int i = 0; i < _broadcastJobs.size(); i++) {
+        nodeList->flushDatagramBatch(_broadcastJobs[i]->getDatagramBatch());
+    }
     
-    AvatarMixerClientData* nodeData = NULL;
-    AvatarMixerClientData* otherNodeData = NULL;
+    _lastFrameTimestamp = QDateTime::currentMSecsSinceEpoch();
+}
+
+void AvatarMixer::takeAvatarSnapshots(const NodeHashSnapshotPointer& nodeHashSnapshot) {
+    _avatarSnapshots.resize(0);
+    _listenerIndices.resize(0);
+    _avatarSnapshotIndices.clear();
+    _contendedAvatars.clear();
+    _frameTimestamp = QDateTime::currentMSecsSinceEpoch();
     
-    foreach (const SharedNodePointer& node, nodeList->getNodeHash()) {
-        if (node->getLinkedData() && node->getType() == NodeType::Agent && node->getActiveSocket()
-            && (nodeData = reinterpret_cast<AvatarMixerClientData*>(node->getLinkedData()))->getMutex().tryLock()) {
-            ++_sumListeners;
-            
-            // reset packet pointers for this node
-            mixedAvatarByteArray.resize(numPacketHeaderBytes);
-            
-            AvatarData& avatar = nodeData->getAvatar();
-            glm::vec3 myPosition = avatar.getPosition();
-            
-            // this is an AGENT we have received head data from
-            // send back a packet with other active node data to this node
-            foreach (const SharedNodePointer& otherNode, nodeList->getNodeHash()) {
-                if (otherNode->getLinkedData() && otherNode->getUUID() != node->getUUID()
-                    && (otherNodeData = reinterpret_cast<AvatarMixerClientData*>(otherNode->getLinkedData()))->getMutex().tryLock()) {
-                    
-                    AvatarMixerClientData* otherNodeData = reinterpret_cast<AvatarMixerClientData*>(otherNode->getLinkedData());
-                    AvatarData& otherAvatar = otherNodeData->getAvatar();
-                    glm::vec3 otherPosition = otherAvatar.getPosition();
-            
-                    float distanceToAvatar = glm::length(myPosition - otherPosition);
-                    //  The full rate distance is the distance at which EVERY update will be sent for this avatar
-                    //  at a distance of twice the full rate distance, there will be a 50% chance of sending this avatar's update
-                    const float FULL_RATE_DISTANCE = 2.f;
-                    
-                    //  Decide whether to send this avatar's data based on it's distance from us
-                    if ((_performanceThrottlingRatio == 0 || randFloat() < (1.0f - _performanceThrottlingRatio))
-                        && (distanceToAvatar == 0.f || randFloat() < FULL_RATE_DISTANCE / distanceToAvatar)) {
-                        QByteArray avatarByteArray;
-                        avatarByteArray.append(otherNode->getUUID().toRfc4122());
-                        avatarByteArray.append(otherAvatar.toByteArray());
-                        
-                        if (avatarByteArray.size() + mixedAvatarByteArray.size() > MAX_PACKET_SIZE) {
-                            nodeList->writeDatagram(mixedAvatarByteArray, node);
-                            
-                            // reset the packet
-                            mixedAvatarByteArray.resize(numPacketHeaderBytes);
-                        }
-                        
-                        // copy the avatar into the mixedAvatarByteArray packet
-                        mixedAvatarByteArray.append(avatarByteArray);
-                        
-                        // if the receiving avatar has just connected make sure we send out the mesh and billboard
-                        // for this avatar (assuming they exist)
-                        bool forceSend = !nodeData->checkAndSetHasReceivedFirstPackets();
-                        
-                        // we will also force a send of billboard or identity packet
-                        // if either has changed in the last frame
-                        
-                        if (otherNodeData->getBillboardChangeTimestamp() > 0
-                            && (forceSend
-                                || otherNodeData->getBillboardChangeTimestamp() > _lastFrameTimestamp
-                                || randFloat() < BILLBOARD_AND_IDENTITY_SEND_PROBABILITY)) {
-                            QByteArray billboardPacket = byteArrayWithPopulatedHeader(PacketTypeAvatarBillboard);
-                            billboardPacket.append(otherNode->getUUID().toRfc4122());
-                            billboardPacket.append(otherNodeData->getAvatar().getBillboard());
-                            nodeList->writeDatagram(billboardPacket, node);
-                            
-                            ++_sumBillboardPackets;
-                        }
-                        
-                        if (otherNodeData->getIdentityChangeTimestamp() > 0
-                            && (forceSend
-                                || otherNodeData->getIdentityChangeTimestamp() > _lastFrameTimestamp
-                                || randFloat() < BILLBOARD_AND_IDENTITY_SEND_PROBABILITY)) {
-                                
-                            QByteArray identityPacket = byteArrayWithPopulatedHeader(PacketTypeAvatarIdentity);
-                            
-                            QByteArray individualData = otherNodeData->getAvatar().identityByteArray();
-                            individualData.replace(0, NUM_BYTES_RFC4122_UUID, otherNode->getUUID().toRfc4122());
-                            identityPacket.append(individualData);
-                            
-                            nodeList->writeDatagram(identityPacket, node);
-                                
-                            ++_sumIdentityPackets;
-                        }
-                    }
-                
-                    otherNodeData->getMutex().unlock();
-                }
-            }
-            
-            nodeList->writeDatagram(mixedAvatarByteArray, node);
-            
-            nodeData->getMutex().unlock();
+    foreach (const SharedNodePointer& node, nodeHashSnapshot->getNodeHash()) {
+        AvatarMixerClientData* nodeData = reinterpret_cast<AvatarMixerClientData*>(node->getLinkedData());
+        if (!nodeData) {
+            continue;
+        }
+        
+        if (!nodeData->getMutex().tryLock()) {
+            // this avatar is being parsed right now, rather than wait for it we leave it out of this frame
+            ++_sumContendedAvatars;
+            _contendedAvatars.insert(node->getUUID());
+            continue;
+        }
+        
+        AvatarSnapshot snapshot;
+        snapshot.node = node;
+        snapshot.position = nodeData->getAvatar().getPosition();
+        snapshot.front = nodeData->getAvatar().getOrientation() * IDENTITY_FRONT;
+        snapshot.speed = nodeData->computeSpeedSinceLastSnapshot(_frameTimestamp);
+        snapshot.avatarByteArray = nodeData->getEncodedAvatar(node->getUUID());
+        snapshot.billboardChangeTimestamp = nodeData->getBillboardChangeTimestamp();
+        snapshot.identityChangeTimestamp = nodeData->getIdentityChangeTimestamp();
+        
+        // these only share the cached packets, which are built again once per change rather than once per listener
+        if (snapshot.billboardChangeTimestamp > 0) {
+            snapshot.billboardPacket = nodeData->getBillboardPacket(node->getUUID());
         }
+        
+        if (snapshot.identityChangeTimestamp > 0) {
+            snapshot.identityPacket = nodeData->getIdentityPacket(node->getUUID());
+        }
+        
+        snapshot.hasViewFrustum = nodeData->hasViewFrustum();
+        if (snapshot.hasViewFrustum) {
+            snapshot.viewFrustum = nodeData->getViewFrustum();
+        }
+        
+        nodeData->getMutex().unlock();
+        
+        if (node->getType() == NodeType::Agent && node->getActiveSocket()) {
+            _listenerIndices.append(_avatarSnapshots.size());
+        }
+        
+        _avatarSnapshotIndices.insert(node->getUUID(), _avatarSnapshots.size());
+        _avatarSnapshots.append(snapshot);
     }
+}
+
+void AvatarMixer::runBroadcastJobs() {
+    // give each job an equal slice of the listeners, we don't use more jobs than we have listeners
+    int numJobs = std::max(1, std::min(_broadcastJobs.size(), _listenerIndices.size()));
+    int listenersPerJob = (_listenerIndices.size() + numJobs - 1) / numJobs;
     
-    _lastFrameTimestamp = QDateTime::currentMSecsSinceEpoch();
+    for (int i = 0; i < numJobs; i++) {
+        int begin = std::min(i * listenersPerJob, _listenerIndices.size());
+        int end = std::min(begin + listenersPerJob, _listenerIndices.size());
+        _broadcastJobs[i]->setSlice(begin, end);
+        
+        if (i > 0) {
+            _broadcastThreadPool.start(_broadcastJobs[i]);
+        }
+    }
+    
+    // the first slice is always handled on this thread, while the pool handles the rest
+    _broadcastJobs[0]->run();
+    
+    // wait for every job to finish queueing its packets before any of them are sent
+    _finishedBroadcastJobs.acquire(numJobs);
+    
+    for (int i = 0; i < numJobs; i++) {
+        _broadcastJobs[i]->takeStats(_sumBillboardPackets, _sumIdentityPackets, _sumSkippedAvatarUpdates,
+                                     _sumOverBudgetAvatarUpdates);
+    }
+    
+    _sumListeners += _listenerIndices.size();
+}
+
+void AvatarMixer::setupBroadcastJobs(int numBroadcastThreads) {
+    if (numBroadcastThreads < 1) {
+        numBroadcastThreads = 1;
+    }
+    
+    for (int i = 0; i < numBroadcastThreads; i++) {
+        _broadcastJobs.append(new AvatarMixerJob(this));
+    }
+    
+    // the broadcast thread handles one slice itself, so the pool only needs threads for the others
+    // and we keep those threads around for the life of the mixer instead of respawning them each frame
+    _broadcastThreadPool.setMaxThreadCount(std::max(1, numBroadcastThreads - 1));
+    _broadcastThreadPool.setExpiryTimeout(-1);
 }
 
 void AvatarMixer::nodeKilled(SharedNodePointer killedNode) {
@@ -249,9 +608,10 @@ void AvatarMixer::readPendingDatagrams() {
                         AvatarMixerClientData* nodeData = reinterpret_cast<AvatarMixerClientData*>(avatarNode->getLinkedData());
                         AvatarData& avatar = nodeData->getAvatar();
                         
-                        // parse the identity packet and update the change timestamp if appropriate
+                        // parse the identity packet and update the change timestamp if appropriate, the broadcast
+                        // thread builds the cached identity packet from the avatar while holding the same lock
+                        QMutexLocker nodeDataLocker(&nodeData->getMutex());
                         if (avatar.hasIdentityChangedAfterParsing(receivedPacket)) {
-                            QMutexLocker nodeDataLocker(&nodeData->getMutex());
                             nodeData->setIdentityChangeTimestamp(QDateTime::currentMSecsSinceEpoch());
                         }
                     }
@@ -266,9 +626,10 @@ void AvatarMixer::readPendingDatagrams() {
                         AvatarMixerClientData* nodeData = static_cast<AvatarMixerClientData*>(avatarNode->getLinkedData());
                         AvatarData& avatar = nodeData->getAvatar();
                         
-                        // parse the billboard packet and update the change timestamp if appropriate
+                        // parse the billboard packet and update the change timestamp if appropriate, the broadcast
+                        // thread builds the cached billboard packet from the avatar while holding the same lock
+                        QMutexLocker nodeDataLocker(&nodeData->getMutex());
                         if (avatar.hasBillboardChangedAfterParsing(receivedPacket)) {
-                            QMutexLocker nodeDataLocker(&nodeData->getMutex());
                             nodeData->setBillboardChangeTimestamp(QDateTime::currentMSecsSinceEpoch());
                         }
                         
@@ -295,6 +656,14 @@ void AvatarMixer::sendStatsPacket() {
     statsObject["average_billboard_packets_per_frame"] = (float) _sumBillboardPackets / (float) _numStatFrames;
     statsObject["average_identity_packets_per_frame"] = (float) _sumIdentityPackets / (float) _numStatFrames;
     
+    // avatars left out of a frame because their data was being parsed, updates that weren't due yet for their listener,
+    // and updates that were due but didn't fit in their listener's budget for the frame
+    statsObject["average_contended_avatars_per_frame"] = (float) _sumContendedAvatars / (float) _numStatFrames;
+    statsObject["average_skipped_avatar_updates_per_frame"] = (float) _sumSkippedAvatarUpdates / (float) _numStatFrames;
+    statsObject["average_over_budget_avatar_updates_per_frame"] =
+        (float) _sumOverBudgetAvatarUpdates / (float) _numStatFrames;
+    statsObject["broadcast_threads"] = _broadcastJobs.size();
+    
     statsObject["trailing_sleep_percentage"] = _trailingSleepRatio * 100;
     statsObject["performance_throttling_ratio"] = _performanceThrottlingRatio;
     
@@ -303,6 +672,9 @@ void AvatarMixer::sendStatsPacket() {
     _sumListeners = 0;
     _sumBillboardPackets = 0;
     _sumIdentityPackets = 0;
+    _sumContendedAvatars = 0;
+    _sumSkippedAvatarUpdates = 0;
+    _sumOverBudgetAvatarUpdates = 0;
     _numStatFrames = 0;
 }
 
@@ -314,6 +686,56 @@ void AvatarMixer::run() {
     
     nodeList->linkedDataCreateCallback = attachAvatarDataToNode;
     
+    // setup a NetworkAccessManager to ask the domain-server for our settings
+    NetworkAccessManager& networkManager = NetworkAccessManager::getInstance();
+    
+    QUrl settingsJSONURL;
+    settingsJSONURL.setScheme("http");
+    settingsJSONURL.setHost(nodeList->getDomainHandler().getHostname());
+    settingsJSONURL.setPort(DOMAIN_SERVER_HTTP_PORT);
+    settingsJSONURL.setPath("/settings.json");
+    settingsJSONURL.setQuery(QString("type=%1").arg(_type));
+    
+    QNetworkReply *reply = NULL;
+    
+    int failedAttempts = 0;
+    const int MAX_SETTINGS_REQUEST_FAILED_ATTEMPTS = 5;
+    
+    qDebug() << "Requesting settings for assignment from domain-server at" << settingsJSONURL.toString();
+    
+    while (!reply || reply->error() != QNetworkReply::NoError) {
+        reply = networkManager.get(QNetworkRequest(settingsJSONURL));
+        
+        QEventLoop loop;
+        QObject::connect(reply, SIGNAL(finished()), &loop, SLOT(quit()));
+        
+        loop.exec();
+        
+        ++failedAttempts;
+        
+        if (failedAttempts == MAX_SETTINGS_REQUEST_FAILED_ATTEMPTS) {
+            qDebug() << "Failed to get settings from domain-server. Bailing on assignment.";
+            setFinished(true);
+            return;
+        }
+    }
+    
+    QJsonObject settingsObject = QJsonDocument::fromJson(reply->readAll()).object();
+    
+    // check the payload to see if we have been asked to broadcast on a set number of threads, by default we use as
+    // many as this machine can run at once
+    const QString AVATAR_MIXER_GROUP_KEY = "avatar-mixer";
+    const QString BROADCAST_THREADS_JSON_KEY = "broadcast-threads";
+    
+    int numBroadcastThreads = settingsObject[AVATAR_MIXER_GROUP_KEY].toObject()[BROADCAST_THREADS_JSON_KEY]
+        .toVariant().toInt();
+    if (numBroadcastThreads < 1) {
+        numBroadcastThreads = QThread::idealThreadCount();
+    }
+    
+    qDebug() << "Broadcasting to listeners on" << std::max(1, numBroadcastThreads) << "thread(s).";
+    setupBroadcastJobs(numBroadcastThreads);
+    
     // setup the timer that will be fired on the broadcast thread
     QTimer* broadcastTimer = new QTimer();
     broadcastTimer->setInterval(AVATAR_DATA_SEND_INTERVAL_MSECS);
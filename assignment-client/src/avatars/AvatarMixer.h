@@ -15,7 +15,18 @@
 #ifndef hifi_AvatarMixer_h
 #define hifi_AvatarMixer_h
 
+#include <glm/glm.hpp>
+
+#include <QtCore/QSemaphore>
+#include <QtCore/QSet>
+#include <QtCore/QThreadPool>
+
+#include <DatagramBatch.h>
+#include <LimitedNodeList.h>
 #include <ThreadedAssignment.h>
+#include <ViewFrustum.h>
+
+class AvatarMixerJob;
 
 /// Handles assignments of type AvatarMixer - distribution of avatar data to various clients
 class AvatarMixer : public ThreadedAssignment {
@@ -34,10 +45,58 @@ public slots:
     void sendStatsPacket();
     
 private:
+    friend class AvatarMixerJob;
+    
+    /// what the broadcast jobs need to know about one avatar for a frame, it is copied out of the avatar's client data
+    /// while holding its mutex so that the jobs can fan the frame out without taking any locks
+    class AvatarSnapshot {
+    public:
+        AvatarSnapshot() : node(), position(), front(), speed(0.0f), avatarByteArray(), billboardPacket(),
+            billboardChangeTimestamp(0), identityPacket(), identityChangeTimestamp(0), hasViewFrustum(false),
+            viewFrustum() { }
+        
+        SharedNodePointer node;
+        glm::vec3 position;
+        glm::vec3 front;
+        float speed;
+        QByteArray avatarByteArray;
+        QByteArray billboardPacket;
+        quint64 billboardChangeTimestamp;
+        QByteArray identityPacket;
+        quint64 identityChangeTimestamp;
+        bool hasViewFrustum;
+        ViewFrustum viewFrustum;
+    };
+    
     void broadcastAvatarData();
     
+    /// fills _avatarSnapshots and _listenerIndices for this frame from the node hash snapshot
+    void takeAvatarSnapshots(const NodeHashSnapshotPointer& nodeHashSnapshot);
+    
+    /// spreads this frame's listeners across the broadcast jobs and waits for them all to finish
+    void runBroadcastJobs();
+    
+    /// sets up the jobs (and the thread pool that runs them) used to broadcast to listeners in parallel
+    void setupBroadcastJobs(int numBroadcastThreads);
+    
     QThread _broadcastThread;
     
+    QList<AvatarMixerJob*> _broadcastJobs;
+    QThreadPool _broadcastThreadPool;
+    QSemaphore _finishedBroadcastJobs;
+    
+    // every avatar we could lock this frame, the indices in it of the ones that are listeners,
+    // and the index of each avatar's snapshot by node UUID
+    QVector<AvatarSnapshot> _avatarSnapshots;
+    QVector<int> _listenerIndices;
+    QHash<QUuid, int> _avatarSnapshotIndices;
+    
+    // the avatars left out of this frame because they were being parsed, they're still around
+    QSet<QUuid> _contendedAvatars;
+    
+    // when this frame's snapshots were taken, in msecs since the epoch
+    quint64 _frameTimestamp;
+    
     quint64 _lastFrameTimestamp;
     
     float _trailingSleepRatio;
@@ -47,6 +106,9 @@ private:
     int _numStatFrames;
     int _sumBillboardPackets;
     int _sumIdentityPackets;
+    int _sumContendedAvatars;
+    int _sumSkippedAvatarUpdates;
+    int _sumOverBudgetAvatarUpdates;
 };
 
 #endif // hifi_AvatarMixer_h
@@ -15,9 +15,19 @@
 
 AvatarMixerClientData::AvatarMixerClientData() :
     NodeData(),
-    _hasReceivedFirstPackets(false),
+    _encodedAvatar(),
+    _isEncodedAvatarStale(true),
+    _billboardPacket(),
+    _isBillboardPacketStale(true),
+    _identityPacket(),
+    _isIdentityPacketStale(true),
+    _hasViewFrustum(false),
+    _viewFrustum(),
     _billboardChangeTimestamp(0),
-    _identityChangeTimestamp(0)
+    _identityChangeTimestamp(0),
+    _avatarSendStates(),
+    _lastSnapshotPosition(),
+    _lastSnapshotTimestamp(0)
 {
     
 }
@@ -25,11 +35,74 @@ AvatarMixerClientData::AvatarMixerClientData() :
 int AvatarMixerClientData::parseData(const QByteArray& packet) {
     // compute the offset to the data payload
     int offset = numBytesForPacketHeader(packet);
-    return _avatar.parseDataAtOffset(packet, offset);
+    _isEncodedAvatarStale = true;
+    int bytesRead = _avatar.parseDataAtOffset(packet, offset);
+    
+    // clients that render follow their avatar with the camera details they send the octree servers
+    if (packet.size() - (offset + bytesRead) >= ViewFrustum::numBytesCameraDetails()) {
+        const unsigned char* cameraDetails = reinterpret_cast<const unsigned char*>(packet.data()) + offset + bytesRead;
+        bytesRead += _viewFrustum.unpackCameraDetails(cameraDetails);
+        _viewFrustum.calculate();
+        _hasViewFrustum = true;
+    }
+    
+    return bytesRead;
+}
+
+const QByteArray& AvatarMixerClientData::getEncodedAvatar(const QUuid& nodeUUID) {
+    if (_isEncodedAvatarStale) {
+        _encodedAvatar = nodeUUID.toRfc4122();
+        _encodedAvatar.append(_avatar.toByteArray());
+        _isEncodedAvatarStale = false;
+    }
+    return _encodedAvatar;
+}
+
+void AvatarMixerClientData::setBillboardChangeTimestamp(quint64 billboardChangeTimestamp) {
+    _billboardChangeTimestamp = billboardChangeTimestamp;
+    _isBillboardPacketStale = true;
+}
+
+void AvatarMixerClientData::setIdentityChangeTimestamp(quint64 identityChangeTimestamp) {
+    _identityChangeTimestamp = identityChangeTimestamp;
+    _isIdentityPacketStale = true;
 }
 
-bool AvatarMixerClientData::checkAndSetHasReceivedFirstPackets() {
-    bool oldValue = _hasReceivedFirstPackets;
-    _hasReceivedFirstPackets = true;
-    return oldValue;
+const QByteArray& AvatarMixerClientData::getBillboardPacket(const QUuid& nodeUUID) {
+    if (_isBillboardPacketStale) {
+        _billboardPacket = byteArrayWithPopulatedHeader(PacketTypeAvatarBillboard);
+        _billboardPacket.append(nodeUUID.toRfc4122());
+        _billboardPacket.append(_avatar.getBillboard());
+        _isBillboardPacketStale = false;
+    }
+    return _billboardPacket;
+}
+
+const QByteArray& AvatarMixerClientData::getIdentityPacket(const QUuid& nodeUUID) {
+    if (_isIdentityPacketStale) {
+        // the identity goes out under the session UUID the mixer knows the avatar by
+        QByteArray identityByteArray = _avatar.identityByteArray();
+        identityByteArray.replace(0, NUM_BYTES_RFC4122_UUID, nodeUUID.toRfc4122());
+        
+        _identityPacket = byteArrayWithPopulatedHeader(PacketTypeAvatarIdentity);
+        _identityPacket.append(identityByteArray);
+        _isIdentityPacketStale = false;
+    }
+    return _identityPacket;
+}
+
+float AvatarMixerClientData::computeSpeedSinceLastSnapshot(quint64 timestamp) {
+    const glm::vec3& position = _avatar.getPosition();
+    float speed = 0.0f;
+    
+    if (_lastSnapshotTimestamp > 0 && timestamp > _lastSnapshotTimestamp) {
+        const float MSECS_PER_SECOND = 1000.0f;
+        speed = glm::distance(position, _lastSnapshotPosition) * MSECS_PER_SECOND
+            / (float) (timestamp - _lastSnapshotTimestamp);
+    }
+    
+    _lastSnapshotPosition = position;
+    _lastSnapshotTimestamp = timestamp;
+    
+    return speed;
 }
@@ -12,10 +12,30 @@
 #ifndef hifi_AvatarMixerClientData_h
 #define hifi_AvatarMixerClientData_h
 
+#include <QtCore/QHash>
 #include <QtCore/QUrl>
+#include <QtCore/QUuid>
 
 #include <AvatarData.h>
 #include <NodeData.h>
+#include <ViewFrustum.h>
+
+/// what a listener has been sent of one other avatar
+class AvatarSendState {
+public:
+    AvatarSendState() : lastSentTimestamp(0), keyframeTimestamp(0), keyframeSequence(0), keyframe(),
+        billboardSentChangeTimestamp(0), identitySentChangeTimestamp(0), lastResendTimestamp(0) {}
+    
+    quint64 lastSentTimestamp;
+    quint64 keyframeTimestamp;
+    quint8 keyframeSequence;
+    QByteArray keyframe; ///< the encoding from getEncodedAvatar the last keyframe was made from, deltas are against it
+    
+    // the change timestamps of the billboard and identity that were last sent, and when they were last sent at all
+    quint64 billboardSentChangeTimestamp;
+    quint64 identitySentChangeTimestamp;
+    quint64 lastResendTimestamp;
+};
 
 class AvatarMixerClientData : public NodeData {
     Q_OBJECT
@@ -25,19 +45,49 @@ public:
     int parseData(const QByteArray& packet);
     AvatarData& getAvatar() { return _avatar; }
     
-    bool checkAndSetHasReceivedFirstPackets();
+    /// the camera the client appended to its last avatar data packet, agents without one are sent everything
+    bool hasViewFrustum() const { return _hasViewFrustum; }
+    const ViewFrustum& getViewFrustum() const { return _viewFrustum; }
+    
+    /// the avatar as it goes into a bulk avatar data packet, nodeUUID followed by the avatar data
+    /// the avatar is only encoded again if it has been parsed since the last call, so every listener shares one encoding
+    const QByteArray& getEncodedAvatar(const QUuid& nodeUUID);
     
     quint64 getBillboardChangeTimestamp() const { return _billboardChangeTimestamp; }
-    void setBillboardChangeTimestamp(quint64 billboardChangeTimestamp) { _billboardChangeTimestamp = billboardChangeTimestamp; }
+    void setBillboardChangeTimestamp(quint64 billboardChangeTimestamp);
     
     quint64 getIdentityChangeTimestamp() const { return _identityChangeTimestamp; }
-    void setIdentityChangeTimestamp(quint64 identityChangeTimestamp) { _identityChangeTimestamp = identityChangeTimestamp; }
+    void setIdentityChangeTimestamp(quint64 identityChangeTimestamp);
+    
+    /// the billboard and identity packets for this avatar, ready to be hashed for and sent to any listener
+    /// they are only built again after the billboard or identity has changed, like the encoded avatar
+    const QByteArray& getBillboardPacket(const QUuid& nodeUUID);
+    const QByteArray& getIdentityPacket(const QUuid& nodeUUID);
+    
+    /// what this node has been sent of each other avatar, keyed by the other avatar's node UUID
+    /// only the broadcast job sending to this node uses it, so it isn't covered by the mutex
+    QHash<QUuid, AvatarSendState>& getAvatarSendStates() { return _avatarSendStates; }
+    
+    /// the speed the avatar has moved at since the last broadcast snapshot, in meters per second
+    /// only called from the broadcast thread when it snapshots the avatar, timestamp is in msecs
+    float computeSpeedSinceLastSnapshot(quint64 timestamp);
     
 private:
     AvatarData _avatar;
-    bool _hasReceivedFirstPackets;
+    QByteArray _encodedAvatar;
+    bool _isEncodedAvatarStale;
+    QByteArray _billboardPacket;
+    bool _isBillboardPacketStale;
+    QByteArray _identityPacket;
+    bool _isIdentityPacketStale;
+    bool _hasViewFrustum;
+    ViewFrustum _viewFrustum;
     quint64 _billboardChangeTimestamp;
     quint64 _identityChangeTimestamp;
+    
+    QHash<QUuid, AvatarSendState> _avatarSendStates;
+    glm::vec3 _lastSnapshotPosition;
+    quint64 _lastSnapshotTimestamp;
 };
 
 #endif // hifi_AvatarMixerClientData_h
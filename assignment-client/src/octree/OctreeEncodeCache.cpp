@@ -0,0 +1,159 @@
+//
+//  OctreeEncodeCache.cpp
+//  assignment-client/src/octree
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <cmath>
+
+#include <glm/gtc/quaternion.hpp>
+
+#include <SharedUtil.h>
+
+#include "OctreeEncodeCache.h"
+
+static int bucketFor(float value, float bucketSize) {
+    return (int)floorf(value / bucketSize + 0.5f);
+}
+
+OctreeEncodeCacheKey::OctreeEncodeCacheKey() :
+    subTree(NULL),
+    lastChanged(0),
+    fieldOfView(0.0f),
+    aspectRatio(0.0f),
+    nearClip(0.0f),
+    farClip(0.0f),
+    eyeOffsetPosition(),
+    octreeSizeScale(0.0f),
+    boundaryLevelAdjust(0),
+    includeColor(false)
+{
+    for (int i = 0; i < 3; i++) {
+        positionBucket[i] = 0;
+        orientationBucket[i] = 0;
+    }
+}
+
+OctreeEncodeCacheKey::OctreeEncodeCacheKey(const ViewFrustum& viewFrustum, float octreeSizeScale,
+                                           int boundaryLevelAdjust, bool includeColor) :
+    subTree(NULL),
+    lastChanged(0),
+    fieldOfView(viewFrustum.getFieldOfView()),
+    aspectRatio(viewFrustum.getAspectRatio()),
+    nearClip(viewFrustum.getNearClip()),
+    farClip(viewFrustum.getFarClip()),
+    eyeOffsetPosition(viewFrustum.getEyeOffsetPosition()),
+    octreeSizeScale(octreeSizeScale),
+    boundaryLevelAdjust(boundaryLevelAdjust),
+    includeColor(includeColor)
+{
+    glm::vec3 eulers = glm::degrees(safeEulerAngles(viewFrustum.getOrientation()));
+    for (int i = 0; i < 3; i++) {
+        positionBucket[i] = bucketFor(viewFrustum.getPosition()[i], ENCODE_CACHE_POSITION_BUCKET_SIZE);
+        orientationBucket[i] = bucketFor(eulers[i], ENCODE_CACHE_ORIENTATION_BUCKET_SIZE);
+    }
+}
+
+void OctreeEncodeCacheKey::setSubTree(OctreeElement* subTree) {
+    this->subTree = subTree;
+    lastChanged = subTree->getLastChanged();
+}
+
+void OctreeEncodeCacheKey::calculateBucketViewFrustum(ViewFrustum& viewFrustum) const {
+    glm::vec3 position;
+    glm::vec3 eulers;
+    for (int i = 0; i < 3; i++) {
+        position[i] = positionBucket[i] * ENCODE_CACHE_POSITION_BUCKET_SIZE;
+        eulers[i] = orientationBucket[i] * ENCODE_CACHE_ORIENTATION_BUCKET_SIZE;
+    }
+    viewFrustum.setPosition(position);
+    viewFrustum.setOrientation(glm::quat(glm::radians(eulers)));
+    viewFrustum.calculate();
+}
+
+bool OctreeEncodeCacheKey::operator==(const OctreeEncodeCacheKey& other) const {
+    for (int i = 0; i < 3; i++) {
+        if (positionBucket[i] != other.positionBucket[i] || orientationBucket[i] != other.orientationBucket[i]) {
+            return false;
+        }
+    }
+    return subTree == other.subTree && lastChanged == other.lastChanged
+        && fieldOfView == other.fieldOfView && aspectRatio == other.aspectRatio
+        && nearClip == other.nearClip && farClip == other.farClip
+        && eyeOffsetPosition == other.eyeOffsetPosition
+        && octreeSizeScale == other.octreeSizeScale && boundaryLevelAdjust == other.boundaryLevelAdjust
+        && includeColor == other.includeColor;
+}
+
+static uint combineHash(uint hash, uint value) {
+    return hash ^ (value + 0x9e3779b9 + (hash << 6) + (hash >> 2));
+}
+
+uint qHash(const OctreeEncodeCacheKey& key, uint seed) {
+    // the lens and LOD are almost always the same for every client, so they're left to operator==
+    uint hash = combineHash(seed, qHash((quintptr)key.subTree));
+    hash = combineHash(hash, qHash(key.lastChanged));
+    for (int i = 0; i < 3; i++) {
+        hash = combineHash(hash, key.positionBucket[i]);
+        hash = combineHash(hash, key.orientationBucket[i]);
+    }
+    return combineHash(hash, key.boundaryLevelAdjust);
+}
+
+OctreeEncodeCache::OctreeEncodeCache(int maxBytes) :
+    _maxBytes(maxBytes),
+    _lock(),
+    _entries(),
+    _insertionOrder(),
+    _bytes(0),
+    _hits(0),
+    _misses(0)
+{
+
+}
+
+bool OctreeEncodeCache::find(const OctreeEncodeCacheKey& key, QByteArray& encoded) {
+    _lock.lockForRead();
+    QHash<OctreeEncodeCacheKey, QByteArray>::const_iterator entry = _entries.constFind(key);
+    bool found = (entry != _entries.constEnd());
+    if (found) {
+        encoded = entry.value();
+    }
+    _lock.unlock();
+
+    if (found) {
+        _hits.fetchAndAddRelaxed(1);
+    } else {
+        _misses.fetchAndAddRelaxed(1);
+    }
+    return found;
+}
+
+void OctreeEncodeCache::insert(const OctreeEncodeCacheKey& key, const QByteArray& encoded) {
+    QWriteLocker locker(&_lock);
+    if (_entries.contains(key)) {
+        // another thread encoded the same subtree for the same bucket while we were
+        return;
+    }
+    _entries.insert(key, encoded);
+    _insertionOrder.enqueue(key);
+    _bytes += encoded.size();
+
+    while (_bytes > _maxBytes && !_insertionOrder.isEmpty()) {
+        _bytes -= _entries.take(_insertionOrder.dequeue()).size();
+    }
+}
+
+int OctreeEncodeCache::getNumEntries() {
+    QReadLocker locker(&_lock);
+    return _entries.size();
+}
+
+int OctreeEncodeCache::getBytes() {
+    QReadLocker locker(&_lock);
+    return _bytes;
+}
@@ -0,0 +1,93 @@
+//
+//  OctreeEncodeCache.h
+//  assignment-client/src/octree
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Encoded subtrees shared between the sending threads of clients that see the same thing.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_OctreeEncodeCache_h
+#define hifi_OctreeEncodeCache_h
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QQueue>
+#include <QtCore/QReadWriteLock>
+
+#include <OctreeElement.h>
+#include <ViewFrustum.h>
+
+// views are bucketed well inside what ViewFrustum::isVerySimilar already treats as the same view
+const float ENCODE_CACHE_POSITION_BUCKET_SIZE = 2.0f; // meters
+const float ENCODE_CACHE_ORIENTATION_BUCKET_SIZE = 4.0f; // degrees, for each euler angle
+
+/// Identifies one subtree encoded against one view bucket. Everything else that goes into an encode either has to be
+/// the same for every client (no delta, no occlusion culling, full scene) or is part of the key.
+class OctreeEncodeCacheKey {
+public:
+    OctreeEncodeCacheKey();
+
+    /// buckets the client's view and LOD, the subtree is filled in later with setSubTree
+    OctreeEncodeCacheKey(const ViewFrustum& viewFrustum, float octreeSizeScale, int boundaryLevelAdjust,
+                         bool includeColor);
+
+    void setSubTree(OctreeElement* subTree);
+
+    /// sets up viewFrustum, a copy of the client's, to look from the center of this key's bucket. Cached subtrees are
+    /// encoded against it so every client in the bucket gets the same bytes.
+    void calculateBucketViewFrustum(ViewFrustum& viewFrustum) const;
+
+    bool operator==(const OctreeEncodeCacheKey& other) const;
+
+    OctreeElement* subTree;
+    quint64 lastChanged;
+
+    int positionBucket[3];
+    int orientationBucket[3];
+    float fieldOfView;
+    float aspectRatio;
+    float nearClip;
+    float farClip;
+    glm::vec3 eyeOffsetPosition;
+
+    float octreeSizeScale;
+    int boundaryLevelAdjust;
+    bool includeColor;
+};
+
+uint qHash(const OctreeEncodeCacheKey& key, uint seed = 0);
+
+/// The uncompressed bytes of subtrees that were encoded in full, shared by every OctreeSendThread of a server.
+/// A subtree's entry stops being found as soon as the subtree changes, since its last changed time is part of the
+/// key, and the oldest entries are dropped once the cache is over its size.
+class OctreeEncodeCache {
+public:
+    OctreeEncodeCache(int maxBytes);
+
+    /// returns true and sets encoded to the cached bytes if key has been encoded before
+    bool find(const OctreeEncodeCacheKey& key, QByteArray& encoded);
+    void insert(const OctreeEncodeCacheKey& key, const QByteArray& encoded);
+
+    int getHits() const { return _hits.loadAcquire(); }
+    int getMisses() const { return _misses.loadAcquire(); }
+    int getNumEntries();
+    int getBytes();
+
+private:
+    int _maxBytes;
+
+    QReadWriteLock _lock;
+    QHash<OctreeEncodeCacheKey, QByteArray> _entries;
+    QQueue<OctreeEncodeCacheKey> _insertionOrder;
+    int _bytes;
+
+    QAtomicInt _hits;
+    QAtomicInt _misses;
+};
+
+#endif // hifi_OctreeEncodeCache_h
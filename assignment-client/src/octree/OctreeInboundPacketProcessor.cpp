@@ -20,9 +20,11 @@
 static QUuid DEFAULT_NODE_ID_REF;
 const quint64 TOO_LONG_SINCE_LAST_NACK = 1 * USECS_PER_SECOND;
 
-OctreeInboundPacketProcessor::OctreeInboundPacketProcessor(OctreeServer* myServer) :
+OctreeInboundPacketProcessor::OctreeInboundPacketProcessor(OctreeServer* myServer, int numShards) :
+    ReceivedPacketProcessor(numShards),
     _myServer(myServer),
     _receivedPacketCount(0),
+    _statsMutex(),
     _totalTransitTime(0),
     _totalProcessTime(0),
     _totalLockWaitTime(0),
@@ -34,6 +36,7 @@ OctreeInboundPacketProcessor::OctreeInboundPacketProcessor(OctreeServer* myServe
 }
 
 void OctreeInboundPacketProcessor::resetStats() {
+    QMutexLocker locker(&_statsMutex);
     _totalTransitTime = 0;
     _totalProcessTime = 0;
     _totalLockWaitTime = 0;
@@ -91,7 +94,7 @@ void OctreeInboundPacketProcessor::processPacket(const SharedNodePointer& sendin
     PacketType packetType = packetTypeForPacket(packet);
     if (_myServer->getOctree()->handlesEditPacketType(packetType)) {
         PerformanceWarning warn(debugProcessPacket, "processPacket KNOWN TYPE",debugProcessPacket);
-        _receivedPacketCount++;
+        int receivedPacketCount = _receivedPacketCount.fetchAndAddRelaxed(1) + 1;
         
         const unsigned char* packetData = reinterpret_cast<const unsigned char*>(packet.data());
 
@@ -104,7 +107,7 @@ void OctreeInboundPacketProcessor::processPacket(const SharedNodePointer& sendin
         quint64 lockWaitTime = 0;
 
         if (_myServer->wantsDebugReceiving()) {
-            qDebug() << "PROCESSING THREAD: got '" << packetType << "' packet - " << _receivedPacketCount
+            qDebug() << "PROCESSING THREAD: got '" << packetType << "' packet - " << receivedPacketCount
                     << " command from client receivedBytes=" << packet.size()
                     << " sequence=" << sequence << " transitTime=" << transitTime << " usecs";
         }
@@ -167,6 +170,7 @@ void OctreeInboundPacketProcessor::processPacket(const SharedNodePointer& sendin
 
 void OctreeInboundPacketProcessor::trackInboundPacket(const QUuid& nodeUUID, unsigned short int sequence, quint64 transitTime,
             int editsInPacket, quint64 processTime, quint64 lockWaitTime) {
+    QMutexLocker locker(&_statsMutex);
 
     _totalTransitTime += transitTime;
     _totalProcessTime += processTime;
@@ -195,7 +199,8 @@ int OctreeInboundPacketProcessor::sendNackPackets() {
     }
 
     char packet[MAX_PACKET_SIZE];
-    
+
+    QMutexLocker locker(&_statsMutex);
     NodeToSenderStatsMapIterator i = _singleSenderStats.begin();
     while (i != _singleSenderStats.end()) {
 
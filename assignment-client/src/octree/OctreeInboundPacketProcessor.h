@@ -55,10 +55,12 @@ typedef QHash<QUuid, SingleSenderStats>::const_iterator NodeToSenderStatsMapCons
 
 /// Handles processing of incoming network packets for the voxel-server. As with other ReceivedPacketProcessor classes 
 /// the user is responsible for reading inbound packets and adding them to the processing queue by calling queueReceivedPacket()
+/// With more than one shard, edits from different senders are parsed on different threads but still take turns
+/// holding the tree's write lock.
 class OctreeInboundPacketProcessor : public ReceivedPacketProcessor {
     Q_OBJECT
 public:
-    OctreeInboundPacketProcessor(OctreeServer* myServer);
+    OctreeInboundPacketProcessor(OctreeServer* myServer, int numShards = 1);
 
     quint64 getAverageTransitTimePerPacket() const { return _totalPackets == 0 ? 0 : _totalTransitTime / _totalPackets; }
     quint64 getAverageProcessTimePerPacket() const { return _totalPackets == 0 ? 0 : _totalProcessTime / _totalPackets; }
@@ -92,7 +94,10 @@ private:
             int voxelsInPacket, quint64 processTime, quint64 lockWaitTime);
 
     OctreeServer* _myServer;
-    int _receivedPacketCount;
+    QAtomicInt _receivedPacketCount;
+
+    // the shards all track their packets here, and the first one sends the nacks
+    QMutex _statsMutex;
     
     quint64 _totalTransitTime; 
     quint64 _totalProcessTime;
@@ -0,0 +1,185 @@
+//
+//  OctreeParallelEncoder.cpp
+//  assignment-client/src/octree
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <algorithm>
+
+#include <QtCore/QMutex>
+#include <QtCore/QRunnable>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QWaitCondition>
+
+#include <ViewFrustum.h>
+
+#include "OctreeParallelEncoder.h"
+
+/// One call to encodeSubtrees. The pool's jobs share it with the calling thread, and a job the pool only gets to
+/// after the call returned finds it finished and leaves without touching anything else.
+class OctreeParallelEncodeRun {
+public:
+    OctreeParallelEncodeRun(Octree* tree, const EncodeBitstreamParams& params, int targetSize, int maxBytes,
+                            OctreePreEncodedSubtrees* encoded);
+
+    /// takes subtrees from the queue and encodes them until there's nothing left that anyone could add to
+    void work();
+
+    Octree* tree;
+    ViewFrustum viewFrustum;
+    EncodeBitstreamParams params;
+    int targetSize;
+    int maxBytes;
+    OctreePreEncodedSubtrees* encoded;
+
+    // the queue and encoded are only touched with the tree locked for read, so deleted elements can't come and go
+    // from them underneath us, and with the mutex locked, so the threads taking part don't trip over each other
+    QMutex mutex;
+    QWaitCondition changed;
+    OctreeElementBag pending;
+    int numEncoding;
+    bool isFinished;
+};
+
+typedef QSharedPointer<OctreeParallelEncodeRun> SharedEncodeRunPointer;
+
+OctreeParallelEncodeRun::OctreeParallelEncodeRun(Octree* tree, const EncodeBitstreamParams& params, int targetSize,
+                                                 int maxBytes, OctreePreEncodedSubtrees* encoded) :
+    tree(tree),
+    viewFrustum(*params.viewFrustum),
+    params(params),
+    targetSize(targetSize),
+    maxBytes(maxBytes),
+    encoded(encoded),
+    mutex(),
+    changed(),
+    pending(),
+    numEncoding(0),
+    isFinished(false)
+{
+    this->params.viewFrustum = &viewFrustum;
+    pending.setPriorityView(&viewFrustum);
+}
+
+void OctreeParallelEncodeRun::work() {
+    // each thread encodes against its own copy of the view, so the view never has to be read from two threads at once
+    ViewFrustum threadViewFrustum = viewFrustum;
+    EncodeBitstreamParams subtreeParams = params;
+    subtreeParams.viewFrustum = &threadViewFrustum;
+
+    OctreePacketData packetData(false, targetSize);
+    OctreeElementBag didntFitBag(false); // only used with the tree locked, and emptied before it's unlocked
+
+    while (true) {
+        tree->lockForRead();
+        mutex.lock();
+
+        if (isFinished) {
+            mutex.unlock();
+            tree->unlock();
+            break;
+        }
+
+        if (!pending.isEmpty() && encoded->getBytes() < maxBytes) {
+            OctreeElement* subtree = pending.extract();
+            numEncoding++;
+            mutex.unlock();
+
+            packetData.reset();
+            subtreeParams.maxLevelReached = 0;
+            subtreeParams.stopReason = EncodeBitstreamParams::UNKNOWN;
+            tree->encodeTreeBitstream(subtree, &packetData, didntFitBag, subtreeParams);
+
+            QByteArray subtreeEncoded(reinterpret_cast<const char*>(packetData.getUncompressedData()),
+                                      packetData.getUncompressedSize());
+            QVector<OctreeElement*> didntFit;
+            bool fitAtAll = true;
+            while (!didntFitBag.isEmpty()) {
+                OctreeElement* element = didntFitBag.extract();
+                if (element == subtree) {
+                    fitAtAll = false;
+                } else {
+                    didntFit.append(element);
+                }
+            }
+
+            mutex.lock();
+            // a subtree that doesn't fit an empty packet is left to the send thread, which splits it up as it goes
+            if (fitAtAll) {
+                encoded->insert(subtree, subtreeEncoded, didntFit);
+                foreach (OctreeElement* element, didntFit) {
+                    if (!encoded->contains(element)) {
+                        pending.insert(element);
+                    }
+                }
+            }
+            numEncoding--;
+            changed.wakeAll();
+            mutex.unlock();
+            tree->unlock();
+
+        } else if (numEncoding == 0) {
+            // nothing left to encode, and nobody encoding who could add more
+            isFinished = true;
+            changed.wakeAll();
+            mutex.unlock();
+            tree->unlock();
+            break;
+
+        } else {
+            // wait for what the others are encoding without holding up editors
+            tree->unlock();
+            changed.wait(&mutex);
+            mutex.unlock();
+        }
+    }
+}
+
+class OctreeParallelEncodeJob : public QRunnable {
+public:
+    OctreeParallelEncodeJob(const SharedEncodeRunPointer& run) : _run(run) { }
+
+    void run() { _run->work(); }
+
+private:
+    SharedEncodeRunPointer _run;
+};
+
+OctreeParallelEncoder::OctreeParallelEncoder(int numThreads) :
+    _numThreads(std::max(numThreads, 1)),
+    _threadPool()
+{
+    // the thread that asks for an encode does its share, so the pool only needs threads for the others
+    // and we keep those threads around for the life of the server instead of respawning them for each scene
+    _threadPool.setMaxThreadCount(std::max(1, _numThreads - 1));
+    _threadPool.setExpiryTimeout(-1);
+}
+
+OctreeParallelEncoder::~OctreeParallelEncoder() {
+    _threadPool.waitForDone();
+}
+
+void OctreeParallelEncoder::encodeSubtrees(Octree* tree, OctreeElementBag& frontier,
+                                           const EncodeBitstreamParams& params, int targetSize, int maxBytes,
+                                           OctreePreEncodedSubtrees& encoded) {
+    SharedEncodeRunPointer run(new OctreeParallelEncodeRun(tree, params, targetSize, maxBytes, &encoded));
+
+    tree->lockForRead();
+    int numSubtrees = frontier.count();
+    while (!frontier.isEmpty()) {
+        run->pending.insert(frontier.extract());
+    }
+    tree->unlock();
+
+    // we don't start more jobs than there are subtrees to go around, and this thread is one of them
+    int numJobs = std::min(_numThreads, numSubtrees) - 1;
+    for (int i = 0; i < numJobs; i++) {
+        _threadPool.start(new OctreeParallelEncodeJob(run));
+    }
+
+    run->work();
+}
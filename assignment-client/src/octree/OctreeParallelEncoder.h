@@ -0,0 +1,44 @@
+//
+//  OctreeParallelEncoder.h
+//  assignment-client/src/octree
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Encodes the subtrees of a client's scene ahead of time on a pool of threads shared by all the send threads.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_OctreeParallelEncoder_h
+#define hifi_OctreeParallelEncoder_h
+
+#include <QtCore/QThreadPool>
+
+#include <Octree.h>
+#include <OctreeElementBag.h>
+
+#include "OctreePreEncodedSubtrees.h"
+
+/// The subtrees given to encodeSubtrees go in one queue, biggest in view first, that the calling thread and the
+/// pool's threads take from until it's empty. Whatever doesn't fit when a subtree is encoded goes back in the queue,
+/// so a thread that drew a small subtree comes back for more while the others are still busy with big ones.
+class OctreeParallelEncoder {
+public:
+    OctreeParallelEncoder(int numThreads);
+    ~OctreeParallelEncoder();
+
+    int getNumThreads() const { return _numThreads; }
+
+    /// encodes the subtrees in frontier, and the subtrees below them that don't fit, into encoded, each into its own
+    /// packet of targetSize, until they're all encoded or encoded holds maxBytes. Blocks until it's done, which it
+    /// does sooner the fewer other clients are using the pool. The tree is locked for read around each subtree.
+    void encodeSubtrees(Octree* tree, OctreeElementBag& frontier, const EncodeBitstreamParams& params, int targetSize,
+                        int maxBytes, OctreePreEncodedSubtrees& encoded);
+
+private:
+    int _numThreads;
+    QThreadPool _threadPool;
+};
+
+#endif // hifi_OctreeParallelEncoder_h
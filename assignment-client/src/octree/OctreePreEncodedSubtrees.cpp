@@ -0,0 +1,111 @@
+//
+//  OctreePreEncodedSubtrees.cpp
+//  assignment-client/src/octree
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "OctreePreEncodedSubtrees.h"
+
+OctreePreEncodedSubtrees::OctreePreEncodedSubtrees() :
+    _subtrees(),
+    _didntFitIn(),
+    _bytes(0),
+    _isPreEncodingWanted(false)
+{
+    OctreeElement::addDeleteHook(this);
+    _hooked = true;
+}
+
+OctreePreEncodedSubtrees::~OctreePreEncodedSubtrees() {
+    unhookNotifications();
+}
+
+void OctreePreEncodedSubtrees::unhookNotifications() {
+    if (_hooked) {
+        OctreeElement::removeDeleteHook(this);
+        _hooked = false;
+    }
+}
+
+void OctreePreEncodedSubtrees::elementDeleted(OctreeElement* element) {
+    remove(element);
+
+    // a subtree that left this element for later can't be appended, the element would go in the bag
+    foreach (OctreeElement* subtree, _didntFitIn.values(element)) {
+        remove(subtree);
+    }
+}
+
+void OctreePreEncodedSubtrees::startScene(bool wantPreEncoding) {
+    _subtrees.clear();
+    _didntFitIn.clear();
+    _bytes = 0;
+    _isPreEncodingWanted = wantPreEncoding;
+}
+
+void OctreePreEncodedSubtrees::insert(OctreeElement* subtree, const QByteArray& encoded,
+                                      const QVector<OctreeElement*>& didntFit) {
+    remove(subtree);
+
+    Subtree& stored = _subtrees[subtree];
+    stored.encoded = encoded;
+    stored.didntFit = didntFit;
+    stored.lastChanged = subtree->getLastChanged();
+
+    foreach (OctreeElement* element, didntFit) {
+        _didntFitIn.insert(element, subtree);
+    }
+    _bytes += encoded.size();
+}
+
+OctreePreEncodedSubtrees::AppendResult OctreePreEncodedSubtrees::append(OctreeElement* subtree,
+                                                                        OctreePacketData& packetData,
+                                                                        OctreeElementBag& bag, int& bytesWritten) {
+    QHash<OctreeElement*, Subtree>::const_iterator stored = _subtrees.constFind(subtree);
+    if (stored == _subtrees.constEnd()) {
+        return NOT_ENCODED;
+    }
+
+    // changes mark their ancestors, so anything changed below the subtree since it was encoded shows up here
+    if (stored->lastChanged != subtree->getLastChanged()) {
+        remove(subtree);
+        return NOT_ENCODED;
+    }
+
+    if (!packetData.appendRawData(reinterpret_cast<const unsigned char*>(stored->encoded.constData()),
+                                  stored->encoded.size())) {
+        if (packetData.hasContent()) {
+            bytesWritten = 0;
+            bag.insert(subtree);
+            return DIDNT_FIT;
+        }
+
+        // the packet is set up smaller than the one it was encoded for, so it won't fit however long we wait
+        remove(subtree);
+        return NOT_ENCODED;
+    }
+
+    bytesWritten = stored->encoded.size();
+    foreach (OctreeElement* element, stored->didntFit) {
+        bag.insert(element);
+    }
+    remove(subtree);
+    return APPENDED;
+}
+
+void OctreePreEncodedSubtrees::remove(OctreeElement* subtree) {
+    QHash<OctreeElement*, Subtree>::iterator stored = _subtrees.find(subtree);
+    if (stored == _subtrees.end()) {
+        return;
+    }
+
+    foreach (OctreeElement* element, stored->didntFit) {
+        _didntFitIn.remove(element, subtree);
+    }
+    _bytes -= stored->encoded.size();
+    _subtrees.erase(stored);
+}
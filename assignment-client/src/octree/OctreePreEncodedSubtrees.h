@@ -0,0 +1,79 @@
+//
+//  OctreePreEncodedSubtrees.h
+//  assignment-client/src/octree
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Subtrees of one client's scene that were encoded ahead of time, ready to be appended to its packets.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_OctreePreEncodedSubtrees_h
+#define hifi_OctreePreEncodedSubtrees_h
+
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QMultiHash>
+#include <QtCore/QVector>
+
+#include <OctreeElement.h>
+#include <OctreeElementBag.h>
+#include <OctreePacketData.h>
+
+// a client's scene is encoded ahead until this much is waiting to be sent, the rest is encoded once that's gone out
+const int MAX_PRE_ENCODED_BYTES = 4 * 1024 * 1024;
+
+/// Each subtree in here is encoded the way it would be into an empty packet, along with the subtrees below it that
+/// didn't fit and were left for later. The send thread appends these instead of encoding the subtrees itself, for as
+/// long as nothing in them changes.
+class OctreePreEncodedSubtrees : public OctreeElementDeleteHook {
+public:
+    enum AppendResult {
+        NOT_ENCODED,
+        APPENDED,
+        DIDNT_FIT
+    };
+
+    OctreePreEncodedSubtrees();
+    ~OctreePreEncodedSubtrees();
+
+    /// forgets everything encoded for the last scene, wantPreEncoding says whether the new one should be encoded ahead
+    void startScene(bool wantPreEncoding);
+    bool isPreEncodingWanted() const { return _isPreEncodingWanted; }
+
+    bool contains(OctreeElement* subtree) const { return _subtrees.contains(subtree); }
+
+    /// stores what encoding subtree wrote and the subtrees below it that didn't fit, the tree must be locked for read
+    void insert(OctreeElement* subtree, const QByteArray& encoded, const QVector<OctreeElement*>& didntFit);
+
+    /// appends subtree to packetData and puts the subtrees below it that didn't fit in bag, as encoding it would.
+    /// Returns NOT_ENCODED if subtree has to be encoded after all, or DIDNT_FIT if packetData doesn't have room for it,
+    /// in which case subtree is put back in bag.
+    AppendResult append(OctreeElement* subtree, OctreePacketData& packetData, OctreeElementBag& bag, int& bytesWritten);
+
+    int getNumSubtrees() const { return _subtrees.size(); }
+    int getBytes() const { return _bytes; }
+
+    virtual void elementDeleted(OctreeElement* element);
+    void unhookNotifications();
+
+private:
+    class Subtree {
+    public:
+        QByteArray encoded;
+        QVector<OctreeElement*> didntFit;
+        quint64 lastChanged;
+    };
+
+    void remove(OctreeElement* subtree);
+
+    QHash<OctreeElement*, Subtree> _subtrees;
+    QMultiHash<OctreeElement*, OctreeElement*> _didntFitIn; // the subtrees each element didn't fit in
+    int _bytes;
+    bool _isPreEncodingWanted;
+    bool _hooked;
+};
+
+#endif // hifi_OctreePreEncodedSubtrees_h
@@ -44,6 +44,8 @@ OctreeQueryNode::OctreeQueryNode() :
     _isShuttingDown(false),
     _sentPacketHistory()
 {
+    // send whatever looks biggest to this client first, the send thread re-prioritizes what's left when the view moves
+    nodeBag.setPriorityView(&_currentViewFrustum);
 }
 
 OctreeQueryNode::~OctreeQueryNode() {
@@ -59,6 +61,8 @@ OctreeQueryNode::~OctreeQueryNode() {
 void OctreeQueryNode::nodeKilled() {
     _isShuttingDown = true;
     nodeBag.unhookNotifications(); // if our node is shutting down, then we no longer need octree element notifications
+    sentSubtrees.unhookNotifications();
+    preEncodedSubtrees.unhookNotifications();
     if (_octreeSendThread) {
         // just tell our thread we want to shutdown, this is asynchronous, and fast, we don't need or want it to block
         // while the thread actually shuts down
@@ -69,6 +73,8 @@ void OctreeQueryNode::nodeKilled() {
 void OctreeQueryNode::forceNodeShutdown() {
     _isShuttingDown = true;
     nodeBag.unhookNotifications(); // if our node is shutting down, then we no longer need octree element notifications
+    sentSubtrees.unhookNotifications();
+    preEncodedSubtrees.unhookNotifications();
     if (_octreeSendThread) {
         // we really need to force our thread to shutdown, this is synchronous, we will block while the thread actually 
         // shuts down because we really need it to shutdown, and it's ok if we wait for it to complete
@@ -23,6 +23,8 @@
 #include <OctreeQuery.h>
 #include <OctreeSceneStats.h>
 #include <ThreadedAssignment.h> // for SharedAssignmentPointer
+#include "OctreePreEncodedSubtrees.h"
+#include "OctreeSentSubtrees.h"
 #include "SentPacketHistory.h"
 #include <qqueue.h>
 
@@ -57,6 +59,8 @@ public:
     void setMaxLevelReached(int maxLevelReached) { _maxLevelReachedInLastSearch = maxLevelReached; }
 
     OctreeElementBag nodeBag;
+    OctreeSentSubtrees sentSubtrees;
+    OctreePreEncodedSubtrees preEncodedSubtrees;
     CoverageMap map;
 
     ViewFrustum& getCurrentViewFrustum() { return _currentViewFrustum; }
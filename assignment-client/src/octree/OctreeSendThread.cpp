@@ -305,6 +305,10 @@ int OctreeSendThread::packetDistributor(OctreeQueryNode* nodeData, bool viewFrus
     // FOR NOW... node tells us if it wants to receive only view frustum deltas
     bool wantDelta = viewFrustumChanged && nodeData->getWantDelta();
 
+    // incremental scenes send each subtree only what it's missing since the view it was last sent at, instead of
+    // starting over from the root whenever the view changes
+    bool incrementalScenes = _myServer->wantIncrementalScenes() && !nodeData->getWantDelta();
+
     // If our packet already has content in it, then we must use the color choice of the waiting packet.
     // If we're starting a fresh packet, then...
     //     If we're moving, and the client asked for low res, then we force monochrome, otherwise, use
@@ -335,10 +339,15 @@ int OctreeSendThread::packetDistributor(OctreeQueryNode* nodeData, bool viewFrus
 
         // if our view has changed, we need to reset these things...
         if (viewFrustumChanged) {
-            if (nodeData->moveShouldDump() || nodeData->hasLodChanged()) {
+            if (!incrementalScenes && (nodeData->moveShouldDump() || nodeData->hasLodChanged())) {
                 nodeData->dumpOutOfView();
             }
             nodeData->map.erase();
+
+            // what's left in the bag was prioritized for the old view, so what's most visible now has to be put first
+            _myServer->getOctree()->lockForRead();
+            nodeData->nodeBag.reprioritize();
+            _myServer->getOctree()->unlock();
         }
 
         if (!viewFrustumChanged && !nodeData->getWantDelta()) {
@@ -361,7 +370,7 @@ int OctreeSendThread::packetDistributor(OctreeQueryNode* nodeData, bool viewFrus
         packetsSentThisInterval += packetsJustSent;
 
         // If we're starting a full scene, then definitely we want to empty the nodeBag
-        if (isFullScene) {
+        if (isFullScene || incrementalScenes) {
             nodeData->nodeBag.deleteAll();
         }
 
@@ -372,14 +381,25 @@ int OctreeSendThread::packetDistributor(OctreeQueryNode* nodeData, bool viewFrus
         nodeData->stats.sceneStarted(isFullScene, viewFrustumChanged, _myServer->getOctree()->getRoot(), _myServer->getJurisdiction());
 
         // This is the start of "resending" the scene.
-        bool dontRestartSceneOnMove = false; // this is experimental
-        if (dontRestartSceneOnMove) {
-            if (nodeData->nodeBag.isEmpty()) {
-                nodeData->nodeBag.insert(_myServer->getOctree()->getRoot()); // only in case of empty
-            }
+        _myServer->getOctree()->lockForRead();
+        bool sceneSentInFull = isFullScene && !wantDelta;
+        if (incrementalScenes) {
+            // only the root and the subtrees that were sent at other views go back in the bag
+            nodeData->sentSubtrees.startScene(nodeData->getCurrentViewFrustum(), nodeData->getOctreeSizeScale(),
+                                              nodeData->getBoundaryLevelAdjust());
+            nodeData->sentSubtrees.enqueueSubtrees(_myServer->getOctree()->getRoot(), nodeData->nodeBag);
+            sceneSentInFull = !nodeData->sentSubtrees.getSentView(_myServer->getOctree()->getRoot());
         } else {
             nodeData->nodeBag.insert(_myServer->getOctree()->getRoot()); // original behavior, reset on move or empty
         }
+
+        // a scene sent in full, like a client's first one or the one after it jumps somewhere new, can be encoded
+        // ahead on the server's encode threads. Scenes that only send what changed are left to this thread as before,
+        // and so are the ones clients can share through the encode cache.
+        nodeData->preEncodedSubtrees.startScene(_myServer->getParallelEncoder() && sceneSentInFull
+                                                && !nodeData->getWantOcclusionCulling()
+                                                && (incrementalScenes || !_myServer->getEncodeCache()));
+        _myServer->getOctree()->unlock();
     }
 
     // If we have something in our nodeBag, then turn them into packets and send them out...
@@ -391,6 +411,69 @@ int OctreeSendThread::packetDistributor(OctreeQueryNode* nodeData, bool viewFrus
         //quint64 startCompressTimeMsecs = OctreePacketData::getCompressContentTime() / 1000;
         //quint64 startCompressCalls = OctreePacketData::getCompressContentCalls();
 
+        bool wantOcclusionCulling = nodeData->getWantOcclusionCulling();
+        CoverageMap* coverageMap = wantOcclusionCulling ? &nodeData->map : IGNORE_COVERAGE_MAP;
+
+        float voxelSizeScale = nodeData->getOctreeSizeScale();
+        int boundaryLevelAdjustClient = nodeData->getBoundaryLevelAdjust();
+
+        // incremental scenes only send what's new while moving, so they stay at the client's level of detail
+        int boundaryLevelAdjust = boundaryLevelAdjustClient + (viewFrustumChanged && nodeData->getWantLowResMoving()
+                                                               && !incrementalScenes
+                                                               ? LOW_RES_MOVING_ADJUST : NO_BOUNDARY_ADJUST);
+
+        // A full scene without deltas or occlusion culling only depends on the view, so clients whose views fall in
+        // the same bucket can share encoded subtrees. Those are encoded against the bucket's view, not our own.
+        OctreeEncodeCache* encodeCache = _myServer->getEncodeCache();
+        bool useEncodeCache = encodeCache && isFullScene && !wantDelta && !wantOcclusionCulling && !incrementalScenes;
+        OctreeEncodeCacheKey encodeCacheKey;
+        ViewFrustum bucketViewFrustum;
+        const ViewFrustum* encodeViewFrustum = &nodeData->getCurrentViewFrustum();
+        if (useEncodeCache) {
+            encodeCacheKey = OctreeEncodeCacheKey(nodeData->getCurrentViewFrustum(), voxelSizeScale,
+                                                  boundaryLevelAdjust, wantColor);
+            bucketViewFrustum = nodeData->getCurrentViewFrustum();
+            encodeCacheKey.calculateBucketViewFrustum(bucketViewFrustum);
+            encodeViewFrustum = &bucketViewFrustum;
+        }
+
+        // encode what's in the bag, and whatever doesn't fit when it's encoded, ahead on the encode threads, so the
+        // loop below only has to append it. More is encoded once most of what was encoded ahead has gone out.
+        OctreeParallelEncoder* parallelEncoder = _myServer->getParallelEncoder();
+        if (parallelEncoder && nodeData->preEncodedSubtrees.isPreEncodingWanted()
+                && nodeData->nodeBag.count() >= parallelEncoder->getNumThreads()) {
+            OctreeElementBag frontier;
+
+            _myServer->getOctree()->lockForRead();
+            if (nodeData->preEncodedSubtrees.getBytes() < MAX_PRE_ENCODED_BYTES / 4) {
+                foreach (OctreeElement* element, nodeData->nodeBag.getElements()) {
+                    // subtrees sent at an earlier view are encoded as deltas from it, which is left to the loop
+                    if (!nodeData->preEncodedSubtrees.contains(element)
+                            && !(incrementalScenes && nodeData->sentSubtrees.getSentView(element))) {
+                        frontier.insert(element);
+                    }
+                }
+            }
+            _myServer->getOctree()->unlock();
+
+            if (frontier.count() >= parallelEncoder->getNumThreads()) {
+                EncodeBitstreamParams params(INT_MAX, encodeViewFrustum, wantColor,
+                                             WANT_EXISTS_BITS, DONT_CHOP, wantDelta, lastViewFrustum,
+                                             wantOcclusionCulling, coverageMap, boundaryLevelAdjust, voxelSizeScale,
+                                             nodeData->getLastTimeBagEmpty(),
+                                             isFullScene || incrementalScenes, IGNORE_SCENE_STATS,
+                                             _myServer->getJurisdiction());
+
+                // each subtree is encoded as it would be into an empty packet
+                int targetSize = MAX_OCTREE_PACKET_DATA_SIZE;
+                if (wantCompression) {
+                    targetSize -= sizeof(OCTREE_PACKET_INTERNAL_SECTION_SIZE);
+                }
+                parallelEncoder->encodeSubtrees(_myServer->getOctree(), frontier, params, targetSize,
+                                                MAX_PRE_ENCODED_BYTES, nodeData->preEncodedSubtrees);
+            }
+        }
+
         int extraPackingAttempts = 0;
         bool completedScene = false;
         while (somethingToSend && packetsSentThisInterval < maxPacketsPerInterval && !nodeData->isShuttingDown()) {
@@ -426,16 +509,7 @@ int OctreeSendThread::packetDistributor(OctreeQueryNode* nodeData, bool viewFrus
                 }
                 */
 
-                bool wantOcclusionCulling = nodeData->getWantOcclusionCulling();
-                CoverageMap* coverageMap = wantOcclusionCulling ? &nodeData->map : IGNORE_COVERAGE_MAP;
-                
-                float voxelSizeScale = nodeData->getOctreeSizeScale();
-                int boundaryLevelAdjustClient = nodeData->getBoundaryLevelAdjust();
-                
-                int boundaryLevelAdjust = boundaryLevelAdjustClient + (viewFrustumChanged && nodeData->getWantLowResMoving()
-                                                                       ? LOW_RES_MOVING_ADJUST : NO_BOUNDARY_ADJUST);
-                
-                EncodeBitstreamParams params(INT_MAX, &nodeData->getCurrentViewFrustum(), wantColor,
+                EncodeBitstreamParams params(INT_MAX, encodeViewFrustum, wantColor,
                                              WANT_EXISTS_BITS, DONT_CHOP, wantDelta, lastViewFrustum,
                                              wantOcclusionCulling, coverageMap, boundaryLevelAdjust, voxelSizeScale,
                                              nodeData->getLastTimeBagEmpty(),
@@ -451,8 +525,55 @@ int OctreeSendThread::packetDistributor(OctreeQueryNode* nodeData, bool viewFrus
                 quint64 lockWaitEnd = usecTimestampNow();
                 lockWaitElapsedUsec = (float)(lockWaitEnd - lockWaitStart);
 
+                OctreeElementBag* encodeBag = &nodeData->nodeBag;
+                if (incrementalScenes) {
+                    // send the subtree as a delta from the view it was last sent at, or in full if it never was
+                    const OctreeSentView* sentView = nodeData->sentSubtrees.getSentView(subTree);
+                    params.deltaViewFrustum = (sentView != NULL);
+                    params.lastViewFrustum = sentView ? &sentView->viewFrustum : NULL;
+                    params.lastViewFrustumSent = sentView ? sentView->sentTime : params.lastViewFrustumSent;
+                    params.forceSendScene = (sentView == NULL);
+                    encodeBag = &nodeData->sentSubtrees.getDeferredBag();
+                }
+
                 quint64 encodeStart = usecTimestampNow();
-                bytesWritten = _myServer->getOctree()->encodeTreeBitstream(subTree, &_packetData, nodeData->nodeBag, params);
+                QByteArray cachedSubTree;
+                if (useEncodeCache) {
+                    encodeCacheKey.setSubTree(subTree);
+                }
+                if (useEncodeCache && encodeCache->find(encodeCacheKey, cachedSubTree) &&
+                        _packetData.appendRawData(reinterpret_cast<const unsigned char*>(cachedSubTree.constData()),
+                                                  cachedSubTree.size())) {
+                    bytesWritten = cachedSubTree.size();
+                } else {
+                    // a subtree encoded ahead was encoded in full, so it's only used when this one is too
+                    OctreePreEncodedSubtrees::AppendResult preEncoded = OctreePreEncodedSubtrees::NOT_ENCODED;
+                    if (!params.deltaViewFrustum) {
+                        preEncoded = nodeData->preEncodedSubtrees.append(subTree, _packetData, *encodeBag,
+                                                                         bytesWritten);
+                    }
+
+                    if (preEncoded == OctreePreEncodedSubtrees::DIDNT_FIT) {
+                        params.stopReason = EncodeBitstreamParams::DIDNT_FIT;
+                    } else if (preEncoded == OctreePreEncodedSubtrees::NOT_ENCODED) {
+                        int bagCountBefore = nodeData->nodeBag.count();
+                        int uncompressedSizeBefore = _packetData.getUncompressedSize();
+
+                        bytesWritten = _myServer->getOctree()->encodeTreeBitstream(subTree, &_packetData,
+                                                                                   *encodeBag, params);
+
+                        // only a subtree that was encoded in full can be shared, anything that didn't fit went in
+                        // our bag
+                        int encodedSize = _packetData.getUncompressedSize() - uncompressedSizeBefore;
+                        if (useEncodeCache && encodedSize > 0 && nodeData->nodeBag.count() == bagCountBefore) {
+                            encodeCache->insert(encodeCacheKey, QByteArray(reinterpret_cast<const char*>(
+                                _packetData.getUncompressedData() + uncompressedSizeBefore), encodedSize));
+                        }
+                    }
+                }
+                if (incrementalScenes) {
+                    nodeData->sentSubtrees.subtreeSent(subTree, nodeData->nodeBag);
+                }
                 quint64 encodeEnd = usecTimestampNow();
                 encodeElapsedUsec = (float)(encodeEnd - encodeStart);
                 
@@ -595,6 +716,11 @@ int OctreeSendThread::packetDistributor(OctreeQueryNode* nodeData, bool viewFrus
         // if after sending packets we've emptied our bag, then we want to remember that we've sent all
         // the voxels from the current view frustum
         if (nodeData->nodeBag.isEmpty()) {
+            if (incrementalScenes) {
+                _myServer->getOctree()->lockForRead();
+                nodeData->sentSubtrees.sceneCompleted(_myServer->getOctree()->getRoot());
+                _myServer->getOctree()->unlock();
+            }
             nodeData->updateLastKnownViewFrustum();
             nodeData->setViewSent(true);
             nodeData->map.erase(); // It would be nice if we could save this, and only reset it when the view frustum changes
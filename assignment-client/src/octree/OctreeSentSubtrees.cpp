@@ -0,0 +1,116 @@
+//
+//  OctreeSentSubtrees.cpp
+//  assignment-client/src/octree
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <SharedUtil.h>
+
+#include "OctreeSentSubtrees.h"
+
+OctreeSentView::OctreeSentView(const ViewFrustum& viewFrustum, float octreeSizeScale, int boundaryLevelAdjust,
+                               quint64 sentTime) :
+    viewFrustum(viewFrustum),
+    octreeSizeScale(octreeSizeScale),
+    boundaryLevelAdjust(boundaryLevelAdjust),
+    sentTime(sentTime)
+{
+
+}
+
+OctreeSentSubtrees::OctreeSentSubtrees() :
+    _sentViews(),
+    _currentView(),
+    _deferredBag()
+{
+    OctreeElement::addDeleteHook(this);
+    _hooked = true;
+}
+
+OctreeSentSubtrees::~OctreeSentSubtrees() {
+    unhookNotifications();
+}
+
+void OctreeSentSubtrees::unhookNotifications() {
+    if (_hooked) {
+        OctreeElement::removeDeleteHook(this);
+        _hooked = false;
+    }
+    _deferredBag.unhookNotifications();
+}
+
+void OctreeSentSubtrees::elementDeleted(OctreeElement* element) {
+    _sentViews.remove(element);
+}
+
+void OctreeSentSubtrees::startScene(const ViewFrustum& viewFrustum, float octreeSizeScale, int boundaryLevelAdjust) {
+    // deltas are encoded at the current level of detail, so they can't be taken from views sent at another one
+    if (_currentView && (_currentView->octreeSizeScale != octreeSizeScale ||
+                         _currentView->boundaryLevelAdjust != boundaryLevelAdjust)) {
+        reset();
+    }
+    _currentView = SharedSentViewPointer(new OctreeSentView(viewFrustum, octreeSizeScale, boundaryLevelAdjust,
+                                                            usecTimestampNow()));
+}
+
+void OctreeSentSubtrees::enqueueSubtrees(OctreeElement* root, OctreeElementBag& bag) {
+    bag.insert(root);
+
+    // anything out of view has nothing to send, it's picked up again by whichever scene sees it
+    QHash<OctreeElement*, SharedSentViewPointer>::const_iterator sentView = _sentViews.constBegin();
+    while (sentView != _sentViews.constEnd()) {
+        if (sentView.value() != _currentView && sentView.key()->isInView(_currentView->viewFrustum)) {
+            bag.insert(sentView.key());
+        }
+        ++sentView;
+    }
+}
+
+const OctreeSentView* OctreeSentSubtrees::getSentView(OctreeElement* subtree) const {
+    return _sentViews.value(subtree).data();
+}
+
+void OctreeSentSubtrees::subtreeSent(OctreeElement* subtree, OctreeElementBag& bag) {
+    SharedSentViewPointer previousView = _sentViews.value(subtree);
+    bool subtreeDeferred = false;
+
+    while (!_deferredBag.isEmpty()) {
+        OctreeElement* deferred = _deferredBag.extract();
+        if (deferred == subtree) {
+            // none of it fit, so none of it was sent
+            subtreeDeferred = true;
+        } else if (!_sentViews.contains(deferred)) {
+            // what didn't fit is only as sent as the subtree was before, a NULL view means it's sent in full
+            _sentViews.insert(deferred, previousView);
+        } else if (_sentViews.value(deferred) == _currentView) {
+            // it was already sent at this view on its own
+            continue;
+        }
+        bag.insert(deferred);
+    }
+
+    if (!subtreeDeferred) {
+        _sentViews.insert(subtree, _currentView);
+    }
+
+    if (_sentViews.size() > MAX_SENT_SUBTREES) {
+        // without a view for the root, the next scene sends everything in full and this starts over from there
+        _sentViews.clear();
+    }
+}
+
+void OctreeSentSubtrees::sceneCompleted(OctreeElement* root) {
+    _sentViews.clear();
+    if (_currentView) {
+        _sentViews.insert(root, _currentView);
+    }
+}
+
+void OctreeSentSubtrees::reset() {
+    _sentViews.clear();
+    _currentView.clear();
+}
@@ -0,0 +1,83 @@
+//
+//  OctreeSentSubtrees.h
+//  assignment-client/src/octree
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  What one client has been sent of each part of the tree, so a scene can pick up where the last one left off.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_OctreeSentSubtrees_h
+#define hifi_OctreeSentSubtrees_h
+
+#include <QtCore/QHash>
+#include <QtCore/QSharedPointer>
+
+#include <OctreeElement.h>
+#include <OctreeElementBag.h>
+#include <ViewFrustum.h>
+
+// past this many subtrees sent at different views the client is sent everything again, which starts over with one
+const int MAX_SENT_SUBTREES = 4096;
+
+/// A client that was sent a subtree at this view has everything in the subtree that was in the view and within this
+/// level of detail, as the subtree was at the sent time.
+class OctreeSentView {
+public:
+    OctreeSentView(const ViewFrustum& viewFrustum, float octreeSizeScale, int boundaryLevelAdjust, quint64 sentTime);
+
+    ViewFrustum viewFrustum;
+    float octreeSizeScale;
+    int boundaryLevelAdjust;
+    quint64 sentTime;
+};
+
+typedef QSharedPointer<OctreeSentView> SharedSentViewPointer;
+
+/// Each subtree in here was sent at its view, except for the subtrees below it that are in here too. The root is in
+/// here once anything has been sent. A scene puts the subtrees that weren't sent at its view in the client's bag,
+/// each one is encoded as a delta from its own view, and whatever doesn't fit keeps the view it had until it's sent.
+/// Once a scene's bag is empty the whole tree has been sent at its view, and this goes back to just the root.
+class OctreeSentSubtrees : public OctreeElementDeleteHook {
+public:
+    OctreeSentSubtrees();
+    ~OctreeSentSubtrees();
+
+    /// starts a scene at the client's current view, everything sent at another level of detail is forgotten
+    void startScene(const ViewFrustum& viewFrustum, float octreeSizeScale, int boundaryLevelAdjust);
+
+    /// puts the root, and every subtree in the current view that was sent at an earlier one, in bag
+    void enqueueSubtrees(OctreeElement* root, OctreeElementBag& bag);
+
+    /// the view subtree was last sent at, or NULL if it has to be sent in full
+    const OctreeSentView* getSentView(OctreeElement* subtree) const;
+
+    /// subtrees should be encoded into this bag, so the ones that don't fit can be told apart from the client's
+    OctreeElementBag& getDeferredBag() { return _deferredBag; }
+
+    /// records that subtree was sent at the current view, except for the deferred subtrees, which keep the view it
+    /// was sent at before and are moved to bag
+    void subtreeSent(OctreeElement* subtree, OctreeElementBag& bag);
+
+    /// the client's bag is empty, so the whole tree was sent at the current view
+    void sceneCompleted(OctreeElement* root);
+
+    /// forgets everything, so the next scene is sent in full
+    void reset();
+
+    int getNumSubtrees() const { return _sentViews.size(); }
+
+    virtual void elementDeleted(OctreeElement* element);
+    void unhookNotifications();
+
+private:
+    QHash<OctreeElement*, SharedSentViewPointer> _sentViews;
+    SharedSentViewPointer _currentView;
+    OctreeElementBag _deferredBag;
+    bool _hooked;
+};
+
+#endif // hifi_OctreeSentSubtrees_h
@@ -13,6 +13,7 @@
 #include <QTimer>
 #include <QUuid>
 
+#include <algorithm>
 #include <time.h>
 #include <HTTPConnection.h>
 #include <Logging.h>
@@ -232,6 +233,9 @@ OctreeServer::OctreeServer(const QByteArray& packet) :
     _jurisdictionSender(NULL),
     _octreeInboundPacketProcessor(NULL),
     _persistThread(NULL),
+    _encodeCache(NULL),
+    _parallelEncoder(NULL),
+    _wantIncrementalScenes(false),
     _started(time(0)),
     _startedUSecs(usecTimestampNow())
 {
@@ -272,6 +276,12 @@ OctreeServer::~OctreeServer() {
 
     delete _jurisdiction;
     _jurisdiction = NULL;
+
+    delete _encodeCache;
+    _encodeCache = NULL;
+
+    delete _parallelEncoder;
+    _parallelEncoder = NULL;
     
     // cleanup our tree here...
     qDebug() << qPrintable(_safeServerName) << "server START cleaning up octree... [" << this << "]";
@@ -531,6 +541,18 @@ bool OctreeServer::handleHTTPRequest(HTTPConnection* connection, const QUrl& url
                                          extraLongVsTotalEncode * AS_PERCENT, _extraLongEncode);
 
 
+        if (_encodeCache) {
+            int encodeCacheLookups = _encodeCache->getHits() + _encodeCache->getMisses();
+            float encodeCacheHitRatio = (encodeCacheLookups > 0)
+                ? ((float)_encodeCache->getHits() / (float)encodeCacheLookups) : 0.0f;
+            statsString += QString().sprintf("           Shared encode cache hits:"
+                                             "                          (%6.2f%%) samples: %12d \r\n",
+                                             encodeCacheHitRatio * AS_PERCENT, encodeCacheLookups);
+            statsString += QString().sprintf("         Shared encode cache entries:"
+                                             " %12d (%d bytes)\r\n\r\n",
+                                             _encodeCache->getNumEntries(), _encodeCache->getBytes());
+        }
+
         float averageCompressAndWriteTime = getAverageCompressAndWriteTime();
         statsString += QString().sprintf("     Average compress and write time:    %9.2f usecs\r\n", 
             averageCompressAndWriteTime);
@@ -1032,8 +1054,58 @@ void OctreeServer::run() {
     _jurisdictionSender = new JurisdictionSender(_jurisdiction, getMyNodeType());
     _jurisdictionSender->initialize(true);
 
+    // Check to see if the user wants clients that see the same thing to share encoded subtrees
+    const char* ENCODE_CACHE_MEGABYTES = "--encodeCacheMegabytes";
+    const char* encodeCacheMegabytes = getCmdOption(_argc, _argv, ENCODE_CACHE_MEGABYTES);
+    if (encodeCacheMegabytes) {
+        qDebug("encodeCacheMegabytes=%s", encodeCacheMegabytes);
+        if (atoi(encodeCacheMegabytes) > 0) {
+            if (_tree->changesMarkAncestors()) {
+                const int BYTES_PER_MEGABYTE = 1024 * 1024;
+                _encodeCache = new OctreeEncodeCache(atoi(encodeCacheMegabytes) * BYTES_PER_MEGABYTE);
+            } else {
+                qDebug() << "This server's tree can't tell when a subtree has changed, not sharing encoded subtrees.";
+            }
+        }
+    }
+
+    // Check to see if the user wants scenes to pick up where the last one left off when a client's view moves
+    const char* INCREMENTAL_SCENES = "--incrementalScenes";
+    if (cmdOptionExists(_argc, _argv, INCREMENTAL_SCENES)) {
+        if (_tree->changesMarkAncestors()) {
+            _wantIncrementalScenes = true;
+        } else {
+            qDebug() << "This server's tree can't tell when a subtree has changed, not sending incremental scenes.";
+        }
+    }
+    qDebug("incrementalScenes=%s", debug::valueOf(_wantIncrementalScenes));
+
+    // Check to see if the user wants the scenes clients are sent in full, like their first, encoded on more threads
+    const char* PARALLEL_ENCODE_THREADS = "--parallelEncodeThreads";
+    const char* parallelEncodeThreads = getCmdOption(_argc, _argv, PARALLEL_ENCODE_THREADS);
+    if (parallelEncodeThreads) {
+        qDebug("parallelEncodeThreads=%s", parallelEncodeThreads);
+        if (atoi(parallelEncodeThreads) > 1) {
+            if (_tree->changesMarkAncestors()) {
+                _parallelEncoder = new OctreeParallelEncoder(atoi(parallelEncodeThreads));
+            } else {
+                qDebug() << "This server's tree can't tell when a subtree has changed,"
+                    << "not encoding scenes in parallel.";
+            }
+        }
+    }
+
+    // Check to see if the user wants edits from different senders processed on more than one thread
+    const char* INBOUND_PROCESSING_THREADS = "--inboundProcessingThreads";
+    const char* inboundProcessingThreadsOption = getCmdOption(_argc, _argv, INBOUND_PROCESSING_THREADS);
+    int inboundProcessingThreads = 1;
+    if (inboundProcessingThreadsOption) {
+        inboundProcessingThreads = std::max(atoi(inboundProcessingThreadsOption), 1);
+    }
+    qDebug("inboundProcessingThreads=%d", inboundProcessingThreads);
+
     // set up our OctreeServerPacketProcessor
-    _octreeInboundPacketProcessor = new OctreeInboundPacketProcessor(this);
+    _octreeInboundPacketProcessor = new OctreeInboundPacketProcessor(this, inboundProcessingThreads);
     _octreeInboundPacketProcessor->initialize(true);
 
     // Convert now to tm struct for local timezone
@@ -1058,9 +1130,6 @@ void OctreeServer::nodeAdded(SharedNodePointer node) {
 void OctreeServer::nodeKilled(SharedNodePointer node) {
     quint64 start  = usecTimestampNow();
 
-    // calling this here since nodeKilled slot in ReceivedPacketProcessor can't be triggered by signals yet!!
-    _octreeInboundPacketProcessor->nodeKilled(node);
-
     qDebug() << qPrintable(_safeServerName) << "server killed node:" << *node;
     OctreeQueryNode* nodeData = static_cast<OctreeQueryNode*>(node->getLinkedData());
     if (nodeData) {
@@ -21,6 +21,8 @@
 #include <ThreadedAssignment.h>
 #include <EnvironmentData.h>
 
+#include "OctreeEncodeCache.h"
+#include "OctreeParallelEncoder.h"
 #include "OctreePersistThread.h"
 #include "OctreeSendThread.h"
 #include "OctreeServerConsts.h"
@@ -45,6 +47,15 @@ public:
     Octree* getOctree() { return _tree; }
     JurisdictionMap* getJurisdiction() { return _jurisdiction; }
 
+    /// the encoded subtrees shared by the sending threads, or NULL if they each encode everything themselves
+    OctreeEncodeCache* getEncodeCache() { return _encodeCache; }
+
+    /// the threads that scenes sent in full are encoded ahead on, or NULL if each sending thread encodes its own
+    OctreeParallelEncoder* getParallelEncoder() { return _parallelEncoder; }
+
+    /// whether clients that don't ask for deltas are sent only what changed for them when their view moves
+    bool wantIncrementalScenes() const { return _wantIncrementalScenes; }
+
     int getPacketsPerClientPerInterval() const { return std::min(_packetsPerClientPerInterval, 
                                 std::max(1, getPacketsTotalPerInterval() / std::max(1, getCurrentClientCount()))); }
 
@@ -157,6 +168,9 @@ protected:
     JurisdictionSender* _jurisdictionSender;
     OctreeInboundPacketProcessor* _octreeInboundPacketProcessor;
     OctreePersistThread* _persistThread;
+    OctreeEncodeCache* _encodeCache;
+    OctreeParallelEncoder* _parallelEncoder;
+    bool _wantIncrementalScenes;
 
     static OctreeServer* _instance;
 
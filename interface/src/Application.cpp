@@ -2111,6 +2111,12 @@ void Application::updateMyAvatar(float deltaTime) {
         PerformanceTimer perfTimer("send");
         QByteArray packet = byteArrayWithPopulatedHeader(PacketTypeAvatarData);
         packet.append(_myAvatar->toByteArray());
+
+        // follow it with our camera, so the mixer can send the avatars we can't see less often
+        int avatarDataSize = packet.size();
+        packet.resize(avatarDataSize + ViewFrustum::numBytesCameraDetails());
+        _viewFrustum.packCameraDetails(reinterpret_cast<unsigned char*>(packet.data()) + avatarDataSize);
+
         controlledBroadcastToNodes(packet, NodeSet() << NodeType::AvatarMixer);
     }
 
@@ -3316,12 +3322,10 @@ void Application::nodeAdded(SharedNodePointer node) {
 
 void Application::nodeKilled(SharedNodePointer node) {
 
-    // These are here because connecting NodeList::nodeKilled to OctreePacketProcessor::nodeKilled doesn't work:
-    // OctreePacketProcessor::nodeKilled is not being called when NodeList::nodeKilled is emitted.
+    // These are here because connecting NodeList::nodeKilled to the edit senders' nodeKilled doesn't work:
+    // their nodeKilled is not being called when NodeList::nodeKilled is emitted.
     // This may have to do with GenericThread::threadRoutine() blocking the QThread event loop
 
-    _octreeProcessor.nodeKilled(node);
-
     _voxelEditSender.nodeKilled(node);
     _particleEditSender.nodeKilled(node);
     _modelEditSender.nodeKilled(node);
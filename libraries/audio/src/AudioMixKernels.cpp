@@ -0,0 +1,181 @@
+//
+//  AudioMixKernels.cpp
+//  libraries/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <limits>
+
+#include "AudioMixKernels.h"
+
+#ifdef HIFI_AUDIO_MIX_SSE2
+#include <emmintrin.h>
+#endif
+
+const float MAX_MIX_SAMPLE_VALUE = (float) std::numeric_limits<int16_t>::max();
+const float MIN_MIX_SAMPLE_VALUE = (float) std::numeric_limits<int16_t>::min();
+
+void mixMonoToStereoChannelScalar(float* mixChannel, const int16_t* source, int numSamples, float gain, float gainStep) {
+    for (int i = 0; i < numSamples; i++) {
+        mixChannel[i * 2] += source[i] * (gain + (gainStep * i));
+    }
+}
+
+void mixMonoToStereoScalar(float* mix, const int16_t* source, int numSamples, float gain, float gainStep) {
+    for (int i = 0; i < numSamples; i++) {
+        float sample = source[i] * (gain + (gainStep * i));
+        mix[i * 2] += sample;
+        mix[(i * 2) + 1] += sample;
+    }
+}
+
+void mixStereoToStereoScalar(float* mix, const int16_t* source, int numSamples, float gain, float gainStep) {
+    for (int i = 0; i < numSamples; i++) {
+        mix[i] += source[i] * (gain + (gainStep * (i / 2)));
+    }
+}
+
+void clampMixToSamplesScalar(const float* mix, int16_t* samples, int numSamples) {
+    for (int i = 0; i < numSamples; i++) {
+        float sample = mix[i];
+
+        if (sample > MAX_MIX_SAMPLE_VALUE) {
+            sample = MAX_MIX_SAMPLE_VALUE;
+        } else if (sample < MIN_MIX_SAMPLE_VALUE) {
+            sample = MIN_MIX_SAMPLE_VALUE;
+        }
+
+        samples[i] = (int16_t) sample;
+    }
+}
+
+#ifdef HIFI_AUDIO_MIX_SSE2
+
+const int SAMPLES_PER_SSE2_BLOCK = 8;
+
+// converts eight int16 samples to two vectors of four floats, scaled by the matching gains
+static inline void scaleSamples(__m128i samples, __m128 gainLow, __m128 gainHigh, __m128& scaledLow, __m128& scaledHigh) {
+    // sign extend each half of the samples to 32 bits
+    __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+    __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16);
+
+    scaledLow = _mm_mul_ps(_mm_cvtepi32_ps(low), gainLow);
+    scaledHigh = _mm_mul_ps(_mm_cvtepi32_ps(high), gainHigh);
+}
+
+static inline __m128i loadSamples(const int16_t* source) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+}
+
+static inline void addToMix(float* mixAt, __m128 samples) {
+    _mm_storeu_ps(mixAt, _mm_add_ps(_mm_loadu_ps(mixAt), samples));
+}
+
+void mixMonoToStereoChannel(float* mixChannel, const int16_t* source, int numSamples, float gain, float gainStep) {
+    // the gain for each of the eight samples in a block, relative to the gain for the first one
+    const __m128 gainStepsLow = _mm_mul_ps(_mm_set1_ps(gainStep), _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f));
+    const __m128 gainStepsHigh = _mm_mul_ps(_mm_set1_ps(gainStep), _mm_setr_ps(4.0f, 5.0f, 6.0f, 7.0f));
+    const __m128 zero = _mm_setzero_ps();
+
+    // each block also adds zero to the other channel, so the last block is left to the scalar loop to make sure
+    // we never touch the sample after the end of the mix when mixChannel points at the right channel
+    int i = 0;
+    for (; i + SAMPLES_PER_SSE2_BLOCK < numSamples; i += SAMPLES_PER_SSE2_BLOCK) {
+        __m128 blockGain = _mm_set1_ps(gain + (gainStep * i));
+
+        __m128 scaledLow, scaledHigh;
+        scaleSamples(loadSamples(source + i), _mm_add_ps(blockGain, gainStepsLow), _mm_add_ps(blockGain, gainStepsHigh),
+                     scaledLow, scaledHigh);
+
+        float* mixAt = mixChannel + (i * 2);
+        addToMix(mixAt, _mm_unpacklo_ps(scaledLow, zero));
+        addToMix(mixAt + 4, _mm_unpackhi_ps(scaledLow, zero));
+        addToMix(mixAt + 8, _mm_unpacklo_ps(scaledHigh, zero));
+        addToMix(mixAt + 12, _mm_unpackhi_ps(scaledHigh, zero));
+    }
+
+    mixMonoToStereoChannelScalar(mixChannel + (i * 2), source + i, numSamples - i, gain + (gainStep * i), gainStep);
+}
+
+void mixMonoToStereo(float* mix, const int16_t* source, int numSamples, float gain, float gainStep) {
+    const __m128 gainStepsLow = _mm_mul_ps(_mm_set1_ps(gainStep), _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f));
+    const __m128 gainStepsHigh = _mm_mul_ps(_mm_set1_ps(gainStep), _mm_setr_ps(4.0f, 5.0f, 6.0f, 7.0f));
+
+    int i = 0;
+    for (; i + SAMPLES_PER_SSE2_BLOCK <= numSamples; i += SAMPLES_PER_SSE2_BLOCK) {
+        __m128 blockGain = _mm_set1_ps(gain + (gainStep * i));
+
+        __m128 scaledLow, scaledHigh;
+        scaleSamples(loadSamples(source + i), _mm_add_ps(blockGain, gainStepsLow), _mm_add_ps(blockGain, gainStepsHigh),
+                     scaledLow, scaledHigh);
+
+        float* mixAt = mix + (i * 2);
+        addToMix(mixAt, _mm_unpacklo_ps(scaledLow, scaledLow));
+        addToMix(mixAt + 4, _mm_unpackhi_ps(scaledLow, scaledLow));
+        addToMix(mixAt + 8, _mm_unpacklo_ps(scaledHigh, scaledHigh));
+        addToMix(mixAt + 12, _mm_unpackhi_ps(scaledHigh, scaledHigh));
+    }
+
+    mixMonoToStereoScalar(mix + (i * 2), source + i, numSamples - i, gain + (gainStep * i), gainStep);
+}
+
+void mixStereoToStereo(float* mix, const int16_t* source, int numSamples, float gain, float gainStep) {
+    // a block of eight samples is four stereo frames, both samples of a frame get the same gain
+    const __m128 gainStepsLow = _mm_mul_ps(_mm_set1_ps(gainStep), _mm_setr_ps(0.0f, 0.0f, 1.0f, 1.0f));
+    const __m128 gainStepsHigh = _mm_mul_ps(_mm_set1_ps(gainStep), _mm_setr_ps(2.0f, 2.0f, 3.0f, 3.0f));
+
+    int i = 0;
+    for (; i + SAMPLES_PER_SSE2_BLOCK <= numSamples; i += SAMPLES_PER_SSE2_BLOCK) {
+        __m128 blockGain = _mm_set1_ps(gain + (gainStep * (i / 2)));
+
+        __m128 scaledLow, scaledHigh;
+        scaleSamples(loadSamples(source + i), _mm_add_ps(blockGain, gainStepsLow), _mm_add_ps(blockGain, gainStepsHigh),
+                     scaledLow, scaledHigh);
+
+        addToMix(mix + i, scaledLow);
+        addToMix(mix + i + 4, scaledHigh);
+    }
+
+    mixStereoToStereoScalar(mix + i, source + i, numSamples - i, gain + (gainStep * (i / 2)), gainStep);
+}
+
+void clampMixToSamples(const float* mix, int16_t* samples, int numSamples) {
+    const __m128 maxSample = _mm_set1_ps(MAX_MIX_SAMPLE_VALUE);
+    const __m128 minSample = _mm_set1_ps(MIN_MIX_SAMPLE_VALUE);
+
+    int i = 0;
+    for (; i + SAMPLES_PER_SSE2_BLOCK <= numSamples; i += SAMPLES_PER_SSE2_BLOCK) {
+        // clamp before converting, out of range floats don't convert to anything useful
+        __m128 low = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(mix + i), maxSample), minSample);
+        __m128 high = _mm_max_ps(_mm_min_ps(_mm_loadu_ps(mix + i + 4), maxSample), minSample);
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(samples + i),
+                         _mm_packs_epi32(_mm_cvttps_epi32(low), _mm_cvttps_epi32(high)));
+    }
+
+    clampMixToSamplesScalar(mix + i, samples + i, numSamples - i);
+}
+
+#else
+
+void mixMonoToStereoChannel(float* mixChannel, const int16_t* source, int numSamples, float gain, float gainStep) {
+    mixMonoToStereoChannelScalar(mixChannel, source, numSamples, gain, gainStep);
+}
+
+void mixMonoToStereo(float* mix, const int16_t* source, int numSamples, float gain, float gainStep) {
+    mixMonoToStereoScalar(mix, source, numSamples, gain, gainStep);
+}
+
+void mixStereoToStereo(float* mix, const int16_t* source, int numSamples, float gain, float gainStep) {
+    mixStereoToStereoScalar(mix, source, numSamples, gain, gainStep);
+}
+
+void clampMixToSamples(const float* mix, int16_t* samples, int numSamples) {
+    clampMixToSamplesScalar(mix, samples, numSamples);
+}
+
+#endif // HIFI_AUDIO_MIX_SSE2
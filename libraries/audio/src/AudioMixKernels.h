@@ -0,0 +1,48 @@
+//
+//  AudioMixKernels.h
+//  libraries/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Inner loops used by the audio mixer to add a source frame into an interleaved stereo mix.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_AudioMixKernels_h
+#define hifi_AudioMixKernels_h
+
+#include <stdint.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HIFI_AUDIO_MIX_SSE2
+#endif
+
+// Sources are accumulated into a float mix without any clamping, so the result doesn't depend on the order sources are
+// added in. Once every source is in, clampMixToSamples produces the int16 samples that are sent.
+// The un-suffixed versions use SSE2 when it is available at compile time and otherwise call the scalar versions.
+//
+// The first stereo frame is scaled by gain and every following frame by gainStep more than the one before it, which
+// lets the mixer ramp a source from last frame's gain to this one's instead of jumping.
+
+/// adds numSamples mono samples to one channel of an interleaved stereo mix, mixChannel points at the first sample of
+/// that channel, so pass mix for the left channel and mix + 1 for the right
+void mixMonoToStereoChannel(float* mixChannel, const int16_t* source, int numSamples, float gain, float gainStep = 0.0f);
+
+/// adds numSamples mono samples to both channels of an interleaved stereo mix
+void mixMonoToStereo(float* mix, const int16_t* source, int numSamples, float gain, float gainStep = 0.0f);
+
+/// adds numSamples interleaved stereo samples (numSamples counts both channels) to an interleaved stereo mix
+void mixStereoToStereo(float* mix, const int16_t* source, int numSamples, float gain, float gainStep = 0.0f);
+
+/// clamps numSamples of a finished mix to the int16 sample range and truncates them into samples
+void clampMixToSamples(const float* mix, int16_t* samples, int numSamples);
+
+void mixMonoToStereoChannelScalar(float* mixChannel, const int16_t* source, int numSamples, float gain,
+                                  float gainStep = 0.0f);
+void mixMonoToStereoScalar(float* mix, const int16_t* source, int numSamples, float gain, float gainStep = 0.0f);
+void mixStereoToStereoScalar(float* mix, const int16_t* source, int numSamples, float gain, float gainStep = 0.0f);
+void clampMixToSamplesScalar(const float* mix, int16_t* samples, int numSamples);
+
+#endif // hifi_AudioMixKernels_h
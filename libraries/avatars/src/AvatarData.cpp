@@ -28,9 +28,15 @@
 #include <VoxelConstants.h>
 
 #include "AvatarData.h"
+#include "AvatarDataDelta.h"
 
 quint64 DEFAULT_FILTERED_LOG_EXPIRY = 2 * USECS_PER_SECOND;
 
+// the first versions of the avatar data packets with orientations and joint rotations as smallest three quaternions,
+// before them the body and head were three two byte angles each and joint rotations were eight bytes
+const PacketVersion FIRST_SMALLEST_THREE_AVATAR_DATA_VERSION = 5;
+const PacketVersion FIRST_SMALLEST_THREE_BULK_AVATAR_DATA_VERSION = 3;
+
 using namespace std;
 
 AvatarData::AvatarData() :
@@ -53,7 +59,10 @@ AvatarData::AvatarData() :
     _billboard(),
     _errorLogExpiry(0),
     _owningAvatarMixer(),
-    _lastUpdateTimer()
+    _lastUpdateTimer(),
+    _deltaKeyframe(),
+    _deltaKeyframeSequence(0),
+    _hasDeltaKeyframe(false)
 {
     
 }
@@ -91,18 +100,18 @@ QByteArray AvatarData::toByteArray() {
     memcpy(destinationBuffer, &_position, sizeof(_position));
     destinationBuffer += sizeof(_position);
     
-    // Body rotation (NOTE: This needs to become a quaternion to save two bytes)
-    destinationBuffer += packFloatAngleToTwoByte(destinationBuffer, _bodyYaw);
-    destinationBuffer += packFloatAngleToTwoByte(destinationBuffer, _bodyPitch);
-    destinationBuffer += packFloatAngleToTwoByte(destinationBuffer, _bodyRoll);
+    // Body rotation
+    destinationBuffer += packOrientationQuatToSmallestThree(destinationBuffer, getOrientation(),
+                                                            AVATAR_ORIENTATION_BITS_PER_COMPONENT);
 
     // Body scale
     destinationBuffer += packFloatRatioToTwoByte(destinationBuffer, _targetScale);
 
-    // Head rotation (NOTE: This needs to become a quaternion to save two bytes)
-    destinationBuffer += packFloatAngleToTwoByte(destinationBuffer, _headData->getFinalYaw());
-    destinationBuffer += packFloatAngleToTwoByte(destinationBuffer, _headData->getFinalPitch());
-    destinationBuffer += packFloatAngleToTwoByte(destinationBuffer, _headData->getFinalRoll());
+    // Head rotation, relative to the body
+    glm::quat headRotation = glm::quat(glm::radians(glm::vec3(_headData->getFinalPitch(), _headData->getFinalYaw(),
+                                                              _headData->getFinalRoll())));
+    destinationBuffer += packOrientationQuatToSmallestThree(destinationBuffer, headRotation,
+                                                            AVATAR_ORIENTATION_BITS_PER_COMPONENT);
     
     // Head lean X,Z (head lateral and fwd/back motion relative to torso)
     memcpy(destinationBuffer, &_headData->_leanSideways, sizeof(_headData->_leanSideways));
@@ -178,7 +187,8 @@ QByteArray AvatarData::toByteArray() {
     }
     foreach (const JointData& data, _jointData) {
         if (data.valid) {
-            destinationBuffer += packOrientationQuatToBytes(destinationBuffer, data.rotation);
+            destinationBuffer += packOrientationQuatToSmallestThree(destinationBuffer, data.rotation,
+                                                                    JOINT_ROTATION_BITS_PER_COMPONENT);
         }
     }
         
@@ -213,6 +223,13 @@ int AvatarData::parseDataAtOffset(const QByteArray& packet, int offset) {
     const unsigned char* sourceBuffer = startPosition;
     quint64 now = usecTimestampNow();
 
+    // older versions of the packets send the body and head as euler angles and joints as all four components
+    PacketType packetType = packetTypeForPacket(packet);
+    PacketVersion packetVersion = packet[numBytesArithmeticCodingFromBuffer(packet.data())];
+    bool hasSmallestThreeQuats = (packetType == PacketTypeBulkAvatarData)
+        ? packetVersion >= FIRST_SMALLEST_THREE_BULK_AVATAR_DATA_VERSION
+        : packetVersion >= FIRST_SMALLEST_THREE_AVATAR_DATA_VERSION;
+
     // The absolute minimum size of the update data is as follows:
     // 50 bytes of "plain old data" {
     //     position      = 12 bytes
@@ -233,6 +250,11 @@ int AvatarData::parseDataAtOffset(const QByteArray& packet, int offset) {
     // + 1 byte for numJoints (0)
     // = 53 bytes
     int minPossibleSize = 53; 
+    if (hasSmallestThreeQuats) {
+        // the body and head rotations are a smallest three quaternion each instead of three compressed floats
+        const int NUM_BYTES_EULER_ANGLES = 3 * sizeof(uint16_t);
+        minPossibleSize -= 2 * (NUM_BYTES_EULER_ANGLES - NUM_BYTES_AVATAR_ORIENTATION);
+    }
     
     int maxAvailableSize = packet.size() - offset;
     if (minPossibleSize > maxAvailableSize) {
@@ -260,11 +282,21 @@ int AvatarData::parseDataAtOffset(const QByteArray& packet, int offset) {
         }
         _position = position;
         
-        // rotation (NOTE: This needs to become a quaternion to save two bytes)
+        // rotation
         float yaw, pitch, roll;
-        sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &yaw);
-        sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &pitch);
-        sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &roll);
+        if (hasSmallestThreeQuats) {
+            glm::quat orientation;
+            sourceBuffer += unpackOrientationQuatFromSmallestThree(sourceBuffer, orientation,
+                                                                   AVATAR_ORIENTATION_BITS_PER_COMPONENT);
+            glm::vec3 eulerAngles = glm::degrees(safeEulerAngles(orientation));
+            pitch = eulerAngles.x;
+            yaw = eulerAngles.y;
+            roll = eulerAngles.z;
+        } else {
+            sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &yaw);
+            sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &pitch);
+            sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &roll);
+        }
         if (glm::isnan(yaw) || glm::isnan(pitch) || glm::isnan(roll)) {
             if (shouldLogError(now)) {
                 qDebug() << "Discard nan AvatarData::yaw,pitch,roll; displayName = '" << _displayName << "'";
@@ -285,14 +317,23 @@ int AvatarData::parseDataAtOffset(const QByteArray& packet, int offset) {
             return maxAvailableSize;
         }
         _targetScale = scale;
-    } // 20 bytes
+    } // 19 bytes, 20 with euler angles
     
     { // Head rotation 
-        //(NOTE: This needs to become a quaternion to save two bytes)
         float headYaw, headPitch, headRoll;
-        sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &headYaw);
-        sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &headPitch);
-        sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &headRoll);
+        if (hasSmallestThreeQuats) {
+            glm::quat headRotation;
+            sourceBuffer += unpackOrientationQuatFromSmallestThree(sourceBuffer, headRotation,
+                                                                   AVATAR_ORIENTATION_BITS_PER_COMPONENT);
+            glm::vec3 eulerAngles = glm::degrees(safeEulerAngles(headRotation));
+            headPitch = eulerAngles.x;
+            headYaw = eulerAngles.y;
+            headRoll = eulerAngles.z;
+        } else {
+            sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &headYaw);
+            sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &headPitch);
+            sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &headRoll);
+        }
         if (glm::isnan(headYaw) || glm::isnan(headPitch) || glm::isnan(headRoll)) {
             if (shouldLogError(now)) {
                 qDebug() << "Discard nan AvatarData::headYaw,headPitch,headRoll; displayName = '" << _displayName << "'";
@@ -302,7 +343,7 @@ int AvatarData::parseDataAtOffset(const QByteArray& packet, int offset) {
         _headData->setBaseYaw(headYaw);
         _headData->setBasePitch(headPitch);
         _headData->setBaseRoll(headRoll);
-    } // 6 bytes
+    } // 5 bytes, 6 with euler angles
         
     // Head lean (relative to pelvis)
     {
@@ -473,9 +514,11 @@ int AvatarData::parseDataAtOffset(const QByteArray& packet, int offset) {
     }
     // 1 + bytesOfValidity bytes
 
-    // each joint rotation component is stored in two bytes (sizeof(uint16_t))
+    // each joint rotation is a smallest three quaternion, or four components of two bytes (sizeof(uint16_t)) each
     int COMPONENTS_PER_QUATERNION = 4;
-    minPossibleSize += numValidJoints * COMPONENTS_PER_QUATERNION * sizeof(uint16_t);
+    int bytesPerJointRotation = hasSmallestThreeQuats
+        ? NUM_BYTES_JOINT_ROTATION : (int) (COMPONENTS_PER_QUATERNION * sizeof(uint16_t));
+    minPossibleSize += numValidJoints * bytesPerJointRotation;
     if (minPossibleSize > maxAvailableSize) {
         if (shouldLogError(now)) {
             qDebug() << "Malformed AvatarData packet after JointData;"
@@ -491,14 +534,77 @@ int AvatarData::parseDataAtOffset(const QByteArray& packet, int offset) {
             JointData& data = _jointData[i];
             if (data.valid) {
                 _hasNewJointRotations = true;
-                sourceBuffer += unpackOrientationQuatFromBytes(sourceBuffer, data.rotation);
+                if (hasSmallestThreeQuats) {
+                    sourceBuffer += unpackOrientationQuatFromSmallestThree(sourceBuffer, data.rotation,
+                                                                           JOINT_ROTATION_BITS_PER_COMPONENT);
+                } else {
+                    sourceBuffer += unpackOrientationQuatFromBytes(sourceBuffer, data.rotation);
+                }
             }
         }
-    } // numJoints * 8 bytes
+    } // numJoints * 4 bytes, 8 without smallest three quaternions
     
     return sourceBuffer - startPosition;
 }
 
+int AvatarData::parseBulkRecordAtOffset(const QByteArray& packet, int offset) {
+    const char* recordHeader = packet.constData() + offset;
+    int maxAvailableSize = packet.size() - offset;
+    if (maxAvailableSize < NUM_BYTES_AVATAR_RECORD_HEADER) {
+        // this packet is malformed so we report all bytes as consumed
+        return maxAvailableSize;
+    }
+
+    quint8 recordType = recordHeader[0];
+    quint8 keyframeSequence = recordHeader[1];
+    int bytesRead = NUM_BYTES_AVATAR_RECORD_HEADER;
+
+    if (recordType == AVATAR_KEYFRAME_RECORD) {
+        int keyframeLength = parseDataAtOffset(packet, offset + bytesRead);
+
+        // hold onto the encoding so the deltas that follow can be applied to it
+        _deltaKeyframe = packet.mid(offset + bytesRead, keyframeLength);
+        _deltaKeyframeSequence = keyframeSequence;
+        _hasDeltaKeyframe = true;
+
+        return bytesRead + keyframeLength;
+    }
+
+    quint16 deltaLength = 0;
+    if (recordType != AVATAR_DELTA_RECORD || maxAvailableSize < bytesRead + (int) sizeof(deltaLength)) {
+        return maxAvailableSize;
+    }
+    memcpy(&deltaLength, recordHeader + bytesRead, sizeof(deltaLength));
+    bytesRead += sizeof(deltaLength);
+
+    if (bytesRead + deltaLength > maxAvailableSize) {
+        if (shouldLogError(usecTimestampNow())) {
+            qDebug() << "Malformed AvatarData delta;"
+                << " displayName = '" << _displayName << "'"
+                << " deltaLength = " << deltaLength
+                << " maxAvailableSize = " << maxAvailableSize;
+        }
+        return maxAvailableSize;
+    }
+
+    // a delta against a keyframe we missed is useless, the next keyframe will catch us up
+    if (_hasDeltaKeyframe && keyframeSequence == _deltaKeyframeSequence) {
+        // the rebuilt avatar keeps the packet's header, so it is parsed as the version it came in
+        int numBytesPacketHeader = numBytesForPacketHeader(packet);
+        QByteArray avatarByteArray;
+        if (AvatarDataDelta::applyDelta(_deltaKeyframe, recordHeader + bytesRead, deltaLength, avatarByteArray)) {
+            avatarByteArray.prepend(packet.left(numBytesPacketHeader));
+            parseDataAtOffset(avatarByteArray, numBytesPacketHeader);
+        } else if (shouldLogError(usecTimestampNow())) {
+            qDebug() << "Malformed AvatarData delta;"
+                << " displayName = '" << _displayName << "'"
+                << " deltaLength = " << deltaLength;
+        }
+    }
+
+    return bytesRead + deltaLength;
+}
+
 void AvatarData::setJointData(int index, const glm::quat& rotation) {
     if (index == -1) {
         return;
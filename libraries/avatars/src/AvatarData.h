@@ -82,6 +82,12 @@ const int HAND_STATE_START_BIT = 2; // 3rd and 4th bits
 const int IS_FACESHIFT_CONNECTED = 4; // 5th bit
 const int IS_CHAT_CIRCLING_ENABLED = 5;
 
+// body and head orientations and joint rotations are sent as smallest three quaternions, see SharedUtil.h
+const int AVATAR_ORIENTATION_BITS_PER_COMPONENT = 12;
+const int JOINT_ROTATION_BITS_PER_COMPONENT = 10;
+const int NUM_BYTES_AVATAR_ORIENTATION = 5;
+const int NUM_BYTES_JOINT_ROTATION = 4;
+
 static const float MAX_AVATAR_SCALE = 1000.f;
 static const float MIN_AVATAR_SCALE = .005f;
 
@@ -155,6 +161,12 @@ public:
     /// \return number of bytes parsed
     virtual int parseDataAtOffset(const QByteArray& packet, int offset);
 
+    /// parses a keyframe or delta record from a bulk avatar data packet, see AvatarDataDelta.h
+    /// \param packet byte array of data
+    /// \param offset number of bytes into packet where the record starts, after the session UUID
+    /// \return number of bytes parsed
+    int parseBulkRecordAtOffset(const QByteArray& packet, int offset);
+
     //  Body Rotation (degrees)
     float getBodyYaw() const { return _bodyYaw; }
     void setBodyYaw(float bodyYaw) { _bodyYaw = bodyYaw; }
@@ -325,6 +337,10 @@ protected:
     
     QWeakPointer<Node> _owningAvatarMixer;
     QElapsedTimer _lastUpdateTimer;
+
+    QByteArray _deltaKeyframe; ///< the last keyframe record from the mixer, deltas are applied to it
+    quint8 _deltaKeyframeSequence;
+    bool _hasDeltaKeyframe;
     
     /// Loads the joint indices, names from the FST file (if any)
     virtual void updateJointMappings();
@@ -0,0 +1,275 @@
+//
+//  AvatarDataDelta.cpp
+//  libraries/avatars/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <math.h>
+#include <string.h>
+
+#include <SharedUtil.h>
+
+#include "AvatarData.h"
+
+#include "AvatarDataDelta.h"
+
+// the encoding is split into these sections, each one is either sent in full in a delta or taken from the keyframe
+// the joint rotations that follow the joint header are handled one at a time
+enum AvatarDataSection {
+    PositionSection,
+    BodySection,
+    HeadSection,
+    LeanSection,
+    LookAtSection,
+    LoudnessSection,
+    FaceSection,
+    JointHeaderSection,
+    NUM_AVATAR_DATA_SECTIONS
+};
+
+// the sizes of the sections that come before the variable sized ones
+const int FIXED_SECTION_SIZES[] = { 12, NUM_BYTES_AVATAR_ORIENTATION + 2, NUM_BYTES_AVATAR_ORIENTATION, 8, 12, 4 };
+
+// how far the floats in a section can drift from the keyframe before they are sent again
+// the sections that aren't here, and the joint rotations, are already quantized and are sent again whenever they change
+const float POSITION_THRESHOLD = 0.001f; // meters
+const float LEAN_THRESHOLD = 0.001f;
+const float LOOK_AT_THRESHOLD = 0.01f; // meters
+const float LOUDNESS_THRESHOLD = 1.0f;
+
+// in a delta, the bit for the joint header means the joints changed shape and every joint rotation follows it,
+// otherwise the header is followed by a bit per valid joint and the rotations of the joints that changed
+const quint8 JOINTS_REPLACED_BIT = 1 << JointHeaderSection;
+
+/// the chat message, bit items, face data and pupil dilation, -1 if they run past the available bytes
+static int faceSectionLength(const unsigned char* data, int available) {
+    if (available < 1) {
+        return -1;
+    }
+
+    int length = 1 + data[0];
+    if (available < length + 1) {
+        return -1;
+    }
+
+    unsigned char bitItems = data[length++];
+    if (oneAtBit(bitItems, IS_FACESHIFT_CONNECTED)) {
+        // eye blinks, average loudness and brow lift, then the blendshape coefficients
+        const int NUM_BYTES_FACESHIFT_FLOATS = 4 * sizeof(float);
+        if (available < length + NUM_BYTES_FACESHIFT_FLOATS + 1) {
+            return -1;
+        }
+        length += NUM_BYTES_FACESHIFT_FLOATS;
+
+        int numCoefficients = data[length++];
+        length += numCoefficients * sizeof(float);
+    }
+
+    // pupil dilation
+    length++;
+
+    return (length <= available) ? length : -1;
+}
+
+/// the joint count and validity bits, -1 if they run past the available bytes
+static int jointHeaderLength(const unsigned char* data, int available, int& numValidJoints) {
+    if (available < 1) {
+        return -1;
+    }
+
+    int numJoints = data[0];
+    int length = 1 + ((numJoints + BITS_IN_BYTE - 1) / BITS_IN_BYTE);
+    if (available < length) {
+        return -1;
+    }
+
+    numValidJoints = 0;
+    for (int i = 0; i < numJoints; i++) {
+        if (data[1 + (i / BITS_IN_BYTE)] & (1 << (i % BITS_IN_BYTE))) {
+            numValidJoints++;
+        }
+    }
+    return length;
+}
+
+static int sectionLength(int section, const char* data, int available, int& numValidJoints) {
+    const unsigned char* sectionData = reinterpret_cast<const unsigned char*>(data);
+
+    if (section == FaceSection) {
+        return faceSectionLength(sectionData, available);
+    } else if (section == JointHeaderSection) {
+        return jointHeaderLength(sectionData, available, numValidJoints);
+    } else {
+        return (FIXED_SECTION_SIZES[section] <= available) ? FIXED_SECTION_SIZES[section] : -1;
+    }
+}
+
+/// where each section of an encoding starts, the last offset is where the joint rotations start
+class AvatarDataLayout {
+public:
+    int sectionOffsets[NUM_AVATAR_DATA_SECTIONS + 1];
+    int numValidJoints;
+
+    int sectionLength(int section) const { return sectionOffsets[section + 1] - sectionOffsets[section]; }
+    int jointOffset(int joint) const {
+        return sectionOffsets[NUM_AVATAR_DATA_SECTIONS] + (joint * NUM_BYTES_JOINT_ROTATION);
+    }
+};
+
+static bool layoutAvatarData(const char* data, int length, AvatarDataLayout& layout) {
+    int offset = 0;
+    layout.numValidJoints = 0;
+
+    for (int i = 0; i < NUM_AVATAR_DATA_SECTIONS; i++) {
+        layout.sectionOffsets[i] = offset;
+
+        int numBytes = sectionLength(i, data + offset, length - offset, layout.numValidJoints);
+        if (numBytes < 0) {
+            return false;
+        }
+        offset += numBytes;
+    }
+    layout.sectionOffsets[NUM_AVATAR_DATA_SECTIONS] = offset;
+
+    return offset + (layout.numValidJoints * NUM_BYTES_JOINT_ROTATION) <= length;
+}
+
+static bool floatsDiffer(const char* first, const char* second, int numFloats, float threshold) {
+    for (int i = 0; i < numFloats; i++) {
+        float firstValue, secondValue;
+        memcpy(&firstValue, first + (i * sizeof(float)), sizeof(float));
+        memcpy(&secondValue, second + (i * sizeof(float)), sizeof(float));
+
+        if (fabsf(firstValue - secondValue) > threshold) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool sectionDiffers(int section, const char* keyframe, int keyframeLength,
+                           const char* current, int currentLength) {
+    switch (section) {
+        case PositionSection:
+            return floatsDiffer(keyframe, current, 3, POSITION_THRESHOLD);
+        case LeanSection:
+            return floatsDiffer(keyframe, current, 2, LEAN_THRESHOLD);
+        case LookAtSection:
+            return floatsDiffer(keyframe, current, 3, LOOK_AT_THRESHOLD);
+        case LoudnessSection:
+            return floatsDiffer(keyframe, current, 1, LOUDNESS_THRESHOLD);
+        default:
+            return keyframeLength != currentLength || memcmp(keyframe, current, currentLength) != 0;
+    }
+}
+
+bool AvatarDataDelta::writeDelta(const char* keyframe, int keyframeLength, const char* current, int currentLength,
+                                 QByteArray& delta) {
+    AvatarDataLayout keyframeLayout, currentLayout;
+    if (!layoutAvatarData(keyframe, keyframeLength, keyframeLayout)
+        || !layoutAvatarData(current, currentLength, currentLayout)) {
+        return false;
+    }
+
+    int deltaStart = delta.size();
+
+    // the section bits go first, we fill them in once we know which sections changed
+    quint8 changedSections = 0;
+    delta.append((char) changedSections);
+
+    for (int i = 0; i < NUM_AVATAR_DATA_SECTIONS; i++) {
+        const char* currentSection = current + currentLayout.sectionOffsets[i];
+        if (sectionDiffers(i, keyframe + keyframeLayout.sectionOffsets[i], keyframeLayout.sectionLength(i),
+                           currentSection, currentLayout.sectionLength(i))) {
+            changedSections |= (1 << i);
+            delta.append(currentSection, currentLayout.sectionLength(i));
+        }
+    }
+
+    if (changedSections & JOINTS_REPLACED_BIT) {
+        delta.append(current + currentLayout.jointOffset(0), currentLayout.numValidJoints * NUM_BYTES_JOINT_ROTATION);
+    } else {
+        // the same joints are valid in both, so we only send the ones that have moved
+        int changedJointsOffset = delta.size();
+        int numBytesChangedJoints = (currentLayout.numValidJoints + BITS_IN_BYTE - 1) / BITS_IN_BYTE;
+        delta.resize(changedJointsOffset + numBytesChangedJoints);
+        memset(delta.data() + changedJointsOffset, 0, numBytesChangedJoints);
+
+        for (int i = 0; i < currentLayout.numValidJoints; i++) {
+            const char* currentJoint = current + currentLayout.jointOffset(i);
+            if (memcmp(keyframe + keyframeLayout.jointOffset(i), currentJoint, NUM_BYTES_JOINT_ROTATION) != 0) {
+                delta.data()[changedJointsOffset + (i / BITS_IN_BYTE)] |= (1 << (i % BITS_IN_BYTE));
+                delta.append(currentJoint, NUM_BYTES_JOINT_ROTATION);
+            }
+        }
+    }
+
+    if (delta.size() - deltaStart >= currentLength) {
+        // so much has changed that the keyframe is no help
+        delta.resize(deltaStart);
+        return false;
+    }
+
+    delta.data()[deltaStart] = (char) changedSections;
+    return true;
+}
+
+bool AvatarDataDelta::applyDelta(const QByteArray& keyframe, const char* delta, int deltaLength, QByteArray& current) {
+    AvatarDataLayout keyframeLayout;
+    if (!layoutAvatarData(keyframe.constData(), keyframe.size(), keyframeLayout) || deltaLength < 1) {
+        return false;
+    }
+
+    quint8 changedSections = delta[0];
+    int offset = 1;
+    int numValidJoints = keyframeLayout.numValidJoints;
+
+    current.resize(0);
+
+    for (int i = 0; i < NUM_AVATAR_DATA_SECTIONS; i++) {
+        if (changedSections & (1 << i)) {
+            int numBytes = sectionLength(i, delta + offset, deltaLength - offset, numValidJoints);
+            if (numBytes < 0) {
+                return false;
+            }
+            current.append(delta + offset, numBytes);
+            offset += numBytes;
+        } else {
+            current.append(keyframe.constData() + keyframeLayout.sectionOffsets[i], keyframeLayout.sectionLength(i));
+        }
+    }
+
+    if (changedSections & JOINTS_REPLACED_BIT) {
+        int numBytesJoints = numValidJoints * NUM_BYTES_JOINT_ROTATION;
+        if (offset + numBytesJoints > deltaLength) {
+            return false;
+        }
+        current.append(delta + offset, numBytesJoints);
+        offset += numBytesJoints;
+    } else {
+        int numBytesChangedJoints = (numValidJoints + BITS_IN_BYTE - 1) / BITS_IN_BYTE;
+        if (offset + numBytesChangedJoints > deltaLength) {
+            return false;
+        }
+        const unsigned char* changedJoints = reinterpret_cast<const unsigned char*>(delta + offset);
+        offset += numBytesChangedJoints;
+
+        for (int i = 0; i < numValidJoints; i++) {
+            if (changedJoints[i / BITS_IN_BYTE] & (1 << (i % BITS_IN_BYTE))) {
+                if (offset + NUM_BYTES_JOINT_ROTATION > deltaLength) {
+                    return false;
+                }
+                current.append(delta + offset, NUM_BYTES_JOINT_ROTATION);
+                offset += NUM_BYTES_JOINT_ROTATION;
+            } else {
+                current.append(keyframe.constData() + keyframeLayout.jointOffset(i), NUM_BYTES_JOINT_ROTATION);
+            }
+        }
+    }
+
+    return offset == deltaLength;
+}
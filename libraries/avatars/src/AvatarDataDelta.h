@@ -0,0 +1,40 @@
+//
+//  AvatarDataDelta.h
+//  libraries/avatars/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Delta compression of the avatar data the avatar mixer sends in bulk avatar data packets.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_AvatarDataDelta_h
+#define hifi_AvatarDataDelta_h
+
+#include <QtCore/QByteArray>
+
+// Each avatar in a bulk avatar data packet is its session UUID followed by a record type and a keyframe sequence number.
+// A keyframe record is then the avatar as AvatarData::toByteArray encodes it, and the receiver keeps it along with its
+// sequence number. A delta record is a quint16 length followed by the parts of the encoding that differ from that keyframe,
+// so a lost delta costs nothing and a receiver without the matching keyframe just skips deltas until the next one.
+const quint8 AVATAR_KEYFRAME_RECORD = 0;
+const quint8 AVATAR_DELTA_RECORD = 1;
+
+const int NUM_BYTES_AVATAR_RECORD_HEADER = 2;
+
+class AvatarDataDelta {
+public:
+    /// appends the parts of current that differ from keyframe by more than their quantization thresholds to delta
+    /// both are encodings from AvatarData::toByteArray, returns false (and leaves delta as it was) if the delta wouldn't be
+    /// smaller than current or either encoding can't be read, in which case the caller should send a keyframe instead
+    static bool writeDelta(const char* keyframe, int keyframeLength, const char* current, int currentLength,
+                           QByteArray& delta);
+
+    /// rebuilds the encoding a delta written by writeDelta was made from into current, using the same keyframe
+    /// returns false if the delta is malformed
+    static bool applyDelta(const QByteArray& keyframe, const char* delta, int deltaLength, QByteArray& current);
+};
+
+#endif // hifi_AvatarDataDelta_h
@@ -112,8 +112,8 @@ void AvatarHashMap::processAvatarDataPacket(const QByteArray &datagram, const QW
         
         AvatarSharedPointer matchingAvatarData = matchingOrNewAvatar(sessionUUID, mixerWeakPointer);
         
-        // have the matching (or new) avatar parse the data from the packet
-        bytesRead += matchingAvatarData->parseDataAtOffset(datagram, bytesRead);
+        // have the matching (or new) avatar parse the keyframe or delta from the packet
+        bytesRead += matchingAvatarData->parseBulkRecordAtOffset(datagram, bytesRead);
     }
 }
 
@@ -0,0 +1,44 @@
+//
+//  DatagramBatch.cpp
+//  libraries/networking/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "LimitedNodeList.h"
+
+#include "DatagramBatch.h"
+
+DatagramBatch::DatagramBatch() :
+    _datagrams(),
+    _destinations(),
+    _numDatagrams(0)
+{
+
+}
+
+QByteArray& DatagramBatch::append(int size, const HifiSockAddr& destination, bool& didAllocate) {
+    didAllocate = false;
+
+    if (_numDatagrams == _datagrams.size()) {
+        _datagrams.append(QByteArray());
+        _destinations.append(HifiSockAddr());
+        didAllocate = true;
+    }
+
+    // resizing a byte array we've used before keeps its allocation, so a batch stops allocating once it has warmed up
+    QByteArray& datagram = _datagrams[_numDatagrams];
+    if (datagram.capacity() < size) {
+        // grow straight to the biggest packet we send, so this storage never needs to grow again
+        datagram.reserve(qMax(size, MAX_PACKET_SIZE));
+        didAllocate = true;
+    }
+    datagram.resize(size);
+    _destinations[_numDatagrams] = destination;
+
+    ++_numDatagrams;
+    return datagram;
+}
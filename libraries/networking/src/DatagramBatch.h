@@ -0,0 +1,46 @@
+//
+//  DatagramBatch.h
+//  libraries/networking/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Outbound datagrams collected over a frame so that LimitedNodeList can write them to the node socket together.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_DatagramBatch_h
+#define hifi_DatagramBatch_h
+
+#include <QtCore/QByteArray>
+#include <QtCore/QVector>
+
+#include "HifiSockAddr.h"
+
+/// Datagrams queued with LimitedNodeList::queueDatagram and sent by LimitedNodeList::flushDatagramBatch. A batch belongs
+/// to the thread that fills it and isn't locked, each sending thread should keep its own and re-use it every frame so
+/// that the storage for its datagrams is only allocated once.
+class DatagramBatch {
+public:
+    DatagramBatch();
+
+    int size() const { return _numDatagrams; }
+    bool isEmpty() const { return _numDatagrams == 0; }
+
+    /// drops every queued datagram without sending it, the storage is kept for the next frame
+    void clear() { _numDatagrams = 0; }
+
+private:
+    friend class LimitedNodeList;
+
+    /// returns the storage for the next datagram, sized to size bytes, and records where it goes
+    /// didAllocate is set if the storage had to grow, which stops happening once the batch has seen a busy frame
+    QByteArray& append(int size, const HifiSockAddr& destination, bool& didAllocate);
+
+    QVector<QByteArray> _datagrams;
+    QVector<HifiSockAddr> _destinations;
+    int _numDatagrams;
+};
+
+#endif // hifi_DatagramBatch_h
@@ -0,0 +1,230 @@
+//
+//  DatagramReceiver.cpp
+//  libraries/networking/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <algorithm>
+#include <cstring>
+
+#include <QtCore/QDebug>
+
+#ifdef Q_OS_LINUX
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#endif
+
+#include "LimitedNodeList.h"
+
+#include "DatagramReceiver.h"
+
+#if defined(Q_OS_LINUX) && defined(SO_REUSEPORT)
+#define HIFI_DATAGRAM_RECEIVE_THREADS
+#endif
+
+// how often a receive thread with nothing to read checks whether it has been asked to stop
+const int RECEIVE_STOP_CHECK_INTERVAL_MSECS = 100;
+
+// how long a receive thread waits when its queue is full, the datagrams wait in the socket's buffer meanwhile
+const int RECEIVE_QUEUE_FULL_SLEEP_USECS = 500;
+
+const int MAX_DATAGRAMS_PER_RECVMMSG = 64;
+
+// datagrams are read into their queue slot, anything bigger than MAX_PACKET_SIZE spills into a per-thread buffer
+const int MAX_UDP_DATAGRAM_SIZE = 65507;
+const int MAX_DATAGRAM_OVERFLOW_SIZE = MAX_UDP_DATAGRAM_SIZE - MAX_PACKET_SIZE;
+
+const int LARGER_RCVBUF_SIZE = 1048576;
+
+DatagramReceiveThread::DatagramReceiveThread(DatagramReceiver* receiver, int socketHandle, bool ownsSocket) :
+    _receiver(receiver),
+    _socketHandle(socketHandle),
+    _ownsSocket(ownsSocket),
+    _isStopping(0),
+    _queue(RECEIVED_DATAGRAM_QUEUE_CAPACITY)
+{
+
+}
+
+DatagramReceiveThread::~DatagramReceiveThread() {
+#ifdef HIFI_DATAGRAM_RECEIVE_THREADS
+    if (_ownsSocket) {
+        ::close(_socketHandle);
+    }
+#endif
+}
+
+void DatagramReceiveThread::run() {
+#ifdef HIFI_DATAGRAM_RECEIVE_THREADS
+    LimitedNodeList* nodeList = LimitedNodeList::getInstance();
+
+    mmsghdr messages[MAX_DATAGRAMS_PER_RECVMMSG];
+    iovec messageVectors[MAX_DATAGRAMS_PER_RECVMMSG][2];
+    sockaddr_in messageAddresses[MAX_DATAGRAMS_PER_RECVMMSG];
+    QByteArray overflow(MAX_DATAGRAMS_PER_RECVMMSG * MAX_DATAGRAM_OVERFLOW_SIZE, Qt::Uninitialized);
+
+    pollfd pollSocket;
+    pollSocket.fd = _socketHandle;
+    pollSocket.events = POLLIN;
+
+    while (!_isStopping.loadAcquire()) {
+        int numSlots = std::min(_queue.numFreeSlots(), MAX_DATAGRAMS_PER_RECVMMSG);
+        if (numSlots == 0) {
+            usleep(RECEIVE_QUEUE_FULL_SLEEP_USECS);
+            continue;
+        }
+
+        // the sockets are non-blocking, so wait here where we can still notice being stopped
+        pollSocket.revents = 0;
+        if (poll(&pollSocket, 1, RECEIVE_STOP_CHECK_INTERVAL_MSECS) <= 0) {
+            continue;
+        }
+
+        for (int i = 0; i < numSlots; i++) {
+            QByteArray& packet = _queue.freeSlot(i).packet;
+            packet.resize(MAX_PACKET_SIZE);
+
+            messageVectors[i][0].iov_base = packet.data();
+            messageVectors[i][0].iov_len = MAX_PACKET_SIZE;
+            messageVectors[i][1].iov_base = overflow.data() + (i * MAX_DATAGRAM_OVERFLOW_SIZE);
+            messageVectors[i][1].iov_len = MAX_DATAGRAM_OVERFLOW_SIZE;
+
+            mmsghdr& message = messages[i];
+            memset(&message, 0, sizeof(message));
+            message.msg_hdr.msg_name = &messageAddresses[i];
+            message.msg_hdr.msg_namelen = sizeof(messageAddresses[i]);
+            message.msg_hdr.msg_iov = messageVectors[i];
+            message.msg_hdr.msg_iovlen = 2;
+        }
+
+        int numReceived = recvmmsg(_socketHandle, messages, numSlots, MSG_DONTWAIT, NULL);
+        if (numReceived < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                qDebug() << "ERROR in recvmmsg:" << strerror(errno);
+            }
+            continue;
+        }
+
+        // drop anything that fails the checks, and move the rest up so the queued datagrams stay together
+        int numQueued = 0;
+        for (int i = 0; i < numReceived; i++) {
+            ReceivedDatagram& datagram = _queue.freeSlot(i);
+            int numBytes = messages[i].msg_len;
+
+            datagram.packet.resize(numBytes);
+            if (numBytes > MAX_PACKET_SIZE) {
+                memcpy(datagram.packet.data() + MAX_PACKET_SIZE, messageVectors[i][1].iov_base,
+                       numBytes - MAX_PACKET_SIZE);
+            }
+
+            if (numBytes == 0 || !nodeList->packetVersionAndHashMatch(datagram.packet)) {
+                continue;
+            }
+
+            ReceivedDatagram& queuedDatagram = _queue.freeSlot(numQueued);
+            if (&queuedDatagram != &datagram) {
+                qSwap(queuedDatagram.packet, datagram.packet);
+            }
+            queuedDatagram.senderSockAddr = HifiSockAddr(QHostAddress(ntohl(messageAddresses[i].sin_addr.s_addr)),
+                                                         ntohs(messageAddresses[i].sin_port));
+            ++numQueued;
+        }
+
+        if (numQueued > 0) {
+            _queue.push(numQueued);
+            _receiver->datagramsQueuedOnThread();
+        }
+    }
+#endif
+}
+
+DatagramReceiver::DatagramReceiver(QObject* parent) :
+    QObject(parent),
+    _threads(),
+    _hasSignalledQueuedDatagrams(0)
+{
+
+}
+
+DatagramReceiver::~DatagramReceiver() {
+    stop();
+}
+
+bool DatagramReceiver::isAvailable() {
+#ifdef HIFI_DATAGRAM_RECEIVE_THREADS
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool DatagramReceiver::start(int numThreads) {
+#ifdef HIFI_DATAGRAM_RECEIVE_THREADS
+    if (isRunning() || numThreads < 1) {
+        return false;
+    }
+
+    LimitedNodeList* nodeList = LimitedNodeList::getInstance();
+
+    // the first thread reads the node socket itself, the others need the port shared to open their own sockets on it
+    if (numThreads > 1 && !nodeList->rebindNodeSocket(true)) {
+        qDebug() << "Could not share the node socket's port, receiving datagrams on one thread.";
+        numThreads = 1;
+    }
+
+    _threads.append(new DatagramReceiveThread(this, nodeList->getNodeSocket().socketDescriptor(), false));
+
+    quint16 port = nodeList->getNodeSocket().localPort();
+    while (_threads.size() < numThreads) {
+        int socketHandle = LimitedNodeList::openSharedSocket(port);
+        if (socketHandle < 0) {
+            break;
+        }
+
+        setsockopt(socketHandle, SOL_SOCKET, SO_RCVBUF, &LARGER_RCVBUF_SIZE, sizeof(LARGER_RCVBUF_SIZE));
+        _threads.append(new DatagramReceiveThread(this, socketHandle, true));
+    }
+
+    foreach (DatagramReceiveThread* thread, _threads) {
+        thread->start();
+    }
+
+    qDebug() << "Receiving datagrams on" << _threads.size() << "thread(s).";
+    return true;
+#else
+    Q_UNUSED(numThreads);
+    return false;
+#endif
+}
+
+void DatagramReceiver::stop() {
+    if (!isRunning()) {
+        return;
+    }
+
+    foreach (DatagramReceiveThread* thread, _threads) {
+        thread->stop();
+    }
+    foreach (DatagramReceiveThread* thread, _threads) {
+        thread->wait();
+        delete thread;
+    }
+
+    _threads.clear();
+
+    // Qt stops watching a socket once it has said there are datagrams and nobody read them, so the node socket is
+    // replaced with a fresh one for whoever reads it next
+    LimitedNodeList::getInstance()->rebindNodeSocket(false);
+}
+
+void DatagramReceiver::datagramsQueuedOnThread() {
+    if (_hasSignalledQueuedDatagrams.testAndSetOrdered(0, 1)) {
+        emit datagramsQueued();
+    }
+}
@@ -0,0 +1,115 @@
+//
+//  DatagramReceiver.h
+//  libraries/networking/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Reads the datagrams sent to the node socket on dedicated threads instead of the Qt event loop.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_DatagramReceiver_h
+#define hifi_DatagramReceiver_h
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QList>
+#include <QtCore/QObject>
+#include <QtCore/QThread>
+
+#include "ReceivedDatagramQueue.h"
+
+const int RECEIVED_DATAGRAM_QUEUE_CAPACITY = 4096;
+
+class DatagramReceiver;
+
+/// reads one socket with recvmmsg, checks each datagram with packetVersionAndHashMatch and queues the ones that pass
+class DatagramReceiveThread : public QThread {
+    Q_OBJECT
+public:
+    DatagramReceiveThread(DatagramReceiver* receiver, int socketHandle, bool ownsSocket);
+    ~DatagramReceiveThread();
+
+    ReceivedDatagramQueue& getQueue() { return _queue; }
+
+    void stop() { _isStopping.storeRelease(1); }
+
+protected:
+    void run();
+
+private:
+    DatagramReceiver* _receiver;
+    int _socketHandle;
+    bool _ownsSocket;
+    QAtomicInt _isStopping;
+    ReceivedDatagramQueue _queue;
+};
+
+/// On linux, start rebinds the node socket with SO_REUSEPORT and opens more sockets on the same port, so the kernel
+/// spreads incoming datagrams across them by sender. Each socket gets its own receive thread, which does the system
+/// calls and the hash checks and hands what passes to the thread that owns the receiver through a lock-free queue.
+/// That thread then calls processQueuedDatagrams, either from its own loop or when datagramsQueued is emitted.
+///
+/// Datagrams from one sender always arrive on the same socket, so they stay in order. Datagrams from different senders
+/// can be handled in a different order than they arrived in, which they could always be reordered in on the network.
+class DatagramReceiver : public QObject {
+    Q_OBJECT
+public:
+    DatagramReceiver(QObject* parent = NULL);
+    ~DatagramReceiver();
+
+    /// whether this platform can receive on threads, if not callers should keep reading the node socket themselves
+    static bool isAvailable();
+
+    /// starts numThreads receive threads, returns false and leaves the node socket alone if they can't be started
+    /// must be called on the thread that owns the NodeList, readyRead on the node socket should be disconnected first
+    bool start(int numThreads);
+    void stop();
+
+    bool isRunning() const { return !_threads.isEmpty(); }
+    int getNumThreads() const { return _threads.size(); }
+
+    /// takes everything queued so far from every receive thread, in the order each thread queued it, and calls
+    /// processor->processDatagram for each one, returns the number of datagrams processed
+    template<typename Processor> int processQueuedDatagrams(Processor* processor);
+
+signals:
+    /// emitted when a receive thread queues datagrams and nobody has been told about queued datagrams yet
+    void datagramsQueued();
+
+private:
+    friend class DatagramReceiveThread;
+
+    void datagramsQueuedOnThread();
+
+    QList<DatagramReceiveThread*> _threads;
+    QAtomicInt _hasSignalledQueuedDatagrams;
+};
+
+template<typename Processor> int DatagramReceiver::processQueuedDatagrams(Processor* processor) {
+    // clear this first, so datagrams queued while we process will signal again
+    _hasSignalledQueuedDatagrams.storeRelease(0);
+
+    int numProcessed = 0;
+    foreach (DatagramReceiveThread* thread, _threads) {
+        ReceivedDatagramQueue& queue = thread->getQueue();
+
+        // take at most a queue's worth, so a busy receive thread can't keep us here forever
+        int numToProcess = queue.getCapacity();
+        ReceivedDatagram* datagram;
+        while (numToProcess-- > 0 && (datagram = queue.front())) {
+            processor->processDatagram(datagram->packet, datagram->senderSockAddr);
+            queue.pop();
+            ++numProcessed;
+        }
+
+        if (queue.front()) {
+            // come back for the rest once everything else waiting on this thread has had a turn
+            datagramsQueuedOnThread();
+        }
+    }
+    return numProcessed;
+}
+
+#endif // hifi_DatagramReceiver_h
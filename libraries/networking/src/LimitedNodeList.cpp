@@ -19,6 +19,12 @@
 #include <QtCore/QUrl>
 #include <QtNetwork/QHostInfo>
 
+#ifdef Q_OS_LINUX
+#include <errno.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#endif
+
 #include "AccountManager.h"
 #include "Assignment.h"
 #include "HifiSockAddr.h"
@@ -35,6 +41,31 @@ const char SOLO_NODE_TYPES[2] = {
 
 const QUrl DEFAULT_NODE_AUTH_URL = QUrl("https://data.highfidelity.io");
 
+const int LARGER_SNDBUF_SIZE = 1048576;
+
+static const QVector<SharedNodePointer> NO_NODES_OF_TYPE;
+
+NodeHashSnapshot::NodeHashSnapshot() :
+    _nodeHash(),
+    _nodesOfType()
+{
+    
+}
+
+NodeHashSnapshot::NodeHashSnapshot(const NodeHash& nodeHash) :
+    _nodeHash(nodeHash),
+    _nodesOfType()
+{
+    foreach (const SharedNodePointer& node, _nodeHash) {
+        _nodesOfType[node->getType()].append(node);
+    }
+}
+
+const QVector<SharedNodePointer>& NodeHashSnapshot::nodesOfType(NodeType_t nodeType) const {
+    QHash<NodeType_t, QVector<SharedNodePointer> >::const_iterator nodes = _nodesOfType.constFind(nodeType);
+    return (nodes == _nodesOfType.constEnd()) ? NO_NODES_OF_TYPE : nodes.value();
+}
+
 LimitedNodeList* LimitedNodeList::_sharedInstance = NULL;
 
 LimitedNodeList* LimitedNodeList::createInstance(unsigned short socketListenPort, unsigned short dtlsPort) {
@@ -65,10 +96,13 @@ LimitedNodeList::LimitedNodeList(unsigned short socketListenPort, unsigned short
     _sessionUUID(),
     _nodeHash(),
     _nodeHashMutex(QMutex::Recursive),
+    _nodeHashSnapshot(new NodeHashSnapshot()),
+    _nodeHashSnapshotMutex(),
     _nodeSocket(this),
     _dtlsSocket(NULL),
     _numCollectedPackets(0),
     _numCollectedBytes(0),
+    _numCollectedAllocations(0),
     _packetStatTimer()
 {
     _nodeSocket.bind(QHostAddress::AnyIPv4, socketListenPort);
@@ -82,12 +116,69 @@ LimitedNodeList::LimitedNodeList(unsigned short socketListenPort, unsigned short
         qDebug() << "NodeList DTLS socket is listening on" << _dtlsSocket->localPort();
     }
     
-    const int LARGER_SNDBUF_SIZE = 1048576;
     changeSendSocketBufferSize(LARGER_SNDBUF_SIZE);
     
     _packetStatTimer.start();
 }
 
+int LimitedNodeList::openSharedSocket(quint16 port) {
+#if defined(Q_OS_LINUX) && defined(SO_REUSEPORT)
+    int socketHandle = socket(AF_INET, SOCK_DGRAM, 0);
+    if (socketHandle < 0) {
+        qDebug() << "ERROR creating a socket to share port" << port << "-" << strerror(errno);
+        return -1;
+    }
+    
+    int optValue = 1;
+    setsockopt(socketHandle, SOL_SOCKET, SO_REUSEPORT, &optValue, sizeof(optValue));
+    
+    sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    
+    if (bind(socketHandle, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+        qDebug() << "ERROR binding a socket to share port" << port << "-" << strerror(errno);
+        ::close(socketHandle);
+        return -1;
+    }
+    
+    return socketHandle;
+#else
+    Q_UNUSED(port);
+    return -1;
+#endif
+}
+
+bool LimitedNodeList::rebindNodeSocket(bool shouldSharePort) {
+    quint16 port = _nodeSocket.localPort();
+    
+    // the port has to be free before we can bind it again, so anything waiting in the old socket is lost
+    _nodeSocket.close();
+    
+#if defined(Q_OS_LINUX) && defined(SO_REUSEPORT)
+    if (shouldSharePort) {
+        int socketHandle = openSharedSocket(port);
+        if (socketHandle >= 0 && _nodeSocket.setSocketDescriptor(socketHandle, QAbstractSocket::BoundState)) {
+            qDebug() << "NodeList socket is listening on" << port << "and sharing the port";
+            changeSendSocketBufferSize(LARGER_SNDBUF_SIZE);
+            return true;
+        }
+        
+        if (socketHandle >= 0) {
+            ::close(socketHandle);
+        }
+    }
+#endif
+    
+    _nodeSocket.bind(QHostAddress::AnyIPv4, port);
+    qDebug() << "NodeList socket is listening on" << _nodeSocket.localPort();
+    changeSendSocketBufferSize(LARGER_SNDBUF_SIZE);
+    
+    return !shouldSharePort;
+}
+
 void LimitedNodeList::setSessionUUID(const QUuid& sessionUUID) {
     QUuid oldUUID = _sessionUUID;
     _sessionUUID = sessionUUID;
@@ -160,6 +251,10 @@ bool LimitedNodeList::packetVersionAndHashMatch(const QByteArray& packet) {
         
         static QMultiMap<QUuid, PacketType> versionDebugSuppressMap;
         
+        // packets can be checked on several receive threads at once
+        static QMutex versionDebugSuppressMutex;
+        QMutexLocker versionDebugSuppressLocker(&versionDebugSuppressMutex);
+        
         QUuid senderUUID = uuidFromPacketHeader(packet);
         if (!versionDebugSuppressMap.contains(senderUUID, checkType)) {
             qDebug() << "Packet version mismatch on" << packetTypeForPacket(packet) << "- Sender"
@@ -176,8 +271,8 @@ bool LimitedNodeList::packetVersionAndHashMatch(const QByteArray& packet) {
         // figure out which node this is from
         SharedNodePointer sendingNode = sendingNodeForPacket(packet);
         if (sendingNode) {
-            // check if the md5 hash in the header matches the hash we would expect
-            if (hashFromPacketHeader(packet) == hashForPacketAndConnectionUUID(packet, sendingNode->getConnectionSecret())) {
+            // check if the hash in the header matches the hash we would expect
+            if (packetHashMatchesConnectionUUID(packet.constData(), packet.size(), sendingNode->getConnectionSecret())) {
                 return true;
             } else {
                 qDebug() << "Packet hash mismatch on" << checkType << "- Sender"
@@ -196,18 +291,47 @@ bool LimitedNodeList::packetVersionAndHashMatch(const QByteArray& packet) {
 
 qint64 LimitedNodeList::writeDatagram(const QByteArray& datagram, const HifiSockAddr& destinationSockAddr,
                                       const QUuid& connectionSecret) {
-    QByteArray datagramCopy = datagram;
+    return writeDatagram(datagram.constData(), datagram.size(), destinationSockAddr, connectionSecret);
+}
+
+qint64 LimitedNodeList::writeDatagram(const char* data, qint64 size, const HifiSockAddr& destinationSockAddr,
+                                      const QUuid& connectionSecret) {
+    if (connectionSecret.isNull()) {
+        // nothing to write into the datagram, send the caller's bytes as they are
+        return writeRawDatagram(data, size, destinationSockAddr);
+    }
     
+    if (size <= MAX_PACKET_SIZE) {
+        // the hash has to go in a copy since the caller's buffer is const, but that copy can live on the stack
+        char datagramCopy[MAX_PACKET_SIZE];
+        memcpy(datagramCopy, data, size);
+        
+        return writeDatagramInPlace(datagramCopy, size, destinationSockAddr, connectionSecret);
+    }
+    
+    // this is too big for a single packet anyways, but we still send it and count the allocation for the copy
+    _numCollectedAllocations.ref();
+    QByteArray datagramCopy(data, size);
+    
+    return writeDatagramInPlace(datagramCopy.data(), size, destinationSockAddr, connectionSecret);
+}
+
+qint64 LimitedNodeList::writeDatagramInPlace(char* data, qint64 size, const HifiSockAddr& destinationSockAddr,
+                                             const QUuid& connectionSecret) {
     if (!connectionSecret.isNull()) {
-        // setup the MD5 hash for source verification in the header
-        replaceHashInPacketGivenConnectionUUID(datagramCopy, connectionSecret);
+        // setup the hash for source verification in the header
+        writeHashInPacketGivenConnectionUUID(data, size, connectionSecret);
     }
     
+    return writeRawDatagram(data, size, destinationSockAddr);
+}
+
+qint64 LimitedNodeList::writeRawDatagram(const char* data, qint64 size, const HifiSockAddr& destinationSockAddr) {
     // stat collection for packets
     ++_numCollectedPackets;
-    _numCollectedBytes += datagram.size();
+    _numCollectedBytes += size;
     
-    qint64 bytesWritten = _nodeSocket.writeDatagram(datagramCopy,
+    qint64 bytesWritten = _nodeSocket.writeDatagram(data, size,
                                                     destinationSockAddr.getAddress(), destinationSockAddr.getPort());
     
     if (bytesWritten < 0) {
@@ -219,61 +343,173 @@ qint64 LimitedNodeList::writeDatagram(const QByteArray& datagram, const HifiSock
 
 qint64 LimitedNodeList::writeDatagram(const QByteArray& datagram, const SharedNodePointer& destinationNode,
                                const HifiSockAddr& overridenSockAddr) {
-    if (destinationNode) {
-        // if we don't have an ovveriden address, assume they want to send to the node's active socket
-        const HifiSockAddr* destinationSockAddr = &overridenSockAddr;
-        if (overridenSockAddr.isNull()) {
-            if (destinationNode->getActiveSocket()) {
-                // use the node's active socket as the destination socket
-                destinationSockAddr = destinationNode->getActiveSocket();
-            } else {
-                // we don't have a socket to send to, return 0
-                return 0;
-            }
-        }
-        
-        return writeDatagram(datagram, *destinationSockAddr, destinationNode->getConnectionSecret());
+    return writeDatagram(datagram.constData(), datagram.size(), destinationNode, overridenSockAddr);
+}
+
+qint64 LimitedNodeList::writeUnverifiedDatagram(const QByteArray& datagram, const SharedNodePointer& destinationNode,
+                               const HifiSockAddr& overridenSockAddr) {
+    return writeUnverifiedDatagram(datagram.constData(), datagram.size(), destinationNode, overridenSockAddr);
+}
+
+qint64 LimitedNodeList::writeUnverifiedDatagram(const QByteArray& datagram, const HifiSockAddr& destinationSockAddr) {
+    return writeRawDatagram(datagram.constData(), datagram.size(), destinationSockAddr);
+}
+
+qint64 LimitedNodeList::writeDatagram(const char* data, qint64 size, const SharedNodePointer& destinationNode,
+                               const HifiSockAddr& overridenSockAddr) {
+    const HifiSockAddr* destinationSockAddr = destinationSockAddrForNode(destinationNode, overridenSockAddr);
+    if (destinationSockAddr) {
+        return writeDatagram(data, size, *destinationSockAddr, destinationNode->getConnectionSecret());
     }
     
-    // didn't have a destinationNode to send to, return 0
+    // we don't have a socket to send to, return 0
     return 0;
 }
 
-qint64 LimitedNodeList::writeUnverifiedDatagram(const QByteArray& datagram, const SharedNodePointer& destinationNode,
+qint64 LimitedNodeList::writeUnverifiedDatagram(const char* data, qint64 size, const SharedNodePointer& destinationNode,
                                const HifiSockAddr& overridenSockAddr) {
-    if (destinationNode) {
-        // if we don't have an ovveriden address, assume they want to send to the node's active socket
-        const HifiSockAddr* destinationSockAddr = &overridenSockAddr;
-        if (overridenSockAddr.isNull()) {
-            if (destinationNode->getActiveSocket()) {
-                // use the node's active socket as the destination socket
-                destinationSockAddr = destinationNode->getActiveSocket();
-            } else {
-                // we don't have a socket to send to, return 0
-                return 0;
-            }
-        }
-        
+    const HifiSockAddr* destinationSockAddr = destinationSockAddrForNode(destinationNode, overridenSockAddr);
+    if (destinationSockAddr) {
         // don't use the node secret!
-        return writeDatagram(datagram, *destinationSockAddr, QUuid());
+        return writeRawDatagram(data, size, *destinationSockAddr);
     }
     
-    // didn't have a destinationNode to send to, return 0
+    // we don't have a socket to send to, return 0
     return 0;
 }
 
-qint64 LimitedNodeList::writeUnverifiedDatagram(const QByteArray& datagram, const HifiSockAddr& destinationSockAddr) {
-    return writeDatagram(datagram, destinationSockAddr, QUuid());
+const HifiSockAddr* LimitedNodeList::destinationSockAddrForNode(const SharedNodePointer& destinationNode,
+                                                                const HifiSockAddr& overridenSockAddr) {
+    if (!destinationNode) {
+        // didn't have a destinationNode to send to
+        return NULL;
+    }
+    
+    // if we don't have an ovveriden address, assume they want to send to the node's active socket
+    if (overridenSockAddr.isNull()) {
+        // this is NULL if the node doesn't have an active socket yet
+        return destinationNode->getActiveSocket();
+    }
+    
+    return &overridenSockAddr;
 }
 
-qint64 LimitedNodeList::writeDatagram(const char* data, qint64 size, const SharedNodePointer& destinationNode,
-                               const HifiSockAddr& overridenSockAddr) {
-    return writeDatagram(QByteArray(data, size), destinationNode, overridenSockAddr);
+bool LimitedNodeList::queueDatagram(DatagramBatch& batch, const char* data, qint64 size,
+                                    const SharedNodePointer& destinationNode, const HifiSockAddr& overridenSockAddr) {
+    const HifiSockAddr* destinationSockAddr = destinationSockAddrForNode(destinationNode, overridenSockAddr);
+    if (!destinationSockAddr) {
+        return false;
+    }
+    
+    bool didAllocate = false;
+    QByteArray& datagram = batch.append(size, *destinationSockAddr, didAllocate);
+    memcpy(datagram.data(), data, size);
+    
+    if (didAllocate) {
+        _numCollectedAllocations.ref();
+    }
+    
+    if (!destinationNode->getConnectionSecret().isNull()) {
+        // setup the hash for source verification in the header
+        writeHashInPacketGivenConnectionUUID(datagram.data(), size, destinationNode->getConnectionSecret());
+    }
+    
+    return true;
 }
 
-qint64 LimitedNodeList::writeUnverifiedDatagram(const char* data, qint64 size, const SharedNodePointer& destinationNode,
-                               const HifiSockAddr& overridenSockAddr) {
-    return writeUnverifiedDatagram(QByteArray(data, size), destinationNode, overridenSockAddr);
+bool LimitedNodeList::queueDatagram(DatagramBatch& batch, const QByteArray& datagram,
+                                    const SharedNodePointer& destinationNode, const HifiSockAddr& overridenSockAddr) {
+    return queueDatagram(batch, datagram.constData(), datagram.size(), destinationNode, overridenSockAddr);
+}
+
+int LimitedNodeList::flushDatagramBatch(DatagramBatch& batch) {
+    int numDatagrams = batch.size();
+    int numSent = 0;
+    int nextDatagram = 0;
+    
+#ifdef Q_OS_LINUX
+    // the kernel won't take more than UIO_MAXIOV messages in one call, we go well under that to keep this on the stack
+    const int MAX_DATAGRAMS_PER_SENDMMSG = 64;
+    
+    mmsghdr messages[MAX_DATAGRAMS_PER_SENDMMSG];
+    iovec messageVectors[MAX_DATAGRAMS_PER_SENDMMSG];
+    sockaddr_in messageAddresses[MAX_DATAGRAMS_PER_SENDMMSG];
+    
+    int socketHandle = _nodeSocket.socketDescriptor();
+    
+    while (nextDatagram < numDatagrams) {
+        // gather the next run of IPv4 datagrams, our socket is bound to IPv4 so that should be all of them
+        int numMessages = 0;
+        while (nextDatagram + numMessages < numDatagrams && numMessages < MAX_DATAGRAMS_PER_SENDMMSG) {
+            const HifiSockAddr& destination = batch._destinations[nextDatagram + numMessages];
+            if (destination.getAddress().protocol() != QAbstractSocket::IPv4Protocol) {
+                break;
+            }
+            
+            const QByteArray& datagram = batch._datagrams[nextDatagram + numMessages];
+            
+            sockaddr_in& address = messageAddresses[numMessages];
+            memset(&address, 0, sizeof(address));
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(destination.getAddress().toIPv4Address());
+            address.sin_port = htons(destination.getPort());
+            
+            messageVectors[numMessages].iov_base = const_cast<char*>(datagram.constData());
+            messageVectors[numMessages].iov_len = datagram.size();
+            
+            mmsghdr& message = messages[numMessages];
+            memset(&message, 0, sizeof(message));
+            message.msg_hdr.msg_name = &address;
+            message.msg_hdr.msg_namelen = sizeof(address);
+            message.msg_hdr.msg_iov = &messageVectors[numMessages];
+            message.msg_hdr.msg_iovlen = 1;
+            
+            ++numMessages;
+        }
+        
+        if (numMessages == 0) {
+            // not something we can hand to sendmmsg, let the socket deal with it
+            const QByteArray& datagram = batch._datagrams[nextDatagram];
+            if (writeRawDatagram(datagram.constData(), datagram.size(), batch._destinations[nextDatagram]) >= 0) {
+                ++numSent;
+            }
+            ++nextDatagram;
+            continue;
+        }
+        
+        int numMessagesSent = sendmmsg(socketHandle, messages, numMessages, 0);
+        
+        if (numMessagesSent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            
+            qDebug() << "ERROR in sendmmsg:" << strerror(errno) << "- writing the rest of the batch one at a time";
+            break;
+        }
+        
+        // stat collection for packets
+        for (int i = 0; i < numMessagesSent; i++) {
+            ++_numCollectedPackets;
+            _numCollectedBytes += messageVectors[i].iov_len;
+        }
+        
+        numSent += numMessagesSent;
+        nextDatagram += numMessagesSent;
+    }
+#endif
+    
+    // write whatever is left one datagram at a time, they've already been hashed
+    for (; nextDatagram < numDatagrams; nextDatagram++) {
+        const QByteArray& datagram = batch._datagrams[nextDatagram];
+        if (writeRawDatagram(datagram.constData(), datagram.size(), batch._destinations[nextDatagram]) >= 0) {
+            ++numSent;
+        }
+    }
+    
+    batch.clear();
+    
+    return numSent;
 }
 
 void LimitedNodeList::processNodeData(const HifiSockAddr& senderSockAddr, const QByteArray& packet) {
@@ -312,19 +548,11 @@ int LimitedNodeList::findNodeAndUpdateWithDataFromPacket(const QByteArray& packe
 }
 
 SharedNodePointer LimitedNodeList::nodeWithUUID(const QUuid& nodeUUID, bool blockingLock) {
-    const int WAIT_TIME = 10; // wait up to 10ms in the try lock case
-    SharedNodePointer node;
-    // if caller wants us to block and guarantee the correct answer, then honor that request
-    if (blockingLock) {
-        // this will block till we can get access
-        QMutexLocker locker(&_nodeHashMutex);
-        node = _nodeHash.value(nodeUUID);
-    } else if (_nodeHashMutex.tryLock(WAIT_TIME)) { // some callers are willing to get wrong answers but not block
-        node = _nodeHash.value(nodeUUID);
-        _nodeHashMutex.unlock();
-    }
-    return node;
- }
+    // the snapshot is published before a change to the node hash releases the mutex, so this is the same answer
+    // holding the mutex would give, without waiting for a change in progress
+    Q_UNUSED(blockingLock);
+    return getNodeHashSnapshot()->getNodeHash().value(nodeUUID);
+}
 
 SharedNodePointer LimitedNodeList::sendingNodeForPacket(const QByteArray& packet) {
     QUuid nodeUUID = uuidFromPacketHeader(packet);
@@ -333,9 +561,22 @@ SharedNodePointer LimitedNodeList::sendingNodeForPacket(const QByteArray& packet
     return nodeWithUUID(nodeUUID);
 }
 
+NodeHashSnapshotPointer LimitedNodeList::getNodeHashSnapshot() const {
+    // this lock only covers copying the pointer, it is never held while the node hash changes
+    QMutexLocker locker(&_nodeHashSnapshotMutex);
+    return _nodeHashSnapshot;
+}
+
 NodeHash LimitedNodeList::getNodeHash() {
-    QMutexLocker locker(&_nodeHashMutex);
-    return NodeHash(_nodeHash);
+    return getNodeHashSnapshot()->getNodeHash();
+}
+
+void LimitedNodeList::publishNodeHashSnapshot() {
+    // build the new snapshot before taking the lock, readers only ever wait for the pointer swap
+    NodeHashSnapshotPointer newSnapshot(new NodeHashSnapshot(_nodeHash));
+    
+    QMutexLocker locker(&_nodeHashSnapshotMutex);
+    _nodeHashSnapshot = newSnapshot;
 }
 
 void LimitedNodeList::eraseAllNodes() {
@@ -349,6 +590,8 @@ void LimitedNodeList::eraseAllNodes() {
     while (nodeItem != _nodeHash.end()) {
         nodeItem = killNodeAtHashIterator(nodeItem);
     }
+    
+    publishNodeHashSnapshot();
 }
 
 void LimitedNodeList::reset() {
@@ -361,6 +604,7 @@ void LimitedNodeList::killNodeWithUUID(const QUuid& nodeUUID) {
     NodeHash::iterator nodeItemToKill = _nodeHash.find(nodeUUID);
     if (nodeItemToKill != _nodeHash.end()) {
         killNodeAtHashIterator(nodeItemToKill);
+        publishNodeHashSnapshot();
     }
 }
 
@@ -389,6 +633,7 @@ SharedNodePointer LimitedNodeList::addOrUpdateNode(const QUuid& uuid, NodeType_t
         SharedNodePointer newNodeSharedPointer(newNode, &QObject::deleteLater);
         
         _nodeHash.insert(newNode->getUUID(), newNodeSharedPointer);
+        publishNodeHashSnapshot();
         
         _nodeHashMutex.unlock();
         
@@ -445,15 +690,19 @@ unsigned LimitedNodeList::broadcastToNodes(const QByteArray& packet, const NodeS
 SharedNodePointer LimitedNodeList::soloNodeOfType(char nodeType) {
 
     if (memchr(SOLO_NODE_TYPES, nodeType, sizeof(SOLO_NODE_TYPES))) {
-        foreach (const SharedNodePointer& node, getNodeHash()) {
-            if (node->getType() == nodeType) {
-                return node;
-            }
+        NodeHashSnapshotPointer snapshot = getNodeHashSnapshot();
+        const QVector<SharedNodePointer>& nodesOfType = snapshot->nodesOfType(nodeType);
+        if (!nodesOfType.isEmpty()) {
+            return nodesOfType.first();
         }
     }
     return SharedNodePointer();
 }
 
+float LimitedNodeList::getAllocationsPerPacket() const {
+    return (_numCollectedPackets > 0) ? (float) _numCollectedAllocations.load() / (float) _numCollectedPackets : 0.0f;
+}
+
 void LimitedNodeList::getPacketStats(float& packetsPerSecond, float& bytesPerSecond) {
     packetsPerSecond = (float) _numCollectedPackets / ((float) _packetStatTimer.elapsed() / 1000.0f);
     bytesPerSecond = (float) _numCollectedBytes / ((float) _packetStatTimer.elapsed() / 1000.0f);
@@ -461,6 +710,7 @@ void LimitedNodeList::getPacketStats(float& packetsPerSecond, float& bytesPerSec
 
 void LimitedNodeList::resetPacketStats() {
     _numCollectedPackets = 0;
+    _numCollectedAllocations.store(0);
     _numCollectedBytes = 0;
     _packetStatTimer.restart();
 }
@@ -470,6 +720,7 @@ void LimitedNodeList::removeSilentNodes() {
     _nodeHashMutex.lock();
     
     NodeHash::iterator nodeItem = _nodeHash.begin();
+    bool hasKilledNode = false;
 
     while (nodeItem != _nodeHash.end()) {
         SharedNodePointer node = nodeItem.value();
@@ -479,6 +730,7 @@ void LimitedNodeList::removeSilentNodes() {
         if ((usecTimestampNow() - node->getLastHeardMicrostamp()) > (NODE_SILENCE_THRESHOLD_MSECS * 1000)) {
             // call our private method to kill this node (removes it and emits the right signal)
             nodeItem = killNodeAtHashIterator(nodeItem);
+            hasKilledNode = true;
         } else {
             // we didn't kill this node, push the iterator forwards
             ++nodeItem;
@@ -487,5 +739,9 @@ void LimitedNodeList::removeSilentNodes() {
         node->getMutex().unlock();
     }
     
+    if (hasKilledNode) {
+        publishNodeHashSnapshot();
+    }
+    
     _nodeHashMutex.unlock();
 }
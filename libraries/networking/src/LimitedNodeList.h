@@ -19,14 +19,18 @@
 #include <unistd.h> // not on windows, not needed for mac or windows
 #endif
 
+#include <QtCore/QAtomicInt>
 #include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
 #include <QtCore/QMutex>
 #include <QtCore/QSet>
 #include <QtCore/QSettings>
 #include <QtCore/QSharedPointer>
+#include <QtCore/QVector>
 #include <QtNetwork/QHostAddress>
 #include <QtNetwork/QUdpSocket>
 
+#include "DatagramBatch.h"
 #include "DomainHandler.h"
 #include "Node.h"
 
@@ -48,6 +52,27 @@ typedef QSharedPointer<Node> SharedNodePointer;
 typedef QHash<QUuid, SharedNodePointer> NodeHash;
 Q_DECLARE_METATYPE(SharedNodePointer)
 
+/// An immutable copy of the node hash as it was when the LimitedNodeList published it. Readers share one snapshot
+/// without copying it or holding the node hash mutex, a change to the node hash publishes a new snapshot instead of
+/// touching this one. The nodes are also kept by type, so a reader that only wants one type doesn't scan the rest.
+class NodeHashSnapshot {
+public:
+    NodeHashSnapshot();
+    NodeHashSnapshot(const NodeHash& nodeHash);
+    
+    const NodeHash& getNodeHash() const { return _nodeHash; }
+    int size() const { return _nodeHash.size(); }
+    
+    /// every node of nodeType in the snapshot, in no particular order
+    const QVector<SharedNodePointer>& nodesOfType(NodeType_t nodeType) const;
+    
+private:
+    NodeHash _nodeHash;
+    QHash<NodeType_t, QVector<SharedNodePointer> > _nodesOfType;
+};
+
+typedef QSharedPointer<const NodeHashSnapshot> NodeHashSnapshotPointer;
+
 class LimitedNodeList : public QObject {
     Q_OBJECT
 public:
@@ -58,6 +83,15 @@ public:
     void setSessionUUID(const QUuid& sessionUUID);
     
     QUdpSocket& getNodeSocket() { return _nodeSocket; }
+    
+    /// closes the node socket and binds a new one to the same port, with SO_REUSEPORT set if shouldSharePort is true
+    /// so that other sockets can be bound to the port with it, returns false if the port couldn't be shared
+    /// must be called on the thread that owns the NodeList while nothing else is writing to the node socket
+    bool rebindNodeSocket(bool shouldSharePort);
+    
+    /// opens a UDP socket bound to port with SO_REUSEPORT set and returns its descriptor, or -1 if that isn't possible
+    /// any socket already bound to the port must have been shared the same way, the caller closes the returned socket
+    static int openSharedSocket(quint16 port);
     QUdpSocket& getDTLSSocket();
     
     bool packetVersionAndHashMatch(const QByteArray& packet);
@@ -75,11 +109,27 @@ public:
     qint64 writeUnverifiedDatagram(const char* data, qint64 size, const SharedNodePointer& destinationNode,
                          const HifiSockAddr& overridenSockAddr = HifiSockAddr());
 
+    /// copies and hashes a datagram for destinationNode into batch, returns false if there is nowhere to send it
+    /// the datagram is only sent once the batch is flushed, so the caller can re-use its buffer right away
+    bool queueDatagram(DatagramBatch& batch, const char* data, qint64 size, const SharedNodePointer& destinationNode,
+                       const HifiSockAddr& overridenSockAddr = HifiSockAddr());
+    bool queueDatagram(DatagramBatch& batch, const QByteArray& datagram, const SharedNodePointer& destinationNode,
+                       const HifiSockAddr& overridenSockAddr = HifiSockAddr());
+
+    /// sends and clears every datagram queued in batch, returns the number that were sent
+    /// on linux this takes as few sendmmsg calls as possible, elsewhere each datagram is written on its own
+    int flushDatagramBatch(DatagramBatch& batch);
+
     void(*linkedDataCreateCallback)(Node *);
 
+    /// the current snapshot of the node hash, this never waits on a change to the node hash that is in progress
+    NodeHashSnapshotPointer getNodeHashSnapshot() const;
+    
+    /// the node hash from the current snapshot, which shares its data rather than copying it
     NodeHash getNodeHash();
-    int size() const { return _nodeHash.size(); }
+    int size() const { return getNodeHashSnapshot()->size(); }
 
+    /// looks nodeUUID up in the current snapshot, so it never blocks - blockingLock is only kept for existing callers
     SharedNodePointer nodeWithUUID(const QUuid& nodeUUID, bool blockingLock = true);
     SharedNodePointer sendingNodeForPacket(const QByteArray& packet);
     
@@ -98,6 +148,9 @@ public:
     SharedNodePointer soloNodeOfType(char nodeType);
 
     void getPacketStats(float &packetsPerSecond, float &bytesPerSecond);
+    
+    /// the heap allocations made on the send path since the last reset, per packet sent, this should stay at zero
+    float getAllocationsPerPacket() const;
     void resetPacketStats();
 public slots:
     void reset();
@@ -119,8 +172,24 @@ protected:
     
     qint64 writeDatagram(const QByteArray& datagram, const HifiSockAddr& destinationSockAddr,
                          const QUuid& connectionSecret);
+    qint64 writeDatagram(const char* data, qint64 size, const HifiSockAddr& destinationSockAddr,
+                         const QUuid& connectionSecret);
+    /// writes the hash for connectionSecret into data's header and sends it, so data has to be a buffer we can write to
+    qint64 writeDatagramInPlace(char* data, qint64 size, const HifiSockAddr& destinationSockAddr,
+                                const QUuid& connectionSecret);
+    
+    /// writes the datagram to the node socket as it is and collects stats for it
+    qint64 writeRawDatagram(const char* data, qint64 size, const HifiSockAddr& destinationSockAddr);
+    
+    /// the socket to send to destinationNode on, or NULL if there isn't one
+    const HifiSockAddr* destinationSockAddrForNode(const SharedNodePointer& destinationNode,
+                                                   const HifiSockAddr& overridenSockAddr);
 
+    /// the caller must hold _nodeHashMutex and publish a new snapshot once it is done changing the node hash
     NodeHash::iterator killNodeAtHashIterator(NodeHash::iterator& nodeItemToKill);
+    
+    /// makes the node hash as it is now the snapshot readers get, the caller must hold _nodeHashMutex
+    void publishNodeHashSnapshot();
 
     
     void changeSendSocketBufferSize(int numSendBytes);
@@ -128,10 +197,13 @@ protected:
     QUuid _sessionUUID;
     NodeHash _nodeHash;
     QMutex _nodeHashMutex;
+    NodeHashSnapshotPointer _nodeHashSnapshot;
+    mutable QMutex _nodeHashSnapshotMutex;
     QUdpSocket _nodeSocket;
     QUdpSocket* _dtlsSocket;
     int _numCollectedPackets;
     int _numCollectedBytes;
+    QAtomicInt _numCollectedAllocations; // queueDatagram can be called from several threads, each with its own batch
     QElapsedTimer _packetStatTimer;
 };
 
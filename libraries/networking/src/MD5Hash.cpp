@@ -0,0 +1,148 @@
+//
+//  MD5Hash.cpp
+//  libraries/networking/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <string.h>
+
+#include "MD5Hash.h"
+
+// the per round shift amounts and sine derived constants from RFC 1321
+static const int MD5_SHIFTS[64] = {
+    7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+    5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+    4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+    6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21
+};
+
+static const quint32 MD5_CONSTANTS[64] = {
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+    0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+    0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+    0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+    0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+    0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+};
+
+const int MD5_BLOCK_BYTES = 64;
+
+MD5Hash::MD5Hash() :
+    _length(0)
+{
+    _state[0] = 0x67452301;
+    _state[1] = 0xefcdab89;
+    _state[2] = 0x98badcfe;
+    _state[3] = 0x10325476;
+}
+
+static inline quint32 rotateLeft(quint32 value, int shift) {
+    return (value << shift) | (value >> (32 - shift));
+}
+
+void MD5Hash::processBlock(const uchar* block) {
+    quint32 words[16];
+    for (int i = 0; i < 16; i++) {
+        // MD5 reads its input as little endian words, whatever the platform is
+        words[i] = (quint32) block[i * 4] | ((quint32) block[(i * 4) + 1] << 8)
+            | ((quint32) block[(i * 4) + 2] << 16) | ((quint32) block[(i * 4) + 3] << 24);
+    }
+
+    quint32 a = _state[0];
+    quint32 b = _state[1];
+    quint32 c = _state[2];
+    quint32 d = _state[3];
+
+    for (int i = 0; i < 64; i++) {
+        quint32 f;
+        int wordIndex;
+
+        if (i < 16) {
+            f = (b & c) | (~b & d);
+            wordIndex = i;
+        } else if (i < 32) {
+            f = (d & b) | (~d & c);
+            wordIndex = ((5 * i) + 1) % 16;
+        } else if (i < 48) {
+            f = b ^ c ^ d;
+            wordIndex = ((3 * i) + 5) % 16;
+        } else {
+            f = c ^ (b | ~d);
+            wordIndex = (7 * i) % 16;
+        }
+
+        quint32 rotated = rotateLeft(a + f + MD5_CONSTANTS[i] + words[wordIndex], MD5_SHIFTS[i]);
+        a = d;
+        d = c;
+        c = b;
+        b = b + rotated;
+    }
+
+    _state[0] += a;
+    _state[1] += b;
+    _state[2] += c;
+    _state[3] += d;
+}
+
+void MD5Hash::addData(const char* data, int length) {
+    const uchar* input = reinterpret_cast<const uchar*>(data);
+    int numBufferedBytes = _length % MD5_BLOCK_BYTES;
+    _length += length;
+
+    if (numBufferedBytes > 0) {
+        // top up the partial block from last time first
+        int numBytesToCopy = qMin(length, MD5_BLOCK_BYTES - numBufferedBytes);
+        memcpy(_block + numBufferedBytes, input, numBytesToCopy);
+        input += numBytesToCopy;
+        length -= numBytesToCopy;
+
+        if (numBufferedBytes + numBytesToCopy < MD5_BLOCK_BYTES) {
+            return;
+        }
+
+        processBlock(_block);
+    }
+
+    while (length >= MD5_BLOCK_BYTES) {
+        processBlock(input);
+        input += MD5_BLOCK_BYTES;
+        length -= MD5_BLOCK_BYTES;
+    }
+
+    memcpy(_block, input, length);
+}
+
+void MD5Hash::result(char* digest) {
+    quint64 numBits = _length * 8;
+
+    // pad with a one bit and then zeros up to 8 bytes short of a block, then the length in bits
+    const int MD5_LENGTH_BYTES = 8;
+    uchar padding[MD5_BLOCK_BYTES * 2];
+    memset(padding, 0, sizeof(padding));
+    padding[0] = 0x80;
+
+    int numBufferedBytes = _length % MD5_BLOCK_BYTES;
+    int numPaddingBytes = (numBufferedBytes < MD5_BLOCK_BYTES - MD5_LENGTH_BYTES)
+        ? (MD5_BLOCK_BYTES - MD5_LENGTH_BYTES - numBufferedBytes)
+        : ((MD5_BLOCK_BYTES * 2) - MD5_LENGTH_BYTES - numBufferedBytes);
+
+    for (int i = 0; i < MD5_LENGTH_BYTES; i++) {
+        padding[numPaddingBytes + i] = (uchar) (numBits >> (i * 8));
+    }
+
+    addData(reinterpret_cast<const char*>(padding), numPaddingBytes + MD5_LENGTH_BYTES);
+
+    uchar* digestBytes = reinterpret_cast<uchar*>(digest);
+    for (int i = 0; i < 4; i++) {
+        digestBytes[i * 4] = (uchar) _state[i];
+        digestBytes[(i * 4) + 1] = (uchar) (_state[i] >> 8);
+        digestBytes[(i * 4) + 2] = (uchar) (_state[i] >> 16);
+        digestBytes[(i * 4) + 3] = (uchar) (_state[i] >> 24);
+    }
+}
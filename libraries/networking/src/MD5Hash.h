@@ -0,0 +1,39 @@
+//
+//  MD5Hash.h
+//  libraries/networking/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  An MD5 digest that is built up without touching the heap, for hashing packets on the send and receive paths.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_MD5Hash_h
+#define hifi_MD5Hash_h
+
+#include <QtCore/QtGlobal>
+
+const int NUM_BYTES_MD5_DIGEST = 16;
+
+/// Produces the same digest as QCryptographicHash::Md5, but keeps all of its state in the object so the hash of a
+/// packet can be written straight into the packet's header with no allocation or copy.
+class MD5Hash {
+public:
+    MD5Hash();
+
+    void addData(const char* data, int length);
+
+    /// finishes the hash and writes NUM_BYTES_MD5_DIGEST bytes to digest, the hash can't take more data after this
+    void result(char* digest);
+
+private:
+    void processBlock(const uchar* block);
+
+    quint32 _state[4];
+    quint64 _length;
+    uchar _block[64];
+};
+
+#endif // hifi_MD5Hash_h
@@ -13,7 +13,9 @@
 
 #include <QtCore/QDebug>
 
+#include "MD5Hash.h"
 #include "NodeList.h"
+#include "SipHash.h"
 
 #include "PacketHeaders.h"
 
@@ -50,10 +52,14 @@ PacketVersion versionForPacketType(PacketType type) {
         case PacketTypeMicrophoneAudioNoEcho:
         case PacketTypeMicrophoneAudioWithEcho:
         case PacketTypeSilentAudioFrame:
-            return 2;
-        case PacketTypeMixedAudio:
+            return 3;
+        case PacketTypeInjectAudio:
             return 1;
+        case PacketTypeMixedAudio:
+            return 2;
         case PacketTypeAvatarData:
+            return 5;
+        case PacketTypeBulkAvatarData:
             return 3;
         case PacketTypeAvatarIdentity:
             return 1;
@@ -85,6 +91,28 @@ PacketVersion versionForPacketType(PacketType type) {
     }
 }
 
+bool packetUsesSipHash(PacketType type, PacketVersion version) {
+    // the high rate audio and avatar packet types switched from an MD5 hash to a SipHash MAC at these versions,
+    // anything else, or an older version of these, is still hashed with MD5
+    // (the octree data types are left alone since their version is also the version of saved SVO files)
+    switch (type) {
+        case PacketTypeMicrophoneAudioNoEcho:
+        case PacketTypeMicrophoneAudioWithEcho:
+        case PacketTypeSilentAudioFrame:
+            return version >= 3;
+        case PacketTypeInjectAudio:
+            return version >= 1;
+        case PacketTypeMixedAudio:
+            return version >= 2;
+        case PacketTypeAvatarData:
+            return version >= 4;
+        case PacketTypeBulkAvatarData:
+            return version >= 1;
+        default:
+            return false;
+    }
+}
+
 QByteArray byteArrayWithPopulatedHeader(PacketType type, const QUuid& connectionUUID) {
     QByteArray freshByteArray(MAX_PACKET_HEADER_BYTES, 0);
     freshByteArray.resize(populatePacketHeader(freshByteArray, type, connectionUUID));
@@ -154,14 +182,59 @@ QByteArray hashFromPacketHeader(const QByteArray& packet) {
     return packet.mid(numBytesForPacketHeader(packet) - NUM_BYTES_MD5_HASH, NUM_BYTES_MD5_HASH);
 }
 
+// writes the same bytes as QUuid::toRfc4122, without building a QByteArray for them
+static void packRfc4122UUID(const QUuid& uuid, char* destination) {
+    uchar* bytes = reinterpret_cast<uchar*>(destination);
+    bytes[0] = (uchar) (uuid.data1 >> 24);
+    bytes[1] = (uchar) (uuid.data1 >> 16);
+    bytes[2] = (uchar) (uuid.data1 >> 8);
+    bytes[3] = (uchar) uuid.data1;
+    bytes[4] = (uchar) (uuid.data2 >> 8);
+    bytes[5] = (uchar) uuid.data2;
+    bytes[6] = (uchar) (uuid.data3 >> 8);
+    bytes[7] = (uchar) uuid.data3;
+    memcpy(bytes + 8, uuid.data4, sizeof(uuid.data4));
+}
+
+static void hashPacketAndConnectionUUID(const char* packet, int packetLength, const QUuid& connectionUUID, char* hash) {
+    int numBytesPacketHeader = numBytesForPacketHeader(packet);
+    PacketVersion version = packet[numBytesArithmeticCodingFromBuffer(packet)];
+    
+    char rfcUUID[NUM_BYTES_RFC4122_UUID];
+    packRfc4122UUID(connectionUUID, rfcUUID);
+    
+    if (packetUsesSipHash(packetTypeForPacket(packet), version)) {
+        // the connection secret is the key, the MAC goes at the front of the hash bytes and the rest are left zeroed
+        memset(hash, 0, NUM_BYTES_MD5_HASH);
+        sipHash24(packet + numBytesPacketHeader, packetLength - numBytesPacketHeader, rfcUUID, hash);
+    } else {
+        MD5Hash md5Hash;
+        md5Hash.addData(packet + numBytesPacketHeader, packetLength - numBytesPacketHeader);
+        md5Hash.addData(rfcUUID, NUM_BYTES_RFC4122_UUID);
+        md5Hash.result(hash);
+    }
+}
+
 QByteArray hashForPacketAndConnectionUUID(const QByteArray& packet, const QUuid& connectionUUID) {
-    return QCryptographicHash::hash(packet.mid(numBytesForPacketHeader(packet)) + connectionUUID.toRfc4122(),
-                                    QCryptographicHash::Md5);
+    QByteArray hash(NUM_BYTES_MD5_HASH, 0);
+    hashPacketAndConnectionUUID(packet.constData(), packet.size(), connectionUUID, hash.data());
+    return hash;
 }
 
 void replaceHashInPacketGivenConnectionUUID(QByteArray& packet, const QUuid& connectionUUID) {
-    packet.replace(numBytesForPacketHeader(packet) - NUM_BYTES_MD5_HASH, NUM_BYTES_MD5_HASH,
-                   hashForPacketAndConnectionUUID(packet, connectionUUID));
+    writeHashInPacketGivenConnectionUUID(packet.data(), packet.size(), connectionUUID);
+}
+
+void writeHashInPacketGivenConnectionUUID(char* packet, int packetLength, const QUuid& connectionUUID) {
+    hashPacketAndConnectionUUID(packet, packetLength, connectionUUID,
+                                packet + numBytesForPacketHeader(packet) - NUM_BYTES_MD5_HASH);
+}
+
+bool packetHashMatchesConnectionUUID(const char* packet, int packetLength, const QUuid& connectionUUID) {
+    char expectedHash[NUM_BYTES_MD5_HASH];
+    hashPacketAndConnectionUUID(packet, packetLength, connectionUUID, expectedHash);
+    
+    return memcmp(packet + numBytesForPacketHeader(packet) - NUM_BYTES_MD5_HASH, expectedHash, NUM_BYTES_MD5_HASH) == 0;
 }
 
 PacketType packetTypeForPacket(const QByteArray& packet) {
@@ -87,6 +87,10 @@ const int MAX_PACKET_HEADER_BYTES = sizeof(PacketType) + NUM_BYTES_MD5_HASH + NU
 
 PacketVersion versionForPacketType(PacketType type);
 
+/// true if this version of a packet type is authenticated with a SipHash MAC keyed by the connection secret
+/// rather than the MD5 of its payload and the connection secret, both fill the NUM_BYTES_MD5_HASH bytes in the header
+bool packetUsesSipHash(PacketType type, PacketVersion version);
+
 const QUuid nullUUID = QUuid();
 
 QByteArray byteArrayWithPopulatedHeader(PacketType type, const QUuid& connectionUUID = nullUUID);
@@ -105,6 +109,12 @@ QByteArray hashFromPacketHeader(const QByteArray& packet);
 QByteArray hashForPacketAndConnectionUUID(const QByteArray& packet, const QUuid& connectionUUID);
 void replaceHashInPacketGivenConnectionUUID(QByteArray& packet, const QUuid& connectionUUID);
 
+/// hashes packetLength bytes of packet and writes the hash into the packet's header, without allocating or copying
+void writeHashInPacketGivenConnectionUUID(char* packet, int packetLength, const QUuid& connectionUUID);
+
+/// true if the hash in the packet's header is the one we'd write for it, without allocating or copying
+bool packetHashMatchesConnectionUUID(const char* packet, int packetLength, const QUuid& connectionUUID);
+
 PacketType packetTypeForPacket(const QByteArray& packet);
 PacketType packetTypeForPacket(const char* packet);
 
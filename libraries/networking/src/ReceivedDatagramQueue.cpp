@@ -0,0 +1,48 @@
+//
+//  ReceivedDatagramQueue.cpp
+//  libraries/networking/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "ReceivedDatagramQueue.h"
+
+static int nextPowerOfTwo(int value) {
+    int powerOfTwo = 1;
+    while (powerOfTwo < value) {
+        powerOfTwo <<= 1;
+    }
+    return powerOfTwo;
+}
+
+ReceivedDatagramQueue::ReceivedDatagramQueue(int capacity) :
+    _storage(nextPowerOfTwo(capacity + 1)),
+    _slots(_storage.data()),
+    _mask(_storage.size() - 1),
+    _head(0),
+    _tail(0)
+{
+
+}
+
+ReceivedDatagram* ReceivedDatagramQueue::front() {
+    // the acquire pairs with the release in push, so the datagram is complete before we look at it
+    int head = _head.load();
+    return (head == _tail.loadAcquire()) ? NULL : &_slots[head];
+}
+
+void ReceivedDatagramQueue::pop() {
+    // the release makes sure we're done with the slot before the producer can fill it again
+    _head.storeRelease((_head.load() + 1) & _mask);
+}
+
+int ReceivedDatagramQueue::numFreeSlots() const {
+    return (_head.loadAcquire() - _tail.load() - 1) & _mask;
+}
+
+void ReceivedDatagramQueue::push(int numDatagrams) {
+    _tail.storeRelease((_tail.load() + numDatagrams) & _mask);
+}
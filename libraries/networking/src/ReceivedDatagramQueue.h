@@ -0,0 +1,65 @@
+//
+//  ReceivedDatagramQueue.h
+//  libraries/networking/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  A lock-free queue that carries datagrams from a receive thread to the thread that handles them.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_ReceivedDatagramQueue_h
+#define hifi_ReceivedDatagramQueue_h
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QByteArray>
+#include <QtCore/QVector>
+
+#include "HifiSockAddr.h"
+
+class ReceivedDatagram {
+public:
+    QByteArray packet;
+    HifiSockAddr senderSockAddr;
+};
+
+/// A fixed size ring of datagrams with exactly one producer and one consumer thread. Neither side ever locks or
+/// allocates once the slots have been used, the producer reads straight into free slots and publishes them with push,
+/// and the consumer handles the datagram at front in place and hands its slot back with pop.
+class ReceivedDatagramQueue {
+public:
+    /// capacity is rounded up to a power of two, one slot is always kept empty to tell a full queue from an empty one
+    ReceivedDatagramQueue(int capacity);
+
+    int getCapacity() const { return _mask; }
+
+    // consumer side
+
+    /// the oldest datagram in the queue, or NULL if it is empty
+    ReceivedDatagram* front();
+    void pop();
+
+    // producer side
+
+    /// the number of slots the producer can fill before it has to wait for the consumer
+    int numFreeSlots() const;
+
+    /// the free slot offset slots past the last datagram pushed, offset must be less than numFreeSlots()
+    ReceivedDatagram& freeSlot(int offset) { return _slots[(_tail.load() + offset) & _mask]; }
+
+    /// makes the first numDatagrams free slots visible to the consumer
+    void push(int numDatagrams);
+
+private:
+    QVector<ReceivedDatagram> _storage;
+    ReceivedDatagram* _slots;
+    int _mask;
+
+    // the next slot to read is only written by the consumer, the next slot to fill only by the producer
+    QAtomicInt _head;
+    QAtomicInt _tail;
+};
+
+#endif // hifi_ReceivedDatagramQueue_h
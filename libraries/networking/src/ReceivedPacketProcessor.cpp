@@ -9,52 +9,185 @@
 //  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
 //
 
+#include <algorithm>
+
+#include <QThread>
+
 #include "NodeList.h"
 #include "ReceivedPacketProcessor.h"
 #include "SharedUtil.h"
 
+/// processes one shard past the first until the processor terminates
+class ReceivedPacketShardThread : public QThread {
+public:
+    ReceivedPacketShardThread(ReceivedPacketProcessor* processor, int shardIndex) :
+        _processor(processor),
+        _shardIndex(shardIndex) { }
+
+protected:
+    void run() {
+        ReceivedPacketProcessor::Shard& shard = *_processor->_shards[_shardIndex];
+        while (!_processor->_isStopping.loadAcquire()) {
+            _processor->waitForPackets(shard, ULONG_MAX);
+            _processor->processShard(shard, false);
+        }
+    }
+
+private:
+    ReceivedPacketProcessor* _processor;
+    int _shardIndex;
+};
+
+ReceivedPacketProcessor::Shard::Shard() :
+    queue(RECEIVED_PACKET_QUEUE_CAPACITY),
+    numQueued(0),
+    waitingMutex(),
+    hasPackets(),
+    isWaiting(0)
+{
+
+}
+
+ReceivedPacketProcessor::ReceivedPacketProcessor(int numShards) :
+    _shards(),
+    _shardThreads(),
+    _isStopping(0)
+{
+    for (int i = 0; i < std::max(numShards, 1); i++) {
+        _shards.append(new Shard());
+    }
+}
+
+ReceivedPacketProcessor::~ReceivedPacketProcessor() {
+    // the shard threads call processPacket, so they have to be gone before our subclass is
+    stopShardThreads();
+
+    foreach (Shard* shard, _shards) {
+        delete shard;
+    }
+}
+
 void ReceivedPacketProcessor::terminating() {
-    _hasPackets.wakeAll();
+    stopShardThreads();
 }
 
 void ReceivedPacketProcessor::queueReceivedPacket(const SharedNodePointer& sendingNode, const QByteArray& packet) {
     // Make sure our Node and NodeList knows we've heard from this node.
     sendingNode->setLastHeardMicrostamp(usecTimestampNow());
 
-    NetworkPacket networkPacket(sendingNode, packet);
-    lock();
-    _packets.push_back(networkPacket);
-    _nodePacketCounts[sendingNode->getUUID()]++;
-    unlock();
-    
-    // Make sure to  wake our actual processing thread because we  now have packets for it to process.
-    _hasPackets.wakeAll();
+    uint senderHash = qHash(sendingNode->getUUID());
+    Shard& shard = *_shards[senderHash % _shards.size()];
+
+    // count the packet before it can be processed, so its count never goes below zero
+    _senderPacketCounts[senderPacketCountIndex(sendingNode->getUUID())].fetchAndAddRelaxed(1);
+
+    while (!shard.queue.push(sendingNode, packet)) {
+        if (_isStopping.loadAcquire()) {
+            _senderPacketCounts[senderPacketCountIndex(sendingNode->getUUID())].fetchAndAddRelaxed(-1);
+            return;
+        }
+        // the processing thread is a whole queue behind, let it catch up
+        wakeShard(shard);
+        QThread::yieldCurrentThread();
+    }
+
+    // the ordered operations here and in waitForPackets make sure that either the processing thread sees the packet
+    // before it waits, or we see that it's waiting and wake it
+    shard.numQueued.fetchAndAddOrdered(1);
+    if (shard.isWaiting.fetchAndAddOrdered(0)) {
+        wakeShard(shard);
+    }
+}
+
+bool ReceivedPacketProcessor::isAlive(const QUuid& nodeUUID) const {
+    return !NodeList::getInstance()->nodeWithUUID(nodeUUID).isNull();
+}
+
+int ReceivedPacketProcessor::packetsToProcessCount() const {
+    int count = 0;
+    foreach (Shard* shard, _shards) {
+        count += shard->numQueued.loadAcquire();
+    }
+    return count;
 }
 
 bool ReceivedPacketProcessor::process() {
+    // without a thread of our own every shard is processed here, otherwise the other shards get their own threads
+    int numShardsHere = isThreaded() ? 1 : _shards.size();
+    if (numShardsHere < _shards.size() && _shardThreads.isEmpty()) {
+        startShardThreads();
+    }
 
-    if (_packets.size() == 0) {
-        _waitingOnPacketsMutex.lock();
-        _hasPackets.wait(&_waitingOnPacketsMutex, getMaxWait());
-        _waitingOnPacketsMutex.unlock();
+    int numQueuedHere = 0;
+    for (int i = 0; i < numShardsHere; i++) {
+        numQueuedHere += _shards[i]->numQueued.loadAcquire();
+    }
+    if (numQueuedHere == 0) {
+        // only packets for the first shard wake us, so a non-threaded processor should have just the one shard
+        waitForPackets(*_shards[0], getMaxWait());
     }
+
     preProcess();
-    while (_packets.size() > 0) {
-        lock(); // lock to make sure nothing changes on us
-        NetworkPacket& packet = _packets.front(); // get the oldest packet
-        NetworkPacket temporary = packet; // make a copy of the packet in case the vector is resized on us
-        _packets.erase(_packets.begin()); // remove the oldest packet
-        _nodePacketCounts[temporary.getNode()->getUUID()]--;
-        unlock(); // let others add to the packets
-        processPacket(temporary.getNode(), temporary.getByteArray()); // process our temporary copy
-        midProcess();
+    for (int i = 0; i < numShardsHere; i++) {
+        processShard(*_shards[i], i == 0);
     }
     postProcess();
     return isStillRunning();  // keep running till they terminate us
 }
 
-void ReceivedPacketProcessor::nodeKilled(SharedNodePointer node) {
-    lock();
-    _nodePacketCounts.remove(node->getUUID());
-    unlock();
+void ReceivedPacketProcessor::waitForPackets(Shard& shard, unsigned long maxWait) {
+    shard.waitingMutex.lock();
+    shard.isWaiting.fetchAndStoreOrdered(1);
+    if (shard.numQueued.fetchAndAddOrdered(0) == 0 && !_isStopping.loadAcquire()) {
+        shard.hasPackets.wait(&shard.waitingMutex, maxWait);
+    }
+    shard.isWaiting.fetchAndStoreOrdered(0);
+    shard.waitingMutex.unlock();
+}
+
+void ReceivedPacketProcessor::wakeShard(Shard& shard) {
+    shard.waitingMutex.lock();
+    shard.hasPackets.wakeAll();
+    shard.waitingMutex.unlock();
+}
+
+void ReceivedPacketProcessor::processShard(Shard& shard, bool isFirstShard) {
+    QueuedPacket batch[RECEIVED_PACKET_BATCH_SIZE];
+    int numPopped;
+    while ((numPopped = shard.queue.popBatch(batch, RECEIVED_PACKET_BATCH_SIZE)) > 0) {
+        for (int i = 0; i < numPopped; i++) {
+            QueuedPacket& queuedPacket = batch[i];
+            processPacket(queuedPacket.sendingNode, queuedPacket.packet);
+            _senderPacketCounts[senderPacketCountIndex(queuedPacket.sendingNode->getUUID())].fetchAndAddRelaxed(-1);
+
+            // let go of the packet and its node now rather than when the slot is next used
+            queuedPacket = QueuedPacket();
+
+            if (isFirstShard) {
+                midProcess();
+            }
+        }
+        shard.numQueued.fetchAndAddOrdered(-numPopped);
+    }
+}
+
+void ReceivedPacketProcessor::startShardThreads() {
+    for (int i = 1; i < _shards.size(); i++) {
+        ReceivedPacketShardThread* thread = new ReceivedPacketShardThread(this, i);
+        _shardThreads.append(thread);
+        thread->start();
+    }
+}
+
+void ReceivedPacketProcessor::stopShardThreads() {
+    // this also wakes the first shard, which is waited on by our own thread
+    _isStopping.storeRelease(1);
+    foreach (Shard* shard, _shards) {
+        wakeShard(*shard);
+    }
+    foreach (ReceivedPacketShardThread* thread, _shardThreads) {
+        thread->wait();
+        delete thread;
+    }
+    _shardThreads.clear();
 }
@@ -12,47 +12,58 @@
 #ifndef hifi_ReceivedPacketProcessor_h
 #define hifi_ReceivedPacketProcessor_h
 
+#include <QAtomicInt>
+#include <QUuid>
+#include <QVector>
 #include <QWaitCondition>
 
 #include "GenericThread.h"
-#include "NetworkPacket.h"
+#include "NodeList.h"
+#include "ReceivedPacketQueue.h"
 
-/// Generalized threaded processor for handling received inbound packets. 
+const int RECEIVED_PACKET_QUEUE_CAPACITY = 8192;
+const int RECEIVED_PACKET_BATCH_SIZE = 64;
+const int NUM_SENDER_PACKET_COUNTS = 256;
+
+class ReceivedPacketShardThread;
+
+/// Generalized threaded processor for handling received inbound packets. Packets are queued without locking and
+/// processed in batches. With more than one shard, each sending node's packets always go to the same shard and every
+/// shard past the first is processed on a thread of its own, so processPacket must be safe to call concurrently for
+/// packets from different senders.
 class ReceivedPacketProcessor : public GenericThread {
     Q_OBJECT
 public:
-    ReceivedPacketProcessor() { }
+    ReceivedPacketProcessor(int numShards = 1);
+    ~ReceivedPacketProcessor();
 
     /// Add packet from network receive thread to the processing queue.
-    /// \param sockaddr& senderAddress the address of the sender
-    /// \param packetData pointer to received data
-    /// \param ssize_t packetLength size of received data
-    /// \thread network receive thread
+    /// \param SharedNodePointer& sendingNode the node that sent this packet
+    /// \param QByteArray& packet the received packet
+    /// \thread any thread
     void queueReceivedPacket(const SharedNodePointer& sendingNode, const QByteArray& packet);
 
     /// Are there received packets waiting to be processed
-    bool hasPacketsToProcess() const { return _packets.size() > 0; }
+    bool hasPacketsToProcess() const { return packetsToProcessCount() > 0; }
 
     /// Is a specified node still alive?
-    bool isAlive(const QUuid& nodeUUID) const {
-        return _nodePacketCounts.contains(nodeUUID);
-    }
+    bool isAlive(const QUuid& nodeUUID) const;
 
     /// Are there received packets waiting to be processed from a specified node
     bool hasPacketsToProcessFrom(const SharedNodePointer& sendingNode) const {
         return hasPacketsToProcessFrom(sendingNode->getUUID());
     }
 
-    /// Are there received packets waiting to be processed from a specified node
+    /// Are there received packets waiting to be processed from a specified node. Senders share their counts with the
+    /// other senders that hash to the same count, so this can be true while another node's packets are waiting.
     bool hasPacketsToProcessFrom(const QUuid& nodeUUID) const {
-        return _nodePacketCounts[nodeUUID] > 0;
+        return _senderPacketCounts[senderPacketCountIndex(nodeUUID)].loadAcquire() > 0;
     }
 
     /// How many received packets waiting are to be processed
-    int packetsToProcessCount() const { return _packets.size(); }
+    int packetsToProcessCount() const;
 
-public slots:
-    void nodeKilled(SharedNodePointer node);
+    int getNumShards() const { return _shards.size(); }
 
 protected:
     /// Callback for processing of recieved packets. Implement this to process the incoming packets.
@@ -70,6 +81,7 @@ protected:
     virtual void preProcess() { }
 
     /// Override to do work inside the packet processing loop after a packet is processed. Default does nothing.
+    /// Only called for the packets of the first shard.
     virtual void midProcess() { }
 
     /// Override to do work after the packets processing loop.  Default does nothing.
@@ -77,13 +89,37 @@ protected:
 
     virtual void terminating();
 
-protected:
+private:
+    friend class ReceivedPacketShardThread;
+
+    class Shard {
+    public:
+        Shard();
+
+        ReceivedPacketQueue queue;
+        QAtomicInt numQueued;
+
+        QMutex waitingMutex;
+        QWaitCondition hasPackets;
+        QAtomicInt isWaiting;
+    };
+
+    static int senderPacketCountIndex(const QUuid& nodeUUID) {
+        return qHash(nodeUUID) & (NUM_SENDER_PACKET_COUNTS - 1);
+    }
+
+    void waitForPackets(Shard& shard, unsigned long maxWait);
+    void wakeShard(Shard& shard);
+    void processShard(Shard& shard, bool isFirstShard);
+
+    void startShardThreads();
+    void stopShardThreads();
 
-    QVector<NetworkPacket> _packets;
-    QHash<QUuid, int> _nodePacketCounts;
+    QVector<Shard*> _shards;
+    QVector<ReceivedPacketShardThread*> _shardThreads;
+    QAtomicInt _isStopping;
 
-    QWaitCondition _hasPackets;
-    QMutex _waitingOnPacketsMutex;
+    QAtomicInt _senderPacketCounts[NUM_SENDER_PACKET_COUNTS];
 };
 
 #endif // hifi_ReceivedPacketProcessor_h
@@ -0,0 +1,93 @@
+//
+//  ReceivedPacketQueue.cpp
+//  libraries/networking/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "ReceivedPacketQueue.h"
+
+// the positions keep counting up and wrap around, so all the arithmetic on them is done unsigned
+static int positionDifference(int a, int b) {
+    return (int)((unsigned int)a - (unsigned int)b);
+}
+
+static int advancePosition(int position, int count) {
+    return (int)((unsigned int)position + (unsigned int)count);
+}
+
+ReceivedPacketQueue::ReceivedPacketQueue(int capacity) :
+    _slots(NULL),
+    _mask(0),
+    _tail(0),
+    _head(0)
+{
+    int roundedCapacity = 1;
+    while (roundedCapacity < capacity) {
+        roundedCapacity <<= 1;
+    }
+
+    _slots = new Slot[roundedCapacity];
+    _mask = roundedCapacity - 1;
+
+    // a slot is free to fill at position p when its sequence is p, and ready to read when it is p + 1
+    for (int i = 0; i < roundedCapacity; i++) {
+        _slots[i].sequence.store(i);
+    }
+}
+
+ReceivedPacketQueue::~ReceivedPacketQueue() {
+    delete[] _slots;
+}
+
+bool ReceivedPacketQueue::push(const SharedNodePointer& sendingNode, const QByteArray& packet) {
+    Slot* slot;
+    int position = _tail.load();
+    while (true) {
+        slot = &_slots[position & _mask];
+        int difference = positionDifference(slot->sequence.loadAcquire(), position);
+        if (difference == 0) {
+            // the slot is free, claim it unless another producer got there first
+            if (_tail.testAndSetRelaxed(position, advancePosition(position, 1))) {
+                break;
+            }
+            position = _tail.load();
+        } else if (difference < 0) {
+            // the consumer hasn't read the packet that was here a lap ago
+            return false;
+        } else {
+            // another producer claimed this one, try again from the new tail
+            position = _tail.load();
+        }
+    }
+
+    slot->contents.sendingNode = sendingNode;
+    slot->contents.packet = packet;
+
+    // publish the packet, the release pairs with the acquire in popBatch
+    slot->sequence.storeRelease(advancePosition(position, 1));
+    return true;
+}
+
+int ReceivedPacketQueue::popBatch(QueuedPacket* batch, int maxPackets) {
+    int numPopped = 0;
+    while (numPopped < maxPackets) {
+        Slot& slot = _slots[_head & _mask];
+        if (positionDifference(slot.sequence.loadAcquire(), _head) != 1) {
+            // empty, or the producer that claimed it hasn't finished writing it yet
+            break;
+        }
+
+        QueuedPacket& queuedPacket = batch[numPopped++];
+        qSwap(queuedPacket.sendingNode, slot.contents.sendingNode);
+        qSwap(queuedPacket.packet, slot.contents.packet);
+
+        // hand the slot back for the position one lap ahead
+        slot.sequence.storeRelease(advancePosition(_head, _mask + 1));
+        _head = advancePosition(_head, 1);
+    }
+    return numPopped;
+}
@@ -0,0 +1,66 @@
+//
+//  ReceivedPacketQueue.h
+//  libraries/networking/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  A lock-free queue that carries packets from the threads that receive them to the thread that processes them.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_ReceivedPacketQueue_h
+#define hifi_ReceivedPacketQueue_h
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QByteArray>
+
+#include "Node.h"
+
+class QueuedPacket {
+public:
+    SharedNodePointer sendingNode;
+    QByteArray packet;
+};
+
+/// A fixed size ring of packets with any number of producer threads and exactly one consumer thread. Each slot carries
+/// a sequence number that says whether it is waiting to be filled or waiting to be read, so producers only contend on
+/// claiming the tail and never lock. Packets are swapped in and out of the slots, nothing is copied.
+class ReceivedPacketQueue {
+public:
+    /// capacity is rounded up to a power of two
+    ReceivedPacketQueue(int capacity);
+    ~ReceivedPacketQueue();
+
+    int getCapacity() const { return _mask + 1; }
+
+    // producer side, any thread
+
+    /// queues the packet, returns false and leaves the queue alone if it is full
+    bool push(const SharedNodePointer& sendingNode, const QByteArray& packet);
+
+    // consumer side
+
+    /// moves up to maxPackets of the oldest packets into batch, which should hold empty packets, and returns how many
+    int popBatch(QueuedPacket* batch, int maxPackets);
+
+private:
+    class Slot {
+    public:
+        QAtomicInt sequence;
+        QueuedPacket contents;
+    };
+
+    // not copyable
+    ReceivedPacketQueue(const ReceivedPacketQueue&);
+    ReceivedPacketQueue& operator=(const ReceivedPacketQueue&);
+
+    Slot* _slots;
+    int _mask;
+
+    QAtomicInt _tail;
+    int _head; // only touched by the consumer
+};
+
+#endif // hifi_ReceivedPacketQueue_h
@@ -0,0 +1,82 @@
+//
+//  SipHash.cpp
+//  libraries/networking/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include "SipHash.h"
+
+static inline quint64 rotateLeft(quint64 value, int shift) {
+    return (value << shift) | (value >> (64 - shift));
+}
+
+static inline quint64 readLittleEndian64(const uchar* bytes) {
+    quint64 value = 0;
+    for (int i = 7; i >= 0; i--) {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+// one SipRound over the four words of state
+#define SIP_ROUND(v0, v1, v2, v3) \
+    v0 += v1; v1 = rotateLeft(v1, 13); v1 ^= v0; v0 = rotateLeft(v0, 32); \
+    v2 += v3; v3 = rotateLeft(v3, 16); v3 ^= v2; \
+    v0 += v3; v3 = rotateLeft(v3, 21); v3 ^= v0; \
+    v2 += v1; v1 = rotateLeft(v1, 17); v1 ^= v2; v2 = rotateLeft(v2, 32);
+
+quint64 sipHash24(const char* data, int length, const char* key) {
+    const uchar* keyBytes = reinterpret_cast<const uchar*>(key);
+    quint64 k0 = readLittleEndian64(keyBytes);
+    quint64 k1 = readLittleEndian64(keyBytes + 8);
+
+    quint64 v0 = k0 ^ Q_UINT64_C(0x736f6d6570736575);
+    quint64 v1 = k1 ^ Q_UINT64_C(0x646f72616e646f6d);
+    quint64 v2 = k0 ^ Q_UINT64_C(0x6c7967656e657261);
+    quint64 v3 = k1 ^ Q_UINT64_C(0x7465646279746573);
+
+    const uchar* input = reinterpret_cast<const uchar*>(data);
+    const uchar* fullWordsEnd = input + (length - (length % 8));
+
+    // two compression rounds per eight byte word
+    for (; input != fullWordsEnd; input += 8) {
+        quint64 word = readLittleEndian64(input);
+        v3 ^= word;
+        SIP_ROUND(v0, v1, v2, v3);
+        SIP_ROUND(v0, v1, v2, v3);
+        v0 ^= word;
+    }
+
+    // the last word holds whatever bytes are left and the length of the input in its top byte
+    quint64 lastWord = ((quint64) length) << 56;
+    for (int i = (length % 8) - 1; i >= 0; i--) {
+        lastWord |= ((quint64) input[i]) << (i * 8);
+    }
+
+    v3 ^= lastWord;
+    SIP_ROUND(v0, v1, v2, v3);
+    SIP_ROUND(v0, v1, v2, v3);
+    v0 ^= lastWord;
+
+    // and four finalization rounds
+    v2 ^= 0xff;
+    SIP_ROUND(v0, v1, v2, v3);
+    SIP_ROUND(v0, v1, v2, v3);
+    SIP_ROUND(v0, v1, v2, v3);
+    SIP_ROUND(v0, v1, v2, v3);
+
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+void sipHash24(const char* data, int length, const char* key, char* hash) {
+    quint64 value = sipHash24(data, length, key);
+
+    uchar* hashBytes = reinterpret_cast<uchar*>(hash);
+    for (int i = 0; i < NUM_BYTES_SIP_HASH; i++) {
+        hashBytes[i] = (uchar) (value >> (i * 8));
+    }
+}
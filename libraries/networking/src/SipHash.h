@@ -0,0 +1,27 @@
+//
+//  SipHash.h
+//  libraries/networking/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  SipHash-2-4, a fast keyed hash used to authenticate packets with the connection secret.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_SipHash_h
+#define hifi_SipHash_h
+
+#include <QtCore/QtGlobal>
+
+const int NUM_BYTES_SIP_HASH_KEY = 16;
+const int NUM_BYTES_SIP_HASH = 8;
+
+/// returns the SipHash-2-4 of length bytes of data under a NUM_BYTES_SIP_HASH_KEY byte key
+quint64 sipHash24(const char* data, int length, const char* key);
+
+/// writes the SipHash-2-4 of data as NUM_BYTES_SIP_HASH little endian bytes, the byte order of the reference vectors
+void sipHash24(const char* data, int length, const char* key, char* hash);
+
+#endif // hifi_SipHash_h
@@ -18,7 +18,8 @@
 
 ThreadedAssignment::ThreadedAssignment(const QByteArray& packet) :
     Assignment(packet),
-    _isFinished(false)
+    _isFinished(false),
+    _datagramReceiver(this)
 {
     
 }
@@ -27,6 +28,9 @@ void ThreadedAssignment::setFinished(bool isFinished) {
     _isFinished = isFinished;
 
     if (_isFinished) {
+        // stop the receive threads while the node socket is still ours to replace
+        _datagramReceiver.stop();
+        
         aboutToFinish();
         emit finished();
         
@@ -63,10 +67,12 @@ void ThreadedAssignment::addPacketStatsAndSendStatsPacket(QJsonObject &statsObje
     
     float packetsPerSecond, bytesPerSecond;
     nodeList->getPacketStats(packetsPerSecond, bytesPerSecond);
+    float allocationsPerPacket = nodeList->getAllocationsPerPacket();
     nodeList->resetPacketStats();
     
     statsObject["packets_per_second"] = packetsPerSecond;
     statsObject["bytes_per_second"] = bytesPerSecond;
+    statsObject["allocations_per_packet"] = allocationsPerPacket;
     
     nodeList->sendStatsToDomainServer(statsObject);
 }
@@ -96,3 +102,30 @@ bool ThreadedAssignment::readAvailableDatagram(QByteArray& destinationByteArray,
         return false;
     }
 }
+
+bool ThreadedAssignment::startReceiveThreads(int numThreads) {
+    if (numThreads < 1 || !DatagramReceiver::isAvailable()) {
+        return false;
+    }
+    
+    // the receive threads read the node socket from here on, so stop reading it on the event loop
+    QUdpSocket* nodeSocket = &NodeList::getInstance()->getNodeSocket();
+    disconnect(nodeSocket, &QUdpSocket::readyRead, this, &ThreadedAssignment::readPendingDatagrams);
+    
+    if (!_datagramReceiver.start(numThreads)) {
+        connect(nodeSocket, &QUdpSocket::readyRead, this, &ThreadedAssignment::readPendingDatagrams);
+        return false;
+    }
+    
+    connect(&_datagramReceiver, &DatagramReceiver::datagramsQueued, this, &ThreadedAssignment::processReceivedDatagrams,
+            Qt::QueuedConnection);
+    return true;
+}
+
+void ThreadedAssignment::processDatagram(const QByteArray& packet, const HifiSockAddr& senderSockAddr) {
+    NodeList::getInstance()->processNodeData(senderSockAddr, packet);
+}
+
+int ThreadedAssignment::processReceivedDatagrams() {
+    return _datagramReceiver.processQueuedDatagrams(this);
+}
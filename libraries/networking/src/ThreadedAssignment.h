@@ -15,6 +15,7 @@
 #include <QtCore/QSharedPointer>
 
 #include "Assignment.h"
+#include "DatagramReceiver.h"
 
 class ThreadedAssignment : public Assignment {
     Q_OBJECT
@@ -23,6 +24,9 @@ public:
     void setFinished(bool isFinished);
     virtual void aboutToFinish() { };
     void addPacketStatsAndSendStatsPacket(QJsonObject& statsObject);
+    
+    /// handles one datagram that has passed packetVersionAndHashMatch on a receive thread, on this assignment's thread
+    virtual void processDatagram(const QByteArray& packet, const HifiSockAddr& senderSockAddr);
 
 public slots:
     /// threaded run of assignment
@@ -33,7 +37,16 @@ public slots:
 protected:
     bool readAvailableDatagram(QByteArray& destinationByteArray, HifiSockAddr& senderSockAddr);
     void commonInit(const QString& targetName, NodeType_t nodeType, bool shouldSendStats = true);
+    
+    /// reads datagrams on numThreads receive threads from now on instead of readPendingDatagrams, see DatagramReceiver
+    /// returns false and leaves readPendingDatagrams in charge if the receive threads can't be used here
+    bool startReceiveThreads(int numThreads);
+    
     bool _isFinished;
+    DatagramReceiver _datagramReceiver;
+protected slots:
+    /// hands everything the receive threads have queued to processDatagram, returns the number of datagrams handled
+    int processReceivedDatagrams();
 private slots:
     void checkInWithDomainServerOrExit();
 signals:
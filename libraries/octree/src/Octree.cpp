@@ -39,6 +39,27 @@ float boundaryDistanceForRenderLevel(unsigned int renderLevel, float voxelSizeSc
     return voxelSizeScale / powf(2, renderLevel);
 }
 
+// Moving the camera from the last view by some distance moves every point in the element by at most that distance.
+// If no level's boundary falls between the nearest the element is now and the furthest it could have been, nothing
+// below the element crossed into its level of detail.
+static bool detailMayHaveIncreased(const OctreeElement* element, const EncodeBitstreamParams& params) {
+    float moved = glm::distance(params.viewFrustum->getPosition(), params.lastViewFrustum->getPosition());
+    float halfDiagonal = element->getScale() * (float)TREE_SCALE * sqrtf(3.0f) * 0.5f;
+    float distance = element->distanceToCamera(*params.viewFrustum);
+    float nearest = std::max(distance - halfDiagonal, 0.0f);
+    float furthestBefore = distance + halfDiagonal + moved;
+
+    float boundary = boundaryDistanceForRenderLevel(element->getLevel() + params.boundaryLevelAdjust,
+                                                    params.octreeElementSizeScale);
+    while (boundary >= nearest) {
+        if (boundary <= furthestBefore) {
+            return true;
+        }
+        boundary *= 0.5f; // each level's boundary is half of the one above it
+    }
+    return false;
+}
+
 Octree::Octree(bool shouldReaverage) :
     _rootElement(NULL),
     _isDirty(true),
@@ -1079,6 +1100,10 @@ int Octree::encodeTreeBitstreamRecursion(OctreeElement* element,
                 if (distance >= boundaryDistance) {
                     // This would have been invisible... but now should be visible (we wouldn't be here otherwise)...
                     wasInView = false;
+                } else if (!element->isLeaf() && detailMayHaveIncreased(element, params)) {
+                    // Some of what's below may have been too small to send from there but not from here, so look
+                    // through the children, each of them is still skipped if it was sent from the last view
+                    wasInView = false;
                 }
             }
         }
@@ -1298,6 +1323,12 @@ int Octree::encodeTreeBitstreamRecursion(OctreeElement* element,
                         } else {
                             childWasInView = location == ViewFrustum::INSIDE;
                         }
+
+                        // A child that was in view but wouldn't have rendered at the last view's distance wasn't sent
+                        if (childWasInView && !childElement->calculateShouldRender(params.lastViewFrustum,
+                                                    params.octreeElementSizeScale, params.boundaryLevelAdjust)) {
+                            childWasInView = false;
+                        }
                     }
 
                     // If our child wasn't in view (or we're ignoring wasInView) then we add it to our sending items.
@@ -1634,11 +1665,13 @@ bool Octree::readFromSVOFile(const char* fileName) {
     return fileOk;
 }
 
-void Octree::writeToSVOFile(const char* fileName, OctreeElement* element) {
+bool Octree::writeToSVOFile(const char* fileName, OctreeElement* element, bool fromSnapshot) {
     std::ofstream file(fileName, std::ios::out|std::ios::binary);
 
     if(file.is_open()) {
-        qDebug("Saving to file %s...", fileName);
+        if (!fromSnapshot) {
+            qDebug("Saving to file %s...", fileName);
+        }
 
         // before reading the file, check to see if this version of the Octree supports file versions
         if (getWantSVOfileVersions()) {
@@ -1649,7 +1682,9 @@ void Octree::writeToSVOFile(const char* fileName, OctreeElement* element) {
             file.write(&expectedVersion, sizeof(expectedVersion));
         }
 
-        OctreeElementBag nodeBag;
+        // nothing is deleted from a snapshot, and the delete hooks are behind a lock another thread may have held
+        // when the snapshot was taken
+        OctreeElementBag nodeBag(!fromSnapshot);
         // If we were given a specific element, start from there, otherwise start from root
         if (element) {
             nodeBag.insert(element);
@@ -1663,10 +1698,14 @@ void Octree::writeToSVOFile(const char* fileName, OctreeElement* element) {
 
         while (!nodeBag.isEmpty()) {
             OctreeElement* subTree = nodeBag.extract();
-            lockForRead(); // do tree locking down here so that we have shorter slices and less thread contention
+            if (!fromSnapshot) {
+                lockForRead(); // do tree locking down here so that we have shorter slices and less thread contention
+            }
             EncodeBitstreamParams params(INT_MAX, IGNORE_VIEW_FRUSTUM, WANT_COLOR, NO_EXISTS_BITS);
             bytesWritten = encodeTreeBitstream(subTree, &packetData, nodeBag, params);
-            unlock();
+            if (!fromSnapshot) {
+                unlock();
+            }
 
             // if the subTree couldn't fit, and so we should reset the packet and reinsert the element in our bag and try again
             if (bytesWritten == 0 && (params.stopReason == EncodeBitstreamParams::DIDNT_FIT)) {
@@ -1686,6 +1725,7 @@ void Octree::writeToSVOFile(const char* fileName, OctreeElement* element) {
         }
     }
     file.close();
+    return !file.fail();
 }
 
 unsigned long Octree::getOctreeElementsCount() {
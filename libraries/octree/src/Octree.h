@@ -213,6 +213,10 @@ public:
     virtual bool recurseChildrenWithData() const { return true; }
     virtual bool rootElementHasData() const { return false; }
 
+    /// whether every edit marks the changed element's ancestors as changed too, so that an element's last changed time
+    /// covers its whole subtree
+    virtual bool changesMarkAncestors() const { return false; }
+
 
     virtual void update() { }; // nothing to do by default
 
@@ -287,7 +291,9 @@ public:
     void loadOctreeFile(const char* fileName, bool wantColorRandomizer);
 
     // these will read/write files that match the wireformat, excluding the 'V' leading
-    void writeToSVOFile(const char* filename, OctreeElement* element = NULL);
+    /// fromSnapshot is for a forked copy of the process holding a consistent snapshot of the tree, nothing else can
+    /// touch it there, so the tree isn't locked, nothing is logged and no element deletion hooks are added
+    bool writeToSVOFile(const char* filename, OctreeElement* element = NULL, bool fromSnapshot = false);
     bool readFromSVOFile(const char* filename);
     
 
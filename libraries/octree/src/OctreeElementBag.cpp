@@ -9,14 +9,21 @@
 //  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
 //
 
+#include <algorithm>
+
 #include "OctreeElementBag.h"
 #include <OctalCode.h>
 
-OctreeElementBag::OctreeElementBag() : 
-    _bagElements()
+OctreeElementBag::OctreeElementBag(bool wantDeleteNotifications) : 
+    _heap(),
+    _heapIndices(),
+    _nextInsertionNumber(0),
+    _priorityView(NULL),
+    _hooked(wantDeleteNotifications)
 {
-    OctreeElement::addDeleteHook(this);
-    _hooked = true;
+    if (_hooked) {
+        OctreeElement::addDeleteHook(this);
+    }
 };
 
 OctreeElementBag::~OctreeElementBag() {
@@ -37,29 +44,132 @@ void OctreeElementBag::elementDeleted(OctreeElement* element) {
 
 
 void OctreeElementBag::deleteAll() {
-    _bagElements.clear();
+    _heap.clear();
+    _heapIndices.clear();
 }
 
 
 void OctreeElementBag::insert(OctreeElement* element) {
-    _bagElements.insert(element);
+    if (_heapIndices.contains(element)) {
+        return;
+    }
+    Entry entry = { element, calculatePriority(element), _nextInsertionNumber++ };
+    _heap.append(entry);
+    _heapIndices.insert(element, _heap.size() - 1);
+    siftUp(_heap.size() - 1);
 }
 
 OctreeElement* OctreeElementBag::extract() {
     OctreeElement* result = NULL;
 
-    if (_bagElements.size() > 0) {
-        QSet<OctreeElement*>::iterator front = _bagElements.begin();
-        result = *front;
-        _bagElements.erase(front);
+    if (_heap.size() > 0) {
+        result = _heap[0].element;
+        removeAt(0);
     }
     return result;
 }
 
+void OctreeElementBag::reprioritize() {
+    for (int i = 0; i < _heap.size(); i++) {
+        _heap[i].priority = calculatePriority(_heap[i].element);
+    }
+
+    // rebuild the heap from the bottom up, which is linear rather than re-inserting everything
+    for (int i = _heap.size() / 2 - 1; i >= 0; i--) {
+        siftDown(i);
+    }
+}
+
 bool OctreeElementBag::contains(OctreeElement* element) {
-    return _bagElements.contains(element);
+    return _heapIndices.contains(element);
+}
+
+QVector<OctreeElement*> OctreeElementBag::getElements() const {
+    QVector<OctreeElement*> elements;
+    elements.reserve(_heap.size());
+    foreach (const Entry& entry, _heap) {
+        elements.append(entry.element);
+    }
+    return elements;
 }
 
 void OctreeElementBag::remove(OctreeElement* element) {
-    _bagElements.remove(element);
+    QHash<OctreeElement*, int>::const_iterator index = _heapIndices.constFind(element);
+    if (index != _heapIndices.constEnd()) {
+        removeAt(index.value());
+    }
+}
+
+float OctreeElementBag::calculatePriority(OctreeElement* element) const {
+    if (!_priorityView) {
+        return 0.0f;
+    }
+    // roughly how big the element looks, anything we're inside of is as big as it gets
+    float size = element->getScale() * (float)TREE_SCALE;
+    float distance = element->distanceToCamera(*_priorityView);
+    return size / std::max(distance, size * 0.5f);
+}
+
+bool OctreeElementBag::isHigherPriority(const Entry& first, const Entry& second) const {
+    if (first.priority != second.priority) {
+        return first.priority > second.priority;
+    }
+    return first.insertionNumber < second.insertionNumber;
+}
+
+void OctreeElementBag::moveEntry(const Entry& entry, int index) {
+    _heap[index] = entry;
+    _heapIndices[entry.element] = index;
+}
+
+void OctreeElementBag::siftUp(int index) {
+    Entry entry = _heap[index];
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (!isHigherPriority(entry, _heap[parent])) {
+            break;
+        }
+        moveEntry(_heap[parent], index);
+        index = parent;
+    }
+    moveEntry(entry, index);
+}
+
+void OctreeElementBag::siftDown(int index) {
+    Entry entry = _heap[index];
+    int size = _heap.size();
+    while (true) {
+        int child = 2 * index + 1;
+        if (child >= size) {
+            break;
+        }
+        if (child + 1 < size && isHigherPriority(_heap[child + 1], _heap[child])) {
+            child++;
+        }
+        if (!isHigherPriority(_heap[child], entry)) {
+            break;
+        }
+        moveEntry(_heap[child], index);
+        index = child;
+    }
+    moveEntry(entry, index);
+}
+
+void OctreeElementBag::removeAt(int index) {
+    _heapIndices.remove(_heap[index].element);
+
+    int last = _heap.size() - 1;
+    if (index != last) {
+        // fill the hole with the last entry and let it find its place from there
+        _heap[index] = _heap[last];
+        _heap.resize(last);
+        OctreeElement* moved = _heap[index].element;
+        _heapIndices[moved] = index;
+        siftUp(index);
+        if (_heap[index].element == moved) {
+            siftDown(index);
+        }
+    } else {
+        _heap.resize(last);
+    }
 }
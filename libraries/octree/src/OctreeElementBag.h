@@ -17,21 +17,36 @@
 #ifndef hifi_OctreeElementBag_h
 #define hifi_OctreeElementBag_h
 
+#include <QHash>
+#include <QVector>
+
 #include "OctreeElement.h"
 
+/// With a priority view set, extract() returns the element that looks biggest from that view first, so the closest
+/// and largest content goes out before distant detail. Without one, elements come out in the order they went in.
 class OctreeElementBag : public OctreeElementDeleteHook {
 
 public:
-    OctreeElementBag();
+    /// without delete notifications the caller has to make sure no element in the bag is deleted while it's in there
+    OctreeElementBag(bool wantDeleteNotifications = true);
     ~OctreeElementBag();
     
+    /// the view that priorities are calculated from when elements are inserted, NULL for first in first out, the
+    /// priorities of elements already in the bag aren't updated when the view changes until reprioritize() is called
+    void setPriorityView(const ViewFrustum* priorityView) { _priorityView = priorityView; }
+
+    /// calculates the priority of every element in the bag again from the priority view, for after the view has moved
+    void reprioritize();
+
     void insert(OctreeElement* element); // put a element into the bag
-    OctreeElement* extract(); // pull a element out of the bag (could come in any order)
+    OctreeElement* extract(); // pull the highest priority element out of the bag
     bool contains(OctreeElement* element); // is this element in the bag?
     void remove(OctreeElement* element); // remove a specific element from the bag
     
-    bool isEmpty() const { return _bagElements.isEmpty(); }
-    int count() const { return _bagElements.size(); }
+    bool isEmpty() const { return _heap.isEmpty(); }
+    int count() const { return _heap.size(); }
+
+    QVector<OctreeElement*> getElements() const; // the elements in the bag, in no particular order
 
     void deleteAll();
     virtual void elementDeleted(OctreeElement* element);
@@ -39,7 +54,27 @@ public:
     void unhookNotifications();
 
 private:
-    QSet<OctreeElement*> _bagElements;
+    class Entry {
+    public:
+        OctreeElement* element;
+        float priority;
+        quint64 insertionNumber;
+    };
+
+    float calculatePriority(OctreeElement* element) const;
+    bool isHigherPriority(const Entry& first, const Entry& second) const;
+
+    void moveEntry(const Entry& entry, int index);
+    void siftUp(int index);
+    void siftDown(int index);
+    void removeAt(int index);
+
+    // a binary heap with the highest priority element at the front, and where each element is in it
+    QVector<Entry> _heap;
+    QHash<OctreeElement*, int> _heapIndices;
+    quint64 _nextInsertionNumber;
+
+    const ViewFrustum* _priorityView;
     bool _hooked;
 };
 
@@ -9,7 +9,18 @@
 //  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
 //
 
+#include <cstdio>
+#include <cstring>
+
 #include <QDebug>
+
+#ifdef Q_OS_UNIX
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
 #include <PerfStat.h>
 #include <SharedUtil.h>
 
@@ -20,10 +31,17 @@ OctreePersistThread::OctreePersistThread(Octree* tree, const QString& filename,
     _filename(filename),
     _persistInterval(persistInterval),
     _initialLoadComplete(false),
-    _loadTimeUSecs(0) 
+    _loadTimeUSecs(0),
+    _lastCheck(0),
+    _saveProcessID(0)
 {
 }
 
+OctreePersistThread::~OctreePersistThread() {
+    // the thread is stopped by now, so finish any save it started rather than leave a half written file behind
+    finishSave(true);
+}
+
 bool OctreePersistThread::process() {
 
     if (!_initialLoadComplete) {
@@ -76,16 +94,80 @@ bool OctreePersistThread::process() {
         quint64 sinceLastSave = now - _lastCheck;
         quint64 intervalToCheck = _persistInterval * MSECS_TO_USECS;
 
-        if (sinceLastSave > intervalToCheck) {
+        // a save that's still running is left to finish before the next one is started
+        if (finishSave(false) && sinceLastSave > intervalToCheck) {
             // check the dirty bit and persist here...
             _lastCheck = usecTimestampNow();
             if (_tree->isDirty()) {
-                qDebug() << "saving Octrees to file " << _filename << "...";
-                _tree->writeToSVOFile(_filename.toLocal8Bit().constData());
-                _tree->clearDirtyBit(); // tree is clean after saving
-                qDebug("DONE saving Octrees to file...");
+                persist();
             }
         }
     }
     return isStillRunning();  // keep running till they terminate us
 }
+
+void OctreePersistThread::persist() {
+#ifdef Q_OS_UNIX
+    QByteArray savingFilename = (_filename + ".saving").toLocal8Bit();
+
+    // the forked process gets a copy on write snapshot of the tree as it is while we hold the read lock, so editors
+    // and encoders only wait for the fork, not for the file to be written
+    _tree->lockForRead();
+    _tree->clearDirtyBit(); // anything edited from here on is dirty again
+    pid_t saveProcessID = fork();
+    _tree->unlock();
+
+    if (saveProcessID == 0) {
+        // only this thread was forked, so nothing else can touch the snapshot, and whatever locks the other threads
+        // held stay held, which is why this doesn't log or lock anything
+        bool saved = _tree->writeToSVOFile(savingFilename.constData(), NULL, true);
+        _exit(saved ? 0 : 1);
+    }
+
+    if (saveProcessID > 0) {
+        qDebug() << "saving Octrees to file " << _filename << "in process" << saveProcessID << "...";
+        _saveProcessID = saveProcessID;
+        return;
+    }
+
+    qDebug() << "Could not fork to save Octrees, saving in process:" << strerror(errno);
+#endif
+
+    qDebug() << "saving Octrees to file " << _filename << "...";
+    _tree->writeToSVOFile(_filename.toLocal8Bit().constData());
+    _tree->clearDirtyBit(); // tree is clean after saving
+    qDebug("DONE saving Octrees to file...");
+}
+
+bool OctreePersistThread::finishSave(bool waitForSave) {
+#ifdef Q_OS_UNIX
+    if (_saveProcessID == 0) {
+        return true;
+    }
+
+    int status = 0;
+    pid_t result;
+    do {
+        result = waitpid(_saveProcessID, &status, waitForSave ? 0 : WNOHANG);
+    } while (result < 0 && errno == EINTR);
+
+    if (result == 0) {
+        return false; // still saving
+    }
+    _saveProcessID = 0;
+
+    // the persist file is only replaced once the new one is complete, so a failed save leaves the last good one
+    QByteArray savingFilename = (_filename + ".saving").toLocal8Bit();
+    if (result > 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0
+        && ::rename(savingFilename.constData(), _filename.toLocal8Bit().constData()) == 0) {
+        qDebug("DONE saving Octrees to file...");
+    } else {
+        qDebug() << "FAILED saving Octrees to file " << _filename << ", will try again";
+        ::remove(savingFilename.constData());
+        _tree->setDirtyBit();
+    }
+#else
+    Q_UNUSED(waitForSave);
+#endif
+    return true;
+}
@@ -25,6 +25,7 @@ public:
     static const int DEFAULT_PERSIST_INTERVAL = 1000 * 30; // every 30 seconds
 
     OctreePersistThread(Octree* tree, const QString& filename, int persistInterval = DEFAULT_PERSIST_INTERVAL);
+    ~OctreePersistThread();
 
     bool isInitialLoadComplete() const { return _initialLoadComplete; }
     quint64 getLoadElapsedTime() const { return _loadTimeUSecs; }
@@ -36,6 +37,13 @@ protected:
     /// Implements generic processing behavior for this thread.
     virtual bool process();
 private:
+    /// saves the tree, on unix from a forked copy of the process so the tree is only locked long enough to fork
+    void persist();
+
+    /// checks on a save running in a forked process, once it's done its file replaces the persist file, returns true
+    /// if there is no save running anymore
+    bool finishSave(bool waitForSave);
+
     Octree* _tree;
     QString _filename;
     int _persistInterval;
@@ -43,6 +51,8 @@ private:
 
     quint64 _loadTimeUSecs;
     quint64 _lastCheck;
+
+    qint64 _saveProcessID; // 0 when no save is running
 };
 
 #endif // hifi_OctreePersistThread_h
@@ -13,6 +13,7 @@
 
 #include "OctreeConstants.h"
 #include "OctreeQuery.h"
+#include "ViewFrustum.h"
 
 OctreeQuery::OctreeQuery() :
     NodeData(),
@@ -44,16 +45,10 @@ int OctreeQuery::getBroadcastData(unsigned char* destinationBuffer) {
     // that can pack any type given the number of bytes
     // and return the number of bytes to push the pointer
     
-    // camera details
-    memcpy(destinationBuffer, &_cameraPosition, sizeof(_cameraPosition));
-    destinationBuffer += sizeof(_cameraPosition);
-    destinationBuffer += packOrientationQuatToBytes(destinationBuffer, _cameraOrientation);
-    destinationBuffer += packFloatAngleToTwoByte(destinationBuffer, _cameraFov);
-    destinationBuffer += packFloatRatioToTwoByte(destinationBuffer, _cameraAspectRatio);
-    destinationBuffer += packClipValueToTwoByte(destinationBuffer, _cameraNearClip);
-    destinationBuffer += packClipValueToTwoByte(destinationBuffer, _cameraFarClip);
-    memcpy(destinationBuffer, &_cameraEyeOffsetPosition, sizeof(_cameraEyeOffsetPosition));
-    destinationBuffer += sizeof(_cameraEyeOffsetPosition);
+    // camera details, in the layout the avatar mixer reads them in too
+    destinationBuffer += ViewFrustum::packCameraDetails(destinationBuffer, _cameraPosition, _cameraOrientation,
+                                                        _cameraFov, _cameraAspectRatio, _cameraNearClip,
+                                                        _cameraFarClip, _cameraEyeOffsetPosition);
 
     // bitMask of less than byte wide items
     unsigned char bitItems = 0;
@@ -90,15 +85,9 @@ int OctreeQuery::parseData(const QByteArray& packet) {
     const unsigned char* sourceBuffer = startPosition + numBytesPacketHeader;
     
     // camera details
-    memcpy(&_cameraPosition, sourceBuffer, sizeof(_cameraPosition));
-    sourceBuffer += sizeof(_cameraPosition);
-    sourceBuffer += unpackOrientationQuatFromBytes(sourceBuffer, _cameraOrientation);
-    sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &_cameraFov);
-    sourceBuffer += unpackFloatRatioFromTwoByte(sourceBuffer,_cameraAspectRatio);
-    sourceBuffer += unpackClipValueFromTwoByte(sourceBuffer,_cameraNearClip);
-    sourceBuffer += unpackClipValueFromTwoByte(sourceBuffer,_cameraFarClip);
-    memcpy(&_cameraEyeOffsetPosition, sourceBuffer, sizeof(_cameraEyeOffsetPosition));
-    sourceBuffer += sizeof(_cameraEyeOffsetPosition);
+    sourceBuffer += ViewFrustum::unpackCameraDetails(sourceBuffer, _cameraPosition, _cameraOrientation, _cameraFov,
+                                                     _cameraAspectRatio, _cameraNearClip, _cameraFarClip,
+                                                     _cameraEyeOffsetPosition);
 
     // voxel sending features...
     unsigned char bitItems = 0;
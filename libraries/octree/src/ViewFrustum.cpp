@@ -10,6 +10,7 @@
 //
 
 #include <algorithm>
+#include <cstring>
 
 #include <glm/glm.hpp>
 #include <glm/gtx/quaternion.hpp>
@@ -624,6 +625,65 @@ void ViewFrustum::printDebugDetails() const {
         _eyeOffsetOrientation.w );
 }
 
+int ViewFrustum::packCameraDetails(unsigned char* destinationBuffer) const {
+    return packCameraDetails(destinationBuffer, _position, _orientation, _fieldOfView, _aspectRatio, _nearClip,
+                             _farClip, _eyeOffsetPosition);
+}
+
+int ViewFrustum::packCameraDetails(unsigned char* destinationBuffer, const glm::vec3& position,
+                                   const glm::quat& orientation, float fieldOfView, float aspectRatio, float nearClip,
+                                   float farClip, const glm::vec3& eyeOffsetPosition) {
+    unsigned char* bufferStart = destinationBuffer;
+
+    memcpy(destinationBuffer, &position, sizeof(position));
+    destinationBuffer += sizeof(position);
+    destinationBuffer += packOrientationQuatToBytes(destinationBuffer, orientation);
+    destinationBuffer += packFloatAngleToTwoByte(destinationBuffer, fieldOfView);
+    destinationBuffer += packFloatRatioToTwoByte(destinationBuffer, aspectRatio);
+    destinationBuffer += packClipValueToTwoByte(destinationBuffer, nearClip);
+    destinationBuffer += packClipValueToTwoByte(destinationBuffer, farClip);
+    memcpy(destinationBuffer, &eyeOffsetPosition, sizeof(eyeOffsetPosition));
+    destinationBuffer += sizeof(eyeOffsetPosition);
+
+    return destinationBuffer - bufferStart;
+}
+
+int ViewFrustum::unpackCameraDetails(const unsigned char* sourceBuffer) {
+    glm::vec3 position;
+    glm::quat orientation;
+    int bytesRead = unpackCameraDetails(sourceBuffer, position, orientation, _fieldOfView, _aspectRatio, _nearClip,
+                                        _farClip, _eyeOffsetPosition);
+    setPosition(position);
+    setOrientation(orientation);
+    return bytesRead;
+}
+
+int ViewFrustum::unpackCameraDetails(const unsigned char* sourceBuffer, glm::vec3& position, glm::quat& orientation,
+                                     float& fieldOfView, float& aspectRatio, float& nearClip, float& farClip,
+                                     glm::vec3& eyeOffsetPosition) {
+    const unsigned char* bufferStart = sourceBuffer;
+
+    memcpy(&position, sourceBuffer, sizeof(position));
+    sourceBuffer += sizeof(position);
+    sourceBuffer += unpackOrientationQuatFromBytes(sourceBuffer, orientation);
+    sourceBuffer += unpackFloatAngleFromTwoByte((uint16_t*) sourceBuffer, &fieldOfView);
+    sourceBuffer += unpackFloatRatioFromTwoByte(sourceBuffer, aspectRatio);
+    sourceBuffer += unpackClipValueFromTwoByte(sourceBuffer, nearClip);
+    sourceBuffer += unpackClipValueFromTwoByte(sourceBuffer, farClip);
+    memcpy(&eyeOffsetPosition, sourceBuffer, sizeof(eyeOffsetPosition));
+    sourceBuffer += sizeof(eyeOffsetPosition);
+
+    return sourceBuffer - bufferStart;
+}
+
+int ViewFrustum::numBytesCameraDetails() {
+    // measured by packing a camera, so it can't disagree with what packCameraDetails writes
+    const int MAX_CAMERA_DETAILS_BYTES = 64;
+    unsigned char buffer[MAX_CAMERA_DETAILS_BYTES];
+    static int numBytes = packCameraDetails(buffer, glm::vec3(), glm::quat(), 0.0f, 1.0f, 0.0f, 1.0f, glm::vec3());
+    return numBytes;
+}
+
 glm::vec2 ViewFrustum::projectPoint(glm::vec3 point, bool& pointInView) const {
 
     glm::vec4 pointVec4 = glm::vec4(point,1);
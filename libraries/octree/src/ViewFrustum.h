@@ -112,6 +112,22 @@ public:
 
     void printDebugDetails() const;
 
+    /// packs the camera position, orientation and lens details, the layout OctreeQuery sends them in too, returns bytes
+    /// written
+    int packCameraDetails(unsigned char* destinationBuffer) const;
+    static int packCameraDetails(unsigned char* destinationBuffer, const glm::vec3& position,
+                                 const glm::quat& orientation, float fieldOfView, float aspectRatio, float nearClip,
+                                 float farClip, const glm::vec3& eyeOffsetPosition);
+
+    /// unpacks details written by packCameraDetails, returns bytes read, call calculate() before using the frustum
+    int unpackCameraDetails(const unsigned char* sourceBuffer);
+    static int unpackCameraDetails(const unsigned char* sourceBuffer, glm::vec3& position, glm::quat& orientation,
+                                   float& fieldOfView, float& aspectRatio, float& nearClip, float& farClip,
+                                   glm::vec3& eyeOffsetPosition);
+
+    /// the number of bytes packCameraDetails writes
+    static int numBytesCameraDetails();
+
     glm::vec2 projectPoint(glm::vec3 point, bool& pointInView) const;
     OctreeProjectedPolygon getProjectedPolygon(const AACube& box) const;
     void getFurthestPointFromCamera(const AACube& box, glm::vec3& furthestPoint) const;
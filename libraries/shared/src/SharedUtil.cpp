@@ -556,6 +556,64 @@ int unpackOrientationQuatFromBytes(const unsigned char* buffer, glm::quat& quatO
     return sizeof(quatParts);
 }
 
+int packOrientationQuatToSmallestThree(unsigned char* buffer, const glm::quat& quatInput, int bitsPerComponent) {
+    glm::quat quat = glm::normalize(quatInput);
+    float components[4] = { quat.x, quat.y, quat.z, quat.w };
+
+    int largestIndex = 0;
+    for (int i = 1; i < 4; i++) {
+        if (fabsf(components[i]) > fabsf(components[largestIndex])) {
+            largestIndex = i;
+        }
+    }
+
+    // q and -q are the same rotation, so we flip the quat to make the one we leave out positive
+    float sign = (components[largestIndex] < 0.0f) ? -1.0f : 1.0f;
+    const float MAX_COMPONENT_VALUE = (float) (((quint64) 1 << bitsPerComponent) - 1);
+
+    quint64 packed = largestIndex;
+    for (int i = 0; i < 4; i++) {
+        if (i != largestIndex) {
+            float ratio = glm::clamp(((components[i] * sign * SQUARE_ROOT_OF_2) + 1.0f) * 0.5f, 0.0f, 1.0f);
+            packed = (packed << bitsPerComponent) | (quint64) (ratio * MAX_COMPONENT_VALUE + 0.5f);
+        }
+    }
+
+    // least significant byte first
+    int numBytes = numBytesForSmallestThreeQuat(bitsPerComponent);
+    for (int i = 0; i < numBytes; i++) {
+        buffer[i] = (unsigned char) (packed >> (i * BITS_IN_BYTE));
+    }
+    return numBytes;
+}
+
+int unpackOrientationQuatFromSmallestThree(const unsigned char* buffer, glm::quat& quatOutput, int bitsPerComponent) {
+    int numBytes = numBytesForSmallestThreeQuat(bitsPerComponent);
+    quint64 packed = 0;
+    for (int i = 0; i < numBytes; i++) {
+        packed |= (quint64) buffer[i] << (i * BITS_IN_BYTE);
+    }
+
+    const quint64 COMPONENT_MASK = ((quint64) 1 << bitsPerComponent) - 1;
+    const float MAX_COMPONENT_VALUE = (float) COMPONENT_MASK;
+    int largestIndex = (int) (packed >> (3 * bitsPerComponent)) & 3;
+
+    // the components were packed in order, so the last one is in the low bits
+    float components[4];
+    float sumOfSquares = 0.0f;
+    for (int i = 3; i >= 0; i--) {
+        if (i != largestIndex) {
+            components[i] = (((packed & COMPONENT_MASK) / MAX_COMPONENT_VALUE) * 2.0f - 1.0f) / SQUARE_ROOT_OF_2;
+            sumOfSquares += components[i] * components[i];
+            packed >>= bitsPerComponent;
+        }
+    }
+    components[largestIndex] = sqrtf(glm::max(0.0f, 1.0f - sumOfSquares));
+
+    quatOutput = glm::quat(components[3], components[0], components[1], components[2]);
+    return numBytes;
+}
+
 float SMALL_LIMIT = 10.f;
 float LARGE_LIMIT = 1000.f;
 
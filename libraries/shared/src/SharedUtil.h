@@ -136,6 +136,16 @@ int unpackFloatAngleFromTwoByte(const uint16_t* byteAnglePointer, float* destina
 int packOrientationQuatToBytes(unsigned char* buffer, const glm::quat& quatInput);
 int unpackOrientationQuatFromBytes(const unsigned char* buffer, glm::quat& quatOutput);
 
+// Since a unit quaternion's components square to one, the largest can be rebuilt from the other three, which are then
+// known to be between -1/sqrt(2) and 1/sqrt(2). These pack those three in bitsPerComponent bits each, after two bits
+// for which one was left out, so 10 bits per component fits a rotation in four bytes. bitsPerComponent can be up to 20.
+const int MAX_SMALLEST_THREE_BITS_PER_COMPONENT = 20;
+inline int numBytesForSmallestThreeQuat(int bitsPerComponent) {
+    return (2 + (3 * bitsPerComponent) + BITS_IN_BYTE - 1) / BITS_IN_BYTE;
+}
+int packOrientationQuatToSmallestThree(unsigned char* buffer, const glm::quat& quatInput, int bitsPerComponent);
+int unpackOrientationQuatFromSmallestThree(const unsigned char* buffer, glm::quat& quatOutput, int bitsPerComponent);
+
 // Ratios need the be highly accurate when less than 10, but not very accurate above 10, and they
 // are never greater than 1000 to 1, this allows us to encode each component in 16bits
 int packFloatRatioToTwoByte(unsigned char* buffer, float ratio);
@@ -56,6 +56,7 @@ public:
     virtual int processEditPacketData(PacketType packetType, const unsigned char* packetData, int packetLength,
                     const unsigned char* editData, int maxLength, const SharedNodePointer& node);
     virtual bool recurseChildrenWithData() const { return false; }
+    virtual bool changesMarkAncestors() const { return true; }
 
 private:
     // helper functions for nudgeSubTree
@@ -0,0 +1,287 @@
+//
+//  AudioMixKernelTests.cpp
+//  tests/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+#include "AudioRingBuffer.h"
+#include "SharedUtil.h"
+
+#include "AudioMixKernelTests.h"
+
+const int MAX_TEST_SAMPLE_DELAY = 20;
+const int SOURCE_SAMPLES = NETWORK_BUFFER_LENGTH_SAMPLES_STEREO + MAX_TEST_SAMPLE_DELAY;
+const int MIX_SAMPLES = NETWORK_BUFFER_LENGTH_SAMPLES_STEREO + (MAX_TEST_SAMPLE_DELAY * 2);
+
+const int BENCHMARK_ITERATIONS = 100000;
+
+static void fillWithRandomSamples(int16_t* samples, int numSamples) {
+    for (int i = 0; i < numSamples; i++) {
+        samples[i] = (int16_t) randIntInRange(MIN_SAMPLE_VALUE, MAX_SAMPLE_VALUE);
+    }
+}
+
+static void fillWithRandomMix(float* mix, int numSamples) {
+    // go past the sample range so that the clamp has something to do
+    for (int i = 0; i < numSamples; i++) {
+        mix[i] = randFloatInRange(2.0f * MIN_SAMPLE_VALUE, 2.0f * MAX_SAMPLE_VALUE);
+    }
+}
+
+// the spatialized mono loop from AudioMixer::addBufferToMixForListeningNodeWithBuffer before it used the kernels
+static void legacyMixMonoSpatialized(int16_t* clientSamples, const int16_t* nextOutputStart, float attenuationCoefficient,
+                                     float weakChannelAmplitudeRatio, int numSamplesDelay, int delayedChannelOffset) {
+    int goodChannelOffset = delayedChannelOffset == 0 ? 1 : 0;
+
+    int16_t correctBufferSample[2], delayBufferSample[2];
+    int delayedChannelIndex = 0;
+
+    const int SINGLE_STEREO_OFFSET = 2;
+
+    for (int s = 0; s < NETWORK_BUFFER_LENGTH_SAMPLES_STEREO; s += 4) {
+        correctBufferSample[0] = nextOutputStart[s / 2] * attenuationCoefficient;
+        correctBufferSample[1] = nextOutputStart[(s / 2) + 1] * attenuationCoefficient;
+
+        delayedChannelIndex = s + (numSamplesDelay * 2) + delayedChannelOffset;
+
+        delayBufferSample[0] = correctBufferSample[0] * weakChannelAmplitudeRatio;
+        delayBufferSample[1] = correctBufferSample[1] * weakChannelAmplitudeRatio;
+
+        clientSamples[s + goodChannelOffset] += correctBufferSample[0];
+        clientSamples[s + goodChannelOffset + SINGLE_STEREO_OFFSET] += correctBufferSample[1];
+        clientSamples[delayedChannelIndex] += delayBufferSample[0];
+        clientSamples[delayedChannelIndex + SINGLE_STEREO_OFFSET] += delayBufferSample[1];
+    }
+
+    if (numSamplesDelay > 0) {
+        float attenuationAndWeakChannelRatio = attenuationCoefficient * weakChannelAmplitudeRatio;
+        const int16_t* delayNextOutputStart = nextOutputStart - numSamplesDelay;
+
+        for (int i = 0; i < numSamplesDelay; i++) {
+            int parentIndex = i * 2;
+            clientSamples[parentIndex + delayedChannelOffset] += delayNextOutputStart[i] * attenuationAndWeakChannelRatio;
+        }
+    }
+}
+
+// the stereo loop from AudioMixer::addBufferToMixForListeningNodeWithBuffer before it used the kernels
+static void legacyMixStereo(int16_t* clientSamples, const int16_t* nextOutputStart, float attenuationCoefficient,
+                            bool isStereo) {
+    for (int s = 0; s < NETWORK_BUFFER_LENGTH_SAMPLES_STEREO; s += 4) {
+        int stereoDivider = isStereo ? 1 : 2;
+
+        clientSamples[s] = glm::clamp(clientSamples[s]
+                                      + (int) (nextOutputStart[(s / stereoDivider)] * attenuationCoefficient),
+                                      MIN_SAMPLE_VALUE, MAX_SAMPLE_VALUE);
+        clientSamples[s + 1] = glm::clamp(clientSamples[s + 1]
+                                          + (int) (nextOutputStart[(s / stereoDivider) + (1 / stereoDivider)]
+                                                   * attenuationCoefficient),
+                                          MIN_SAMPLE_VALUE, MAX_SAMPLE_VALUE);
+        clientSamples[s + 2] = glm::clamp(clientSamples[s + 2]
+                                          + (int) (nextOutputStart[(s / stereoDivider) + (2 / stereoDivider)]
+                                                   * attenuationCoefficient),
+                                          MIN_SAMPLE_VALUE, MAX_SAMPLE_VALUE);
+        clientSamples[s + 3] = glm::clamp(clientSamples[s + 3]
+                                          + (int) (nextOutputStart[(s / stereoDivider) + (3 / stereoDivider)]
+                                                   * attenuationCoefficient),
+                                          MIN_SAMPLE_VALUE, MAX_SAMPLE_VALUE);
+    }
+}
+
+// the spatialized mono path as AudioMixer::addBufferToMixForListeningNodeWithBuffer now runs it
+static void kernelMixMonoSpatialized(float* clientSamples, const int16_t* nextOutputStart, float attenuationCoefficient,
+                                     float weakChannelAmplitudeRatio, int numSamplesDelay, int delayedChannelOffset,
+                                     bool useScalar) {
+    void (*mixChannel)(float*, const int16_t*, int, float, float) = useScalar
+        ? mixMonoToStereoChannelScalar : mixMonoToStereoChannel;
+
+    int goodChannelOffset = delayedChannelOffset == 0 ? 1 : 0;
+    float attenuationAndWeakChannelRatio = attenuationCoefficient * weakChannelAmplitudeRatio;
+
+    mixChannel(clientSamples + goodChannelOffset, nextOutputStart, NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL,
+               attenuationCoefficient, 0.0f);
+    mixChannel(clientSamples + delayedChannelOffset, nextOutputStart - numSamplesDelay, numSamplesDelay,
+               attenuationAndWeakChannelRatio, 0.0f);
+    mixChannel(clientSamples + (numSamplesDelay * 2) + delayedChannelOffset, nextOutputStart,
+               NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL - numSamplesDelay, attenuationAndWeakChannelRatio, 0.0f);
+}
+
+static bool compareMixes(const char* testName, const float* expected, const float* actual, int numSamples) {
+    // the SIMD kernels build a ramped gain in a different order than the scalar ones and the compiler may contract the
+    // scalar multiply and add, so allow for a little float rounding relative to the size of the sample
+    const float MAX_MIX_SAMPLE_ERROR = 0.01f;
+    const float MAX_MIX_SAMPLE_RELATIVE_ERROR = 1.0e-6f;
+
+    for (int i = 0; i < numSamples; i++) {
+        float maxError = std::max(MAX_MIX_SAMPLE_ERROR, fabsf(expected[i]) * MAX_MIX_SAMPLE_RELATIVE_ERROR);
+        if (fabsf(expected[i] - actual[i]) > maxError) {
+            qDebug("FAILED - %s: sample %d expected %f actual %f", testName, i, expected[i], actual[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool compareSamples(const char* testName, const int16_t* expected, const int16_t* actual, int numSamples) {
+    for (int i = 0; i < numSamples; i++) {
+        if (expected[i] != actual[i]) {
+            qDebug("FAILED - %s: sample %d expected %d actual %d", testName, i, expected[i], actual[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+void AudioMixKernelTests::testKernelsMatchScalar() {
+    int16_t source[SOURCE_SAMPLES];
+    float scalarMix[MIX_SAMPLES];
+    float kernelMix[MIX_SAMPLES];
+    int16_t scalarSamples[MIX_SAMPLES];
+    int16_t kernelSamples[MIX_SAMPLES];
+
+    const int NUM_TRIALS = 1000;
+
+    for (int trial = 0; trial < NUM_TRIALS; trial++) {
+        fillWithRandomSamples(source, SOURCE_SAMPLES);
+        fillWithRandomMix(scalarMix, MIX_SAMPLES);
+        memcpy(kernelMix, scalarMix, sizeof(kernelMix));
+
+        // odd sample counts make sure the scalar tails of the kernels get exercised
+        int numSamples = randIntInRange(0, NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL);
+        int channelOffset = randIntInRange(0, 1);
+        float gain = randFloat();
+
+        // ramp towards another random gain over the frame, like the mixer does when a source's gain changes
+        float gainStep = (randFloat() - gain) / NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL;
+
+        mixMonoToStereoChannelScalar(scalarMix + channelOffset, source, numSamples, gain, gainStep);
+        mixMonoToStereoChannel(kernelMix + channelOffset, source, numSamples, gain, gainStep);
+        if (!compareMixes("mixMonoToStereoChannel", scalarMix, kernelMix, MIX_SAMPLES)) {
+            return;
+        }
+
+        mixMonoToStereoScalar(scalarMix, source, numSamples, gain, gainStep);
+        mixMonoToStereo(kernelMix, source, numSamples, gain, gainStep);
+        if (!compareMixes("mixMonoToStereo", scalarMix, kernelMix, MIX_SAMPLES)) {
+            return;
+        }
+
+        mixStereoToStereoScalar(scalarMix, source, numSamples * 2, gain, gainStep);
+        mixStereoToStereo(kernelMix, source, numSamples * 2, gain, gainStep);
+        if (!compareMixes("mixStereoToStereo", scalarMix, kernelMix, MIX_SAMPLES)) {
+            return;
+        }
+
+        clampMixToSamplesScalar(scalarMix, scalarSamples, numSamples * 2);
+        clampMixToSamples(scalarMix, kernelSamples, numSamples * 2);
+        if (!compareSamples("clampMixToSamples", scalarSamples, kernelSamples, numSamples * 2)) {
+            return;
+        }
+    }
+
+    qDebug("mix kernels match the scalar kernels for %d random trials", NUM_TRIALS);
+}
+
+static void reportTime(const char* testName, quint64 start, quint64 end, float baselineUsecs = 0.0f) {
+    float usecsPerFrame = (float) (end - start) / BENCHMARK_ITERATIONS;
+    if (baselineUsecs > 0.0f) {
+        qDebug("TIME - %s: %.3f usecs per frame (%.2fx)", testName, usecsPerFrame, baselineUsecs / usecsPerFrame);
+    } else {
+        qDebug("TIME - %s: %.3f usecs per frame", testName, usecsPerFrame);
+    }
+}
+
+void AudioMixKernelTests::benchmarkKernels() {
+    int16_t source[SOURCE_SAMPLES];
+    int16_t legacyMix[MIX_SAMPLES];
+    float mix[MIX_SAMPLES];
+    int16_t samples[MIX_SAMPLES];
+    fillWithRandomSamples(source, SOURCE_SAMPLES);
+    memset(legacyMix, 0, sizeof(legacyMix));
+    memset(mix, 0, sizeof(mix));
+
+    // keep the gains low enough that the legacy loops (which don't saturate the mono path) stay in range
+    const float BENCHMARK_GAIN = 0.01f;
+    const float BENCHMARK_WEAK_CHANNEL_RATIO = 0.75f;
+    const int BENCHMARK_SAMPLE_DELAY = 10;
+
+    const int16_t* frameStart = source + MAX_TEST_SAMPLE_DELAY;
+
+    quint64 start = usecTimestampNow();
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        legacyMixMonoSpatialized(legacyMix, frameStart, BENCHMARK_GAIN, BENCHMARK_WEAK_CHANNEL_RATIO,
+                                 BENCHMARK_SAMPLE_DELAY, 1);
+    }
+    quint64 end = usecTimestampNow();
+    float legacyUsecs = (float) (end - start) / BENCHMARK_ITERATIONS;
+    reportTime("spatialized mono, legacy loop", start, end);
+
+    start = usecTimestampNow();
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        kernelMixMonoSpatialized(mix, frameStart, BENCHMARK_GAIN, BENCHMARK_WEAK_CHANNEL_RATIO, BENCHMARK_SAMPLE_DELAY, 1,
+                                 true);
+    }
+    end = usecTimestampNow();
+    reportTime("spatialized mono, scalar kernel", start, end, legacyUsecs);
+
+    start = usecTimestampNow();
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        kernelMixMonoSpatialized(mix, frameStart, BENCHMARK_GAIN, BENCHMARK_WEAK_CHANNEL_RATIO, BENCHMARK_SAMPLE_DELAY, 1,
+                                 false);
+    }
+    end = usecTimestampNow();
+    reportTime("spatialized mono, kernel", start, end, legacyUsecs);
+
+    start = usecTimestampNow();
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        legacyMixStereo(legacyMix, source, BENCHMARK_GAIN, true);
+    }
+    end = usecTimestampNow();
+    legacyUsecs = (float) (end - start) / BENCHMARK_ITERATIONS;
+    reportTime("stereo, legacy loop", start, end);
+
+    start = usecTimestampNow();
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        mixStereoToStereoScalar(mix, source, NETWORK_BUFFER_LENGTH_SAMPLES_STEREO, BENCHMARK_GAIN);
+    }
+    end = usecTimestampNow();
+    reportTime("stereo, scalar kernel", start, end, legacyUsecs);
+
+    start = usecTimestampNow();
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        mixStereoToStereo(mix, source, NETWORK_BUFFER_LENGTH_SAMPLES_STEREO, BENCHMARK_GAIN);
+    }
+    end = usecTimestampNow();
+    reportTime("stereo, kernel", start, end, legacyUsecs);
+
+    // the float mix costs one clamp per listener per frame, where the legacy loops clamped every source they added
+    start = usecTimestampNow();
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        clampMixToSamplesScalar(mix, samples, NETWORK_BUFFER_LENGTH_SAMPLES_STEREO);
+    }
+    end = usecTimestampNow();
+    reportTime("final clamp, scalar kernel", start, end);
+
+    start = usecTimestampNow();
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++) {
+        clampMixToSamples(mix, samples, NETWORK_BUFFER_LENGTH_SAMPLES_STEREO);
+    }
+    end = usecTimestampNow();
+    reportTime("final clamp, kernel", start, end);
+
+    // print something from the mixes so the compiler can't throw the work away
+    qDebug("benchmark mix checksum %d", legacyMix[0] + samples[0] + samples[NETWORK_BUFFER_LENGTH_SAMPLES_STEREO - 1]);
+}
+
+void AudioMixKernelTests::runAllTests() {
+    testKernelsMatchScalar();
+    benchmarkKernels();
+}
@@ -0,0 +1,27 @@
+//
+//  AudioMixKernelTests.h
+//  tests/audio/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_AudioMixKernelTests_h
+#define hifi_AudioMixKernelTests_h
+
+#include "AudioMixKernels.h"
+
+namespace AudioMixKernelTests {
+
+    void runAllTests();
+
+    /// checks that the SIMD kernels produce exactly what the scalar kernels do
+    void testKernelsMatchScalar();
+
+    /// times the kernels against the scalar kernels and the loops the audio mixer used before the kernels existed
+    void benchmarkKernels();
+};
+
+#endif // hifi_AudioMixKernelTests_h
@@ -8,11 +8,13 @@
 //  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
 //
 
+#include "AudioMixKernelTests.h"
 #include "AudioRingBufferTests.h"
 #include <stdio.h>
 
 int main(int argc, char** argv) {
     AudioRingBufferTests::runAllTests();
+    AudioMixKernelTests::runAllTests();
     printf("all tests passed.  press enter to exit\n");
     getchar();
     return 0;
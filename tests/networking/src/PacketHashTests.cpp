@@ -0,0 +1,203 @@
+//
+//  PacketHashTests.cpp
+//  tests/networking/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDebug>
+
+#include "LimitedNodeList.h"
+#include "MD5Hash.h"
+#include "PacketHeaders.h"
+#include "SharedUtil.h"
+#include "SipHash.h"
+
+#include "PacketHashTests.h"
+
+static QByteArray randomBytes(int length) {
+    QByteArray bytes(length, 0);
+    for (int i = 0; i < length; i++) {
+        bytes[i] = (char) (rand() % 256);
+    }
+    return bytes;
+}
+
+void PacketHashTests::runAllTests() {
+    md5MatchesQtTest();
+    inPlaceHashTest();
+    sipHashVectorsTest();
+    sipHashPacketTest();
+    benchmarkHashes();
+}
+
+void PacketHashTests::md5MatchesQtTest() {
+    const int MAX_TEST_LENGTH = 2 * MAX_PACKET_SIZE;
+    const int CHUNK_SIZES[] = { 1, 7, 64, 100, MAX_TEST_LENGTH };
+    const int NUM_CHUNK_SIZES = sizeof(CHUNK_SIZES) / sizeof(CHUNK_SIZES[0]);
+
+    for (int length = 0; length < MAX_TEST_LENGTH; length += 1 + (length / 16)) {
+        QByteArray data = randomBytes(length);
+        QByteArray expectedDigest = QCryptographicHash::hash(data, QCryptographicHash::Md5);
+
+        // feeding the data in pieces has to give the same digest as feeding it all at once
+        for (int i = 0; i < NUM_CHUNK_SIZES; i++) {
+            MD5Hash md5Hash;
+            for (int offset = 0; offset < length; offset += CHUNK_SIZES[i]) {
+                md5Hash.addData(data.constData() + offset, qMin(CHUNK_SIZES[i], length - offset));
+            }
+
+            char digest[NUM_BYTES_MD5_DIGEST];
+            md5Hash.result(digest);
+            assert(QByteArray(digest, NUM_BYTES_MD5_DIGEST) == expectedDigest);
+        }
+    }
+}
+
+void PacketHashTests::inPlaceHashTest() {
+    QUuid sessionUUID = QUuid::createUuid();
+    QUuid connectionSecret = QUuid::createUuid();
+
+    for (int payloadLength = 0; payloadLength < MAX_PACKET_SIZE - MAX_PACKET_HEADER_BYTES; payloadLength += 37) {
+        char packet[MAX_PACKET_SIZE];
+        // avatar identity packets are still hashed with MD5
+        int numBytesPacketHeader = populatePacketHeader(packet, PacketTypeAvatarIdentity, sessionUUID);
+        int packetLength = numBytesPacketHeader + payloadLength;
+
+        QByteArray payload = randomBytes(payloadLength);
+        memcpy(packet + numBytesPacketHeader, payload.constData(), payloadLength);
+
+        writeHashInPacketGivenConnectionUUID(packet, packetLength, connectionSecret);
+
+        // the hash written in place has to be the MD5 the receiving side checks against
+        QByteArray hashedPacket(packet, packetLength);
+        QByteArray expectedHash = QCryptographicHash::hash(payload + connectionSecret.toRfc4122(),
+                                                           QCryptographicHash::Md5);
+        assert(hashFromPacketHeader(hashedPacket) == expectedHash);
+        assert(hashForPacketAndConnectionUUID(hashedPacket, connectionSecret) == expectedHash);
+
+        // and writing it in place mustn't have touched anything but the hash
+        assert(uuidFromPacketHeader(hashedPacket) == sessionUUID);
+        assert(hashedPacket.mid(numBytesPacketHeader) == payload);
+    }
+}
+
+void PacketHashTests::sipHashVectorsTest() {
+    // the test vectors from the SipHash paper - key 00 01 02 ... 0f, message 00 01 02 ... of each length
+    char key[NUM_BYTES_SIP_HASH_KEY];
+    for (int i = 0; i < NUM_BYTES_SIP_HASH_KEY; i++) {
+        key[i] = (char) i;
+    }
+
+    char message[64];
+    for (int i = 0; i < (int) sizeof(message); i++) {
+        message[i] = (char) i;
+    }
+
+    assert(sipHash24(message, 0, key) == Q_UINT64_C(0x726fdb47dd0e0e31));
+    assert(sipHash24(message, 15, key) == Q_UINT64_C(0xa129ca6149be45e5));
+    assert(sipHash24(message, 63, key) == Q_UINT64_C(0x958a324ceb064572));
+
+    // the byte version writes the same value little endian
+    char hash[NUM_BYTES_SIP_HASH];
+    sipHash24(message, 15, key, hash);
+    const unsigned char EXPECTED_BYTES[NUM_BYTES_SIP_HASH] = { 0xe5, 0x45, 0xbe, 0x49, 0x61, 0xca, 0x29, 0xa1 };
+    assert(memcmp(hash, EXPECTED_BYTES, NUM_BYTES_SIP_HASH) == 0);
+}
+
+void PacketHashTests::sipHashPacketTest() {
+    QUuid sessionUUID = QUuid::createUuid();
+    QUuid connectionSecret = QUuid::createUuid();
+    QByteArray key = connectionSecret.toRfc4122();
+
+    assert(packetUsesSipHash(PacketTypeMixedAudio, versionForPacketType(PacketTypeMixedAudio)));
+    assert(!packetUsesSipHash(PacketTypeMixedAudio, versionForPacketType(PacketTypeMixedAudio) - 1));
+    assert(!packetUsesSipHash(PacketTypeAvatarIdentity, versionForPacketType(PacketTypeAvatarIdentity)));
+
+    for (int payloadLength = 0; payloadLength < MAX_PACKET_SIZE - MAX_PACKET_HEADER_BYTES; payloadLength += 37) {
+        char packet[MAX_PACKET_SIZE];
+        int numBytesPacketHeader = populatePacketHeader(packet, PacketTypeMixedAudio, sessionUUID);
+        int packetLength = numBytesPacketHeader + payloadLength;
+
+        QByteArray payload = randomBytes(payloadLength);
+        memcpy(packet + numBytesPacketHeader, payload.constData(), payloadLength);
+
+        writeHashInPacketGivenConnectionUUID(packet, packetLength, connectionSecret);
+        assert(packetHashMatchesConnectionUUID(packet, packetLength, connectionSecret));
+
+        // the MAC leads the hash bytes in the header and the rest of them are zero
+        char expectedMAC[NUM_BYTES_SIP_HASH];
+        sipHash24(payload.constData(), payloadLength, key.constData(), expectedMAC);
+
+        QByteArray hashedPacket(packet, packetLength);
+        QByteArray hash = hashFromPacketHeader(hashedPacket);
+        assert(hash.left(NUM_BYTES_SIP_HASH) == QByteArray(expectedMAC, NUM_BYTES_SIP_HASH));
+        assert(hash.mid(NUM_BYTES_SIP_HASH) == QByteArray(NUM_BYTES_MD5_HASH - NUM_BYTES_SIP_HASH, 0));
+        assert(hashForPacketAndConnectionUUID(hashedPacket, connectionSecret) == hash);
+
+        // a flipped payload bit or the wrong secret has to fail verification
+        if (payloadLength > 0) {
+            packet[numBytesPacketHeader + (payloadLength / 2)] ^= 0x10;
+            assert(!packetHashMatchesConnectionUUID(packet, packetLength, connectionSecret));
+            packet[numBytesPacketHeader + (payloadLength / 2)] ^= 0x10;
+        }
+        assert(!packetHashMatchesConnectionUUID(packet, packetLength, QUuid::createUuid()));
+    }
+}
+
+void PacketHashTests::benchmarkHashes() {
+    const int PAYLOAD_SIZES[] = { 64, 256, 512, 1024, MAX_PACKET_SIZE - MAX_PACKET_HEADER_BYTES };
+    const int NUM_PAYLOAD_SIZES = sizeof(PAYLOAD_SIZES) / sizeof(PAYLOAD_SIZES[0]);
+    const int BENCHMARK_ITERATIONS = 20000;
+
+    QUuid connectionSecret = QUuid::createUuid();
+    QByteArray key = connectionSecret.toRfc4122();
+    char hash[NUM_BYTES_MD5_DIGEST];
+
+    // accumulate something from every hash so none of the loops can be optimized away
+    char checksum = 0;
+
+    for (int i = 0; i < NUM_PAYLOAD_SIZES; i++) {
+        QByteArray payload = randomBytes(PAYLOAD_SIZES[i]);
+
+        // what every packet used to cost, a QCryptographicHash and the concatenated secret
+        quint64 start = usecTimestampNow();
+        for (int j = 0; j < BENCHMARK_ITERATIONS; j++) {
+            QCryptographicHash md5Hash(QCryptographicHash::Md5);
+            md5Hash.addData(payload);
+            md5Hash.addData(key);
+            checksum ^= md5Hash.result()[0];
+        }
+        float qtMD5Usecs = (float) (usecTimestampNow() - start) / BENCHMARK_ITERATIONS;
+
+        start = usecTimestampNow();
+        for (int j = 0; j < BENCHMARK_ITERATIONS; j++) {
+            MD5Hash md5Hash;
+            md5Hash.addData(payload.constData(), payload.size());
+            md5Hash.addData(key.constData(), key.size());
+            md5Hash.result(hash);
+            checksum ^= hash[0];
+        }
+        float md5Usecs = (float) (usecTimestampNow() - start) / BENCHMARK_ITERATIONS;
+
+        start = usecTimestampNow();
+        for (int j = 0; j < BENCHMARK_ITERATIONS; j++) {
+            sipHash24(payload.constData(), payload.size(), key.constData(), hash);
+            checksum ^= hash[0];
+        }
+        float sipHashUsecs = (float) (usecTimestampNow() - start) / BENCHMARK_ITERATIONS;
+
+        qDebug("TIME - %d byte payload: QCryptographicHash MD5 %.3f, MD5Hash %.3f, SipHash %.3f usecs per packet "
+               "(%.2fx)", PAYLOAD_SIZES[i], qtMD5Usecs, md5Usecs, sipHashUsecs, qtMD5Usecs / sipHashUsecs);
+    }
+
+    qDebug("hash benchmark checksum %d", checksum);
+}
@@ -0,0 +1,25 @@
+//
+//  PacketHashTests.h
+//  tests/networking/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_PacketHashTests_h
+#define hifi_PacketHashTests_h
+
+namespace PacketHashTests {
+
+    void runAllTests();
+
+    void md5MatchesQtTest();
+    void inPlaceHashTest();
+    void sipHashVectorsTest();
+    void sipHashPacketTest();
+    void benchmarkHashes();
+};
+
+#endif // hifi_PacketHashTests_h
@@ -0,0 +1,110 @@
+//
+//  ReceivedDatagramQueueTests.cpp
+//  tests/networking/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <assert.h>
+#include <algorithm>
+
+#include <QtCore/QThread>
+
+#include "ReceivedDatagramQueue.h"
+
+#include "ReceivedDatagramQueueTests.h"
+
+void ReceivedDatagramQueueTests::runAllTests() {
+    wrapAroundTest();
+    producerThreadTest();
+}
+
+static void writeNumber(QByteArray& packet, int number) {
+    packet = QByteArray::number(number);
+}
+
+static int readNumber(const QByteArray& packet) {
+    return packet.toInt();
+}
+
+void ReceivedDatagramQueueTests::wrapAroundTest() {
+    const int CAPACITY = 8;
+    ReceivedDatagramQueue queue(CAPACITY);
+    assert(queue.getCapacity() >= CAPACITY);
+    assert(queue.front() == NULL);
+
+    int nextPushed = 0;
+    int nextPopped = 0;
+
+    // push and pop in uneven runs so the ends of the ring wrap around a few times
+    for (int round = 0; round < 50; round++) {
+        int numToPush = std::min(1 + (round % 5), queue.numFreeSlots());
+        for (int i = 0; i < numToPush; i++) {
+            writeNumber(queue.freeSlot(i).packet, nextPushed + i);
+        }
+        queue.push(numToPush);
+        nextPushed += numToPush;
+
+        int numToPop = 1 + (round % 3);
+        for (int i = 0; i < numToPop && queue.front(); i++) {
+            assert(readNumber(queue.front()->packet) == nextPopped);
+            queue.pop();
+            nextPopped++;
+        }
+    }
+
+    while (queue.front()) {
+        assert(readNumber(queue.front()->packet) == nextPopped);
+        queue.pop();
+        nextPopped++;
+    }
+    assert(nextPopped == nextPushed);
+    assert(queue.numFreeSlots() == queue.getCapacity());
+}
+
+class QueueProducerThread : public QThread {
+public:
+    QueueProducerThread(ReceivedDatagramQueue& queue, int numDatagrams) : _queue(queue), _numDatagrams(numDatagrams) { }
+
+protected:
+    void run() {
+        int nextPushed = 0;
+        while (nextPushed < _numDatagrams) {
+            int numToPush = std::min(_queue.numFreeSlots(), _numDatagrams - nextPushed);
+            for (int i = 0; i < numToPush; i++) {
+                writeNumber(_queue.freeSlot(i).packet, nextPushed + i);
+            }
+            _queue.push(numToPush);
+            nextPushed += numToPush;
+        }
+    }
+
+private:
+    ReceivedDatagramQueue& _queue;
+    int _numDatagrams;
+};
+
+void ReceivedDatagramQueueTests::producerThreadTest() {
+    const int NUM_DATAGRAMS = 200000;
+    ReceivedDatagramQueue queue(64);
+
+    QueueProducerThread producer(queue, NUM_DATAGRAMS);
+    producer.start();
+
+    // everything has to come out exactly once and in the order it went in
+    int nextPopped = 0;
+    while (nextPopped < NUM_DATAGRAMS) {
+        ReceivedDatagram* datagram = queue.front();
+        if (datagram) {
+            assert(readNumber(datagram->packet) == nextPopped);
+            queue.pop();
+            nextPopped++;
+        }
+    }
+
+    producer.wait();
+    assert(queue.front() == NULL);
+}
@@ -0,0 +1,22 @@
+//
+//  ReceivedDatagramQueueTests.h
+//  tests/networking/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_ReceivedDatagramQueueTests_h
+#define hifi_ReceivedDatagramQueueTests_h
+
+namespace ReceivedDatagramQueueTests {
+
+    void runAllTests();
+
+    void wrapAroundTest();
+    void producerThreadTest();
+};
+
+#endif // hifi_ReceivedDatagramQueueTests_h
@@ -0,0 +1,113 @@
+//
+//  ReceivedPacketQueueTests.cpp
+//  tests/networking/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <assert.h>
+
+#include <QtCore/QThread>
+#include <QtCore/QVector>
+
+#include "ReceivedPacketQueue.h"
+
+#include "ReceivedPacketQueueTests.h"
+
+void ReceivedPacketQueueTests::runAllTests() {
+    fullQueueTest();
+    multipleProducerTest();
+}
+
+static QByteArray makePacket(int producer, int number) {
+    return QByteArray::number(producer) + ":" + QByteArray::number(number);
+}
+
+void ReceivedPacketQueueTests::fullQueueTest() {
+    const int CAPACITY = 16;
+    ReceivedPacketQueue queue(CAPACITY);
+    assert(queue.getCapacity() == CAPACITY);
+
+    QueuedPacket batch[CAPACITY];
+    assert(queue.popBatch(batch, CAPACITY) == 0);
+
+    // go around the ring a few times, filling it each time
+    for (int lap = 0; lap < 4; lap++) {
+        for (int i = 0; i < CAPACITY; i++) {
+            assert(queue.push(SharedNodePointer(), makePacket(lap, i)));
+        }
+        assert(!queue.push(SharedNodePointer(), makePacket(lap, CAPACITY)));
+
+        // pop in two uneven batches
+        const int FIRST_BATCH_SIZE = 5;
+        assert(queue.popBatch(batch, FIRST_BATCH_SIZE) == FIRST_BATCH_SIZE);
+        assert(queue.popBatch(batch + FIRST_BATCH_SIZE, CAPACITY) == CAPACITY - FIRST_BATCH_SIZE);
+
+        for (int i = 0; i < CAPACITY; i++) {
+            assert(batch[i].packet == makePacket(lap, i));
+            batch[i] = QueuedPacket();
+        }
+        assert(queue.popBatch(batch, CAPACITY) == 0);
+    }
+}
+
+class PacketProducerThread : public QThread {
+public:
+    PacketProducerThread(ReceivedPacketQueue& queue, int producer, int numPackets) :
+        _queue(queue),
+        _producer(producer),
+        _numPackets(numPackets) { }
+
+protected:
+    void run() {
+        for (int i = 0; i < _numPackets; i++) {
+            QByteArray packet = makePacket(_producer, i);
+            while (!_queue.push(SharedNodePointer(), packet)) {
+                yieldCurrentThread();
+            }
+        }
+    }
+
+private:
+    ReceivedPacketQueue& _queue;
+    int _producer;
+    int _numPackets;
+};
+
+void ReceivedPacketQueueTests::multipleProducerTest() {
+    const int NUM_PRODUCERS = 4;
+    const int PACKETS_PER_PRODUCER = 50000;
+    const int BATCH_SIZE = 32;
+    ReceivedPacketQueue queue(256);
+
+    QVector<PacketProducerThread*> producers;
+    for (int i = 0; i < NUM_PRODUCERS; i++) {
+        producers.append(new PacketProducerThread(queue, i, PACKETS_PER_PRODUCER));
+        producers.last()->start();
+    }
+
+    // every packet has to come out exactly once, and each producer's packets in the order it pushed them
+    QVector<int> nextFromProducer(NUM_PRODUCERS, 0);
+    int numPopped = 0;
+    QueuedPacket batch[BATCH_SIZE];
+    while (numPopped < NUM_PRODUCERS * PACKETS_PER_PRODUCER) {
+        int numInBatch = queue.popBatch(batch, BATCH_SIZE);
+        for (int i = 0; i < numInBatch; i++) {
+            QList<QByteArray> fields = batch[i].packet.split(':');
+            int producer = fields[0].toInt();
+            assert(fields[1].toInt() == nextFromProducer[producer]);
+            nextFromProducer[producer]++;
+            batch[i] = QueuedPacket();
+        }
+        numPopped += numInBatch;
+    }
+
+    foreach (PacketProducerThread* producer, producers) {
+        producer->wait();
+        delete producer;
+    }
+    assert(queue.popBatch(batch, BATCH_SIZE) == 0);
+}
@@ -0,0 +1,22 @@
+//
+//  ReceivedPacketQueueTests.h
+//  tests/networking/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_ReceivedPacketQueueTests_h
+#define hifi_ReceivedPacketQueueTests_h
+
+namespace ReceivedPacketQueueTests {
+
+    void runAllTests();
+
+    void fullQueueTest();
+    void multipleProducerTest();
+};
+
+#endif // hifi_ReceivedPacketQueueTests_h
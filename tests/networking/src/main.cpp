@@ -8,11 +8,17 @@
 //  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
 //
 
+#include "PacketHashTests.h"
+#include "ReceivedDatagramQueueTests.h"
+#include "ReceivedPacketQueueTests.h"
 #include "SequenceNumberStatsTests.h"
 #include <stdio.h>
 
 int main(int argc, char** argv) {
     SequenceNumberStatsTests::runAllTests();
+    PacketHashTests::runAllTests();
+    ReceivedDatagramQueueTests::runAllTests();
+    ReceivedPacketQueueTests::runAllTests();
     printf("tests passed! press enter to exit");
     getchar();
     return 0;
@@ -0,0 +1,179 @@
+//
+//  OctreeElementBagTests.cpp
+//  tests/octree/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <QDebug>
+
+#include <ModelTree.h>
+#include <OctreeElementBag.h>
+#include <ViewFrustum.h>
+
+#include "OctreeElementBagTests.h"
+
+static void addAllChildren(OctreeElement* parent) {
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        parent->addChildAtIndex(i);
+    }
+}
+
+void OctreeElementBagTests::firstInFirstOutTest() {
+    qDebug() << "OctreeElementBagTests::firstInFirstOutTest()";
+
+    ModelTree tree;
+    OctreeElement* root = tree.getRoot();
+    addAllChildren(root);
+
+    // without a priority view elements come out in the order they went in, and duplicates are ignored
+    OctreeElementBag bag;
+    for (int i = NUMBER_OF_CHILDREN - 1; i >= 0; i--) {
+        bag.insert(root->getChildAtIndex(i));
+    }
+    bag.insert(root->getChildAtIndex(0));
+    bag.insert(root->getChildAtIndex(NUMBER_OF_CHILDREN - 1));
+
+    bool passed = (bag.count() == NUMBER_OF_CHILDREN);
+    for (int i = NUMBER_OF_CHILDREN - 1; i >= 0; i--) {
+        passed = passed && bag.extract() == root->getChildAtIndex(i);
+    }
+    passed = passed && bag.isEmpty() && bag.extract() == NULL;
+
+    qDebug() << (passed ? "firstInFirstOutTest: PASSED" : "firstInFirstOutTest: FAILED");
+}
+
+void OctreeElementBagTests::priorityViewTest() {
+    qDebug() << "OctreeElementBagTests::priorityViewTest()";
+
+    ModelTree tree;
+    OctreeElement* root = tree.getRoot();
+    addAllChildren(root);
+    addAllChildren(root->getChildAtIndex(0));
+
+    ViewFrustum viewFrustum;
+    viewFrustum.setPosition(glm::vec3(1000.0f, 1000.0f, 1000.0f));
+    viewFrustum.calculate();
+
+    OctreeElementBag bag;
+    bag.setPriorityView(&viewFrustum);
+    for (int i = NUMBER_OF_CHILDREN - 1; i >= 0; i--) {
+        bag.insert(root->getChildAtIndex(i));
+        bag.insert(root->getChildAtIndex(0)->getChildAtIndex(i));
+    }
+
+    // children of the same size must come out nearest first, and the smaller ones near the camera must come out
+    // before the big ones on the far side of the tree
+    bool passed = (bag.count() == 2 * NUMBER_OF_CHILDREN);
+    float lastDistance = 0.0f;
+    float lastScale = 0.0f;
+    int extracted = 0;
+    while (!bag.isEmpty()) {
+        OctreeElement* element = bag.extract();
+        float distance = element->distanceToCamera(viewFrustum);
+        if (element->getScale() == lastScale && distance < lastDistance) {
+            passed = false;
+        }
+        if (extracted == 0 && element != root->getChildAtIndex(0)->getChildAtIndex(0)) {
+            passed = false;
+        }
+        if (element == root->getChildAtIndex(NUMBER_OF_CHILDREN - 1) && extracted != 2 * NUMBER_OF_CHILDREN - 1) {
+            passed = false;
+        }
+        lastDistance = distance;
+        lastScale = element->getScale();
+        extracted++;
+    }
+
+    qDebug() << (passed ? "priorityViewTest: PASSED" : "priorityViewTest: FAILED");
+}
+
+void OctreeElementBagTests::reprioritizeTest() {
+    qDebug() << "OctreeElementBagTests::reprioritizeTest()";
+
+    ModelTree tree;
+    OctreeElement* root = tree.getRoot();
+    addAllChildren(root);
+
+    ViewFrustum viewFrustum;
+    viewFrustum.setPosition(glm::vec3(1000.0f, 1000.0f, 1000.0f));
+    viewFrustum.calculate();
+
+    OctreeElementBag bag;
+    bag.setPriorityView(&viewFrustum);
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        bag.insert(root->getChildAtIndex(i));
+    }
+
+    // once the view moves to the far corner of the tree, the children must come out nearest to it first
+    float farCorner = (float)TREE_SCALE - 1000.0f;
+    viewFrustum.setPosition(glm::vec3(farCorner, farCorner, farCorner));
+    viewFrustum.calculate();
+    bag.reprioritize();
+
+    // and the bag must still know where everything is in the rebuilt heap
+    bag.remove(root->getChildAtIndex(3));
+
+    bool passed = (bag.count() == NUMBER_OF_CHILDREN - 1) && !bag.contains(root->getChildAtIndex(3));
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        passed = passed && (i == 3 || bag.contains(root->getChildAtIndex(i)));
+    }
+
+    float lastDistance = 0.0f;
+    int extracted = 0;
+    while (!bag.isEmpty()) {
+        OctreeElement* element = bag.extract();
+        float distance = element->distanceToCamera(viewFrustum);
+        if (distance < lastDistance) {
+            passed = false;
+        }
+        if (extracted == 0 && element != root->getChildAtIndex(NUMBER_OF_CHILDREN - 1)) {
+            passed = false;
+        }
+        if (element == root->getChildAtIndex(0) && extracted != NUMBER_OF_CHILDREN - 2) {
+            passed = false;
+        }
+        lastDistance = distance;
+        extracted++;
+    }
+
+    qDebug() << (passed ? "reprioritizeTest: PASSED" : "reprioritizeTest: FAILED");
+}
+
+void OctreeElementBagTests::removeAndDeleteTest() {
+    qDebug() << "OctreeElementBagTests::removeAndDeleteTest()";
+
+    ModelTree tree;
+    OctreeElement* root = tree.getRoot();
+    addAllChildren(root);
+
+    OctreeElementBag bag;
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        bag.insert(root->getChildAtIndex(i));
+    }
+
+    // removing from the middle and deleting an element in the bag must leave the rest in order
+    bag.remove(root->getChildAtIndex(2));
+    bag.remove(root->getChildAtIndex(2));
+    root->deleteChildAtIndex(5);
+
+    bool passed = (bag.count() == NUMBER_OF_CHILDREN - 2) && !bag.contains(root->getChildAtIndex(2));
+    for (int i = 0; i < NUMBER_OF_CHILDREN; i++) {
+        if (i != 2 && i != 5) {
+            passed = passed && bag.extract() == root->getChildAtIndex(i);
+        }
+    }
+    passed = passed && bag.isEmpty();
+
+    qDebug() << (passed ? "removeAndDeleteTest: PASSED" : "removeAndDeleteTest: FAILED");
+}
+
+void OctreeElementBagTests::runAllTests() {
+    firstInFirstOutTest();
+    priorityViewTest();
+    reprioritizeTest();
+    removeAndDeleteTest();
+}
@@ -0,0 +1,24 @@
+//
+//  OctreeElementBagTests.h
+//  tests/octree/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_OctreeElementBagTests_h
+#define hifi_OctreeElementBagTests_h
+
+namespace OctreeElementBagTests {
+
+    void firstInFirstOutTest();
+    void priorityViewTest();
+    void reprioritizeTest();
+    void removeAndDeleteTest();
+
+    void runAllTests();
+}
+
+#endif // hifi_OctreeElementBagTests_h
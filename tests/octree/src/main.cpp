@@ -11,10 +11,12 @@
 #include "ModelTests.h"
 #include "OctreeTests.h"
 #include "AABoxCubeTests.h"
+#include "OctreeElementBagTests.h"
 
 int main(int argc, char** argv) {
     OctreeTests::runAllTests();
     AABoxCubeTests::runAllTests();
+    OctreeElementBagTests::runAllTests();
     ModelTests::runAllTests(true);
     return 0;
 }
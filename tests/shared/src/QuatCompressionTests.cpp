@@ -0,0 +1,151 @@
+//
+//  QuatCompressionTests.cpp
+//  tests/shared/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <iostream>
+
+#include <QtCore/QVector>
+
+#include <SharedUtil.h>
+
+#include "QuatCompressionTests.h"
+
+const int NUM_TEST_ROTATIONS = 100000;
+
+// what the avatar mixer sends joint rotations with, the avatars library isn't linked in here
+const int JOINT_BITS_PER_COMPONENT = 10;
+
+static glm::quat randomRotation() {
+    return glm::normalize(glm::quat(randFloatInRange(-1.0f, 1.0f), randFloatInRange(-1.0f, 1.0f),
+                                    randFloatInRange(-1.0f, 1.0f), randFloatInRange(-1.0f, 1.0f)));
+}
+
+// the largest difference between the components of two rotations, once they are in the same hemisphere
+static float componentError(const glm::quat& expected, const glm::quat& actual) {
+    glm::quat aligned = (glm::dot(expected, actual) < 0.0f) ? -actual : actual;
+    return glm::max(glm::max(fabsf(expected.x - aligned.x), fabsf(expected.y - aligned.y)),
+                    glm::max(fabsf(expected.z - aligned.z), fabsf(expected.w - aligned.w)));
+}
+
+void QuatCompressionTests::testSmallestThreeRoundTrip() {
+    const int BITS_PER_COMPONENT[] = { 6, 10, 12, 16, MAX_SMALLEST_THREE_BITS_PER_COMPONENT };
+    const int NUM_BITS_PER_COMPONENT = sizeof(BITS_PER_COMPONENT) / sizeof(BITS_PER_COMPONENT[0]);
+
+    for (int i = 0; i < NUM_BITS_PER_COMPONENT; i++) {
+        int bitsPerComponent = BITS_PER_COMPONENT[i];
+
+        // the three smallest components are at most 1/sqrt(2) from zero, so a step is sqrt(2) over the number of steps,
+        // and we are off by at most half a step in each plus whatever that does to the largest
+        float maxExpectedError = 2.0f * SQUARE_ROOT_OF_2 / ((1 << bitsPerComponent) - 1);
+        float maxError = 0.0f;
+
+        for (int j = 0; j < NUM_TEST_ROTATIONS; j++) {
+            glm::quat rotation = randomRotation();
+
+            unsigned char buffer[sizeof(quint64)];
+            int bytesWritten = packOrientationQuatToSmallestThree(buffer, rotation, bitsPerComponent);
+
+            glm::quat unpacked;
+            int bytesRead = unpackOrientationQuatFromSmallestThree(buffer, unpacked, bitsPerComponent);
+
+            if (bytesWritten != numBytesForSmallestThreeQuat(bitsPerComponent) || bytesRead != bytesWritten) {
+                std::cout << __FILE__ << ":" << __LINE__ << " ERROR: packed " << bytesWritten << " bytes and unpacked "
+                    << bytesRead << " with " << bitsPerComponent << " bits per component" << std::endl;
+                return;
+            }
+            maxError = glm::max(maxError, componentError(rotation, unpacked));
+        }
+
+        if (maxError > maxExpectedError) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: " << bitsPerComponent << " bits per component is off by "
+                << maxError << ", expected at most " << maxExpectedError << std::endl;
+        }
+    }
+
+    // the rotations that are exactly on an axis, or have two equal largest components, have to survive too
+    glm::quat edgeRotations[] = { glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::quat(0.0f, 0.0f, 0.0f, -1.0f),
+                                  glm::normalize(glm::quat(1.0f, 1.0f, 0.0f, 0.0f)),
+                                  glm::normalize(glm::quat(0.5f, -0.5f, 0.5f, -0.5f)) };
+    for (size_t i = 0; i < sizeof(edgeRotations) / sizeof(edgeRotations[0]); i++) {
+        unsigned char buffer[sizeof(quint64)];
+        packOrientationQuatToSmallestThree(buffer, edgeRotations[i], JOINT_BITS_PER_COMPONENT);
+
+        glm::quat unpacked;
+        unpackOrientationQuatFromSmallestThree(buffer, unpacked, JOINT_BITS_PER_COMPONENT);
+
+        if (componentError(edgeRotations[i], unpacked) > 0.01f) {
+            std::cout << __FILE__ << ":" << __LINE__ << " ERROR: edge rotation " << i << " didn't survive packing"
+                << std::endl;
+        }
+    }
+}
+
+void QuatCompressionTests::benchmarkQuatCompression() {
+    QVector<glm::quat> rotations;
+    for (int i = 0; i < NUM_TEST_ROTATIONS; i++) {
+        rotations.append(randomRotation());
+    }
+    QVector<unsigned char> buffer(NUM_TEST_ROTATIONS * sizeof(quint64));
+    glm::quat unpacked;
+
+    // accumulate something from every rotation so none of the loops can be optimized away
+    float checksum = 0.0f;
+
+    // the four uint16 components every joint used to be sent as
+    quint64 start = usecTimestampNow();
+    unsigned char* bufferAt = buffer.data();
+    for (int i = 0; i < NUM_TEST_ROTATIONS; i++) {
+        bufferAt += packOrientationQuatToBytes(bufferAt, rotations[i]);
+    }
+    int fourComponentBytes = bufferAt - buffer.data();
+    float fourComponentPackNsecs = (usecTimestampNow() - start) * 1000.0f / NUM_TEST_ROTATIONS;
+
+    start = usecTimestampNow();
+    bufferAt = buffer.data();
+    for (int i = 0; i < NUM_TEST_ROTATIONS; i++) {
+        bufferAt += unpackOrientationQuatFromBytes(bufferAt, unpacked);
+        checksum += unpacked.w;
+    }
+    float fourComponentUnpackNsecs = (usecTimestampNow() - start) * 1000.0f / NUM_TEST_ROTATIONS;
+
+    start = usecTimestampNow();
+    bufferAt = buffer.data();
+    for (int i = 0; i < NUM_TEST_ROTATIONS; i++) {
+        bufferAt += packOrientationQuatToSmallestThree(bufferAt, rotations[i], JOINT_BITS_PER_COMPONENT);
+    }
+    int smallestThreeBytes = bufferAt - buffer.data();
+    float smallestThreePackNsecs = (usecTimestampNow() - start) * 1000.0f / NUM_TEST_ROTATIONS;
+
+    start = usecTimestampNow();
+    bufferAt = buffer.data();
+    for (int i = 0; i < NUM_TEST_ROTATIONS; i++) {
+        bufferAt += unpackOrientationQuatFromSmallestThree(bufferAt, unpacked, JOINT_BITS_PER_COMPONENT);
+        checksum += unpacked.w;
+    }
+    float smallestThreeUnpackNsecs = (usecTimestampNow() - start) * 1000.0f / NUM_TEST_ROTATIONS;
+
+    float maxError = 0.0f;
+    bufferAt = buffer.data();
+    for (int i = 0; i < NUM_TEST_ROTATIONS; i++) {
+        bufferAt += unpackOrientationQuatFromSmallestThree(bufferAt, unpacked, JOINT_BITS_PER_COMPONENT);
+        maxError = glm::max(maxError, componentError(rotations[i], unpacked));
+    }
+
+    qDebug("TIME - four uint16 components: %d bytes, pack %.1f nsecs, unpack %.1f nsecs per rotation",
+           fourComponentBytes / NUM_TEST_ROTATIONS, fourComponentPackNsecs, fourComponentUnpackNsecs);
+    qDebug("TIME - smallest three with %d bits: %d bytes, pack %.1f nsecs, unpack %.1f nsecs per rotation, "
+           "max component error %f", JOINT_BITS_PER_COMPONENT, smallestThreeBytes / NUM_TEST_ROTATIONS,
+           smallestThreePackNsecs, smallestThreeUnpackNsecs, maxError);
+    qDebug("quat compression benchmark checksum %f", checksum);
+}
+
+void QuatCompressionTests::runAllTests() {
+    testSmallestThreeRoundTrip();
+    benchmarkQuatCompression();
+}
@@ -0,0 +1,20 @@
+//
+//  QuatCompressionTests.h
+//  tests/shared/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_QuatCompressionTests_h
+#define hifi_QuatCompressionTests_h
+
+namespace QuatCompressionTests {
+    void testSmallestThreeRoundTrip();
+    void benchmarkQuatCompression();
+    void runAllTests();
+}
+
+#endif // hifi_QuatCompressionTests_h
@@ -11,11 +11,13 @@
 #include "AngularConstraintTests.h"
 #include "MovingPercentileTests.h"
 #include "MovingMinMaxAvgTests.h"
+#include "QuatCompressionTests.h"
 
 int main(int argc, char** argv) {
     MovingMinMaxAvgTests::runAllTests();
     MovingPercentileTests::runAllTests();
     AngularConstraintTests::runAllTests();
+    QuatCompressionTests::runAllTests();
     getchar();
     return 0;
 }
@@ -0,0 +1,288 @@
+//
+//  LoadAgent.cpp
+//  tools/mixer-load/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <iostream>
+
+#include <QtCore/QDataStream>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QTimer>
+
+#include <glm/gtc/quaternion.hpp>
+
+#include <AudioRingBuffer.h>
+#include <NodeList.h>
+#include <PacketHeaders.h>
+#include <SharedUtil.h>
+
+#include "LoadAgent.h"
+
+// the agents walk around concentric rings, alternating direction from one ring to the next
+const glm::vec3 PATH_CENTER(50.0f, 0.0f, 50.0f);
+const float PATH_MIN_RADIUS = 2.0f; // meters
+const float PATH_RING_SPACING = 3.0f; // meters
+const int NUM_PATH_RINGS = 8;
+const float PATH_SPEED = 1.5f; // meters per second
+
+const float AGENT_FIELD_OF_VIEW = 60.0f; // degrees
+const float AGENT_ASPECT_RATIO = 16.0f / 9.0f;
+const float AGENT_NEAR_CLIP = 0.1f;
+const float AGENT_FAR_CLIP = 100.0f;
+
+const float TONE_BASE_FREQUENCY = 220.0f;
+const float TONE_FREQUENCY_STEP = 10.0f;
+const float TONE_AMPLITUDE = 2000.0f;
+
+// how often each agent ticks to send whatever is due, and prints its stats
+const int TICK_INTERVAL_MSECS = 1;
+const int STATS_INTERVAL_MSECS = 1000;
+
+MixerStreamStats::MixerStreamStats() :
+    packets(0),
+    bytes(0),
+    frameIntervals(),
+    _lastPacketUsecs(0)
+{
+
+}
+
+void MixerStreamStats::packetReceived(int numBytes) {
+    quint64 now = usecTimestampNow();
+    if (_lastPacketUsecs != 0 && now - _lastPacketUsecs > SAME_FRAME_THRESHOLD_USECS) {
+        frameIntervals.append(now - _lastPacketUsecs);
+    }
+    _lastPacketUsecs = now;
+
+    packets++;
+    bytes += numBytes;
+}
+
+void MixerStreamStats::reset() {
+    packets = 0;
+    bytes = 0;
+    frameIntervals.clear();
+}
+
+static QJsonObject jsonForStreamStats(const MixerStreamStats& stats) {
+    QJsonObject statsObject;
+    statsObject["packets"] = stats.packets;
+    statsObject["bytes"] = (double) stats.bytes;
+
+    QJsonArray intervals;
+    foreach (quint64 interval, stats.frameIntervals) {
+        intervals.append((double) interval);
+    }
+    statsObject["frame_intervals_usecs"] = intervals;
+
+    return statsObject;
+}
+
+LoadAgent::LoadAgent(int index, int numAgents, bool sendAvatarData, bool sendAudio, QObject* parent) :
+    QObject(parent),
+    _index(index),
+    _numAgents(numAgents),
+    _sendAvatarData(sendAvatarData),
+    _sendAudio(sendAudio),
+    _avatar(),
+    _viewFrustum(),
+    _startUsecs(usecTimestampNow()),
+    _nextAvatarDataUsecs(_startUsecs),
+    _nextAudioFrameUsecs(_startUsecs),
+    _toneFrequency(TONE_BASE_FREQUENCY + (index * TONE_FREQUENCY_STEP)),
+    _toneSampleOffset(0),
+    _outgoingAudioSequenceNumbers(),
+    _avatarStats(),
+    _audioStats(),
+    _numSentPackets(0)
+{
+    // call model URL setters with empty URLs so our avatar will have the default models
+    _avatar.setFaceModelURL(QUrl());
+    _avatar.setSkeletonModelURL(QUrl());
+    _avatar.setDisplayName(QString("load-agent-%1").arg(index));
+
+    _viewFrustum.setFieldOfView(AGENT_FIELD_OF_VIEW);
+    _viewFrustum.setAspectRatio(AGENT_ASPECT_RATIO);
+    _viewFrustum.setNearClip(AGENT_NEAR_CLIP);
+    _viewFrustum.setFarClip(AGENT_FAR_CLIP);
+
+    NodeList* nodeList = NodeList::getInstance();
+    nodeList->addSetOfNodeTypesToNodeInterestSet(NodeSet() << NodeType::AvatarMixer << NodeType::AudioMixer);
+
+    QTimer* domainServerTimer = new QTimer(this);
+    connect(domainServerTimer, SIGNAL(timeout()), nodeList, SLOT(sendDomainServerCheckIn()));
+    domainServerTimer->start(DOMAIN_SERVER_CHECK_IN_MSECS);
+
+    QTimer* silentNodeTimer = new QTimer(this);
+    connect(silentNodeTimer, SIGNAL(timeout()), nodeList, SLOT(removeSilentNodes()));
+    silentNodeTimer->start(NODE_SILENCE_THRESHOLD_MSECS);
+
+    QTimer* tickTimer = new QTimer(this);
+    tickTimer->setTimerType(Qt::PreciseTimer);
+    connect(tickTimer, SIGNAL(timeout()), SLOT(tick()));
+    tickTimer->start(TICK_INTERVAL_MSECS);
+
+    QTimer* identityTimer = new QTimer(this);
+    connect(identityTimer, SIGNAL(timeout()), SLOT(sendIdentityPacket()));
+    identityTimer->start(AVATAR_IDENTITY_PACKET_SEND_INTERVAL_MSECS);
+
+    QTimer* statsTimer = new QTimer(this);
+    connect(statsTimer, SIGNAL(timeout()), SLOT(printStats()));
+    statsTimer->start(STATS_INTERVAL_MSECS);
+
+    connect(&nodeList->getNodeSocket(), SIGNAL(readyRead()), SLOT(readPendingDatagrams()));
+}
+
+void LoadAgent::tick() {
+    quint64 now = usecTimestampNow();
+    updatePath(now);
+
+    // catch up on anything we missed if the timer ran late, the mixers expect a steady stream
+    if (_sendAvatarData) {
+        while (_nextAvatarDataUsecs <= now) {
+            sendAvatarData();
+            _nextAvatarDataUsecs += AVATAR_DATA_SEND_INTERVAL_USECS;
+        }
+    }
+
+    if (_sendAudio) {
+        while (_nextAudioFrameUsecs <= now) {
+            sendAudioFrame();
+            _nextAudioFrameUsecs += BUFFER_SEND_INTERVAL_USECS;
+        }
+    }
+}
+
+void LoadAgent::updatePath(quint64 now) {
+    int ring = _index % NUM_PATH_RINGS;
+    float radius = PATH_MIN_RADIUS + (ring * PATH_RING_SPACING);
+    float direction = (ring % 2 == 0) ? 1.0f : -1.0f;
+
+    // spread the agents evenly around their rings
+    float startAngle = TWO_PI * _index / _numAgents;
+    float elapsedSeconds = (float) (now - _startUsecs) / USECS_PER_SECOND;
+    float angle = startAngle + (direction * elapsedSeconds * PATH_SPEED / radius);
+
+    glm::vec3 position = PATH_CENTER + glm::vec3(radius * cosf(angle), 0.0f, radius * sinf(angle));
+
+    // face the way we're walking, so about half of the other agents are out of view
+    glm::vec3 heading(-sinf(angle) * direction, 0.0f, cosf(angle) * direction);
+    glm::quat orientation = rotationBetween(glm::vec3(0.0f, 0.0f, -1.0f), heading);
+
+    _avatar.setPosition(position);
+    _avatar.setOrientation(orientation);
+
+    _viewFrustum.setPosition(position);
+    _viewFrustum.setOrientation(orientation);
+    _viewFrustum.calculate();
+}
+
+void LoadAgent::sendAvatarData() {
+    QByteArray packet = byteArrayWithPopulatedHeader(PacketTypeAvatarData);
+    packet.append(_avatar.toByteArray());
+
+    // follow it with our camera like the interface does, so the mixer's interest management is exercised
+    int avatarDataSize = packet.size();
+    packet.resize(avatarDataSize + ViewFrustum::numBytesCameraDetails());
+    _viewFrustum.packCameraDetails(reinterpret_cast<unsigned char*>(packet.data()) + avatarDataSize);
+
+    _numSentPackets += NodeList::getInstance()->broadcastToNodes(packet, NodeSet() << NodeType::AvatarMixer);
+}
+
+void LoadAgent::sendAudioFrame() {
+    int16_t samples[NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL];
+    for (int i = 0; i < NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL; i++) {
+        samples[i] = (int16_t) (TONE_AMPLITUDE * sinf(TWO_PI * _toneFrequency * (_toneSampleOffset + i) / SAMPLE_RATE));
+    }
+    _toneSampleOffset = (_toneSampleOffset + NETWORK_BUFFER_LENGTH_SAMPLES_PER_CHANNEL) % SAMPLE_RATE;
+
+    QByteArray audioPacket = byteArrayWithPopulatedHeader(PacketTypeMicrophoneAudioNoEcho);
+    QDataStream packetStream(&audioPacket, QIODevice::Append);
+
+    // pack a placeholder value for sequence number for now, it is packed when the destination node is known
+    int numPreSequenceNumberBytes = audioPacket.size();
+    packetStream << (quint16) 0;
+
+    // mono
+    packetStream << (quint8) 0;
+
+    packetStream.writeRawData(reinterpret_cast<const char*>(&_avatar.getPosition()), sizeof(glm::vec3));
+    glm::quat orientation = _avatar.getOrientation();
+    packetStream.writeRawData(reinterpret_cast<const char*>(&orientation), sizeof(glm::quat));
+    packetStream.writeRawData(reinterpret_cast<const char*>(samples), sizeof(samples));
+
+    NodeList* nodeList = NodeList::getInstance();
+    foreach (const SharedNodePointer& node, nodeList->getNodeHash()) {
+        if (node->getType() == NodeType::AudioMixer && node->getActiveSocket()) {
+            quint16 sequence = _outgoingAudioSequenceNumbers[node->getUUID()]++;
+            memcpy(audioPacket.data() + numPreSequenceNumberBytes, &sequence, sizeof(quint16));
+
+            nodeList->writeDatagram(audioPacket, node);
+            _numSentPackets++;
+        }
+    }
+}
+
+void LoadAgent::sendIdentityPacket() {
+    if (_sendAvatarData) {
+        _avatar.sendIdentityPacket();
+    }
+}
+
+void LoadAgent::printStats() {
+    QJsonObject statsObject;
+    statsObject["agent"] = _index;
+    statsObject["sent_packets"] = _numSentPackets;
+    statsObject[AVATAR_MIXER_STATS_KEY] = jsonForStreamStats(_avatarStats);
+    statsObject[AUDIO_MIXER_STATS_KEY] = jsonForStreamStats(_audioStats);
+
+    // one line per report, the load generator reads them from our standard output
+    QByteArray statsJSON = QJsonDocument(statsObject).toJson(QJsonDocument::Compact);
+    std::cout << STATS_LINE_PREFIX << statsJSON.constData() << std::endl;
+
+    _numSentPackets = 0;
+    _avatarStats.reset();
+    _audioStats.reset();
+}
+
+void LoadAgent::readPendingDatagrams() {
+    NodeList* nodeList = NodeList::getInstance();
+
+    static QByteArray receivedPacket;
+    static HifiSockAddr senderSockAddr;
+
+    while (nodeList->getNodeSocket().hasPendingDatagrams()) {
+        receivedPacket.resize(nodeList->getNodeSocket().pendingDatagramSize());
+        nodeList->getNodeSocket().readDatagram(receivedPacket.data(), receivedPacket.size(),
+                                               senderSockAddr.getAddressPointer(), senderSockAddr.getPortPointer());
+
+        if (!nodeList->packetVersionAndHashMatch(receivedPacket)) {
+            continue;
+        }
+
+        PacketType packetType = packetTypeForPacket(receivedPacket);
+        if (packetType == PacketTypeBulkAvatarData || packetType == PacketTypeAvatarIdentity
+            || packetType == PacketTypeAvatarBillboard || packetType == PacketTypeKillAvatar) {
+            _avatarStats.packetReceived(receivedPacket.size());
+        } else if (packetType == PacketTypeMixedAudio || packetType == PacketTypeSilentAudioFrame
+                   || packetType == PacketTypeAudioStreamStats) {
+            _audioStats.packetReceived(receivedPacket.size());
+        } else {
+            nodeList->processNodeData(senderSockAddr, receivedPacket);
+            continue;
+        }
+
+        // make sure our NodeList knows we've heard from this mixer
+        SharedNodePointer sendingNode = nodeList->sendingNodeForPacket(receivedPacket);
+        if (sendingNode) {
+            sendingNode->setLastHeardMicrostamp(usecTimestampNow());
+        }
+    }
+}
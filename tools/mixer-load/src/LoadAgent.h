@@ -0,0 +1,92 @@
+//
+//  LoadAgent.h
+//  tools/mixer-load/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  A headless agent that moves an avatar on a scripted path and streams a tone to the audio mixer, counting what the
+//  mixers send back to it.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_LoadAgent_h
+#define hifi_LoadAgent_h
+
+#include <QtCore/QHash>
+#include <QtCore/QObject>
+#include <QtCore/QUuid>
+#include <QtCore/QVector>
+
+#include <AvatarData.h>
+#include <ViewFrustum.h>
+
+// each agent prints a line starting with this, followed by its stats in JSON, once a second
+const char STATS_LINE_PREFIX[] = "STATS ";
+
+// the same names the domain-server gives the mixers in its node list
+const char AVATAR_MIXER_STATS_KEY[] = "avatar-mixer";
+const char AUDIO_MIXER_STATS_KEY[] = "audio-mixer";
+
+const int AVATAR_DATA_SEND_INTERVAL_USECS = USECS_PER_SECOND / 60;
+
+// packets from a mixer that arrive closer together than this are counted as part of the same mixer frame
+const quint64 SAME_FRAME_THRESHOLD_USECS = 2 * USECS_PER_MSEC;
+
+/// what one agent received from one mixer since its last stats line
+class MixerStreamStats {
+public:
+    MixerStreamStats();
+
+    void packetReceived(int numBytes);
+    void reset();
+
+    int packets;
+    qint64 bytes;
+
+    // the time between the first packets of consecutive mixer frames
+    QVector<quint64> frameIntervals;
+
+private:
+    quint64 _lastPacketUsecs;
+};
+
+class LoadAgent : public QObject {
+    Q_OBJECT
+public:
+    LoadAgent(int index, int numAgents, bool sendAvatarData, bool sendAudio, QObject* parent = NULL);
+
+private slots:
+    void tick();
+    void sendIdentityPacket();
+    void printStats();
+    void readPendingDatagrams();
+
+private:
+    void updatePath(quint64 now);
+    void sendAvatarData();
+    void sendAudioFrame();
+
+    int _index;
+    int _numAgents;
+    bool _sendAvatarData;
+    bool _sendAudio;
+
+    AvatarData _avatar;
+    ViewFrustum _viewFrustum;
+
+    quint64 _startUsecs;
+    quint64 _nextAvatarDataUsecs;
+    quint64 _nextAudioFrameUsecs;
+
+    float _toneFrequency;
+    int _toneSampleOffset;
+    QHash<QUuid, quint16> _outgoingAudioSequenceNumbers;
+
+    MixerStreamStats _avatarStats;
+    MixerStreamStats _audioStats;
+    int _numSentPackets;
+};
+
+#endif // hifi_LoadAgent_h
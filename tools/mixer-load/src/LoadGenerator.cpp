@@ -0,0 +1,230 @@
+//
+//  LoadGenerator.cpp
+//  tools/mixer-load/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <algorithm>
+#include <string.h>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDebug>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QTimer>
+#include <QtCore/QUrl>
+#include <QtNetwork/QNetworkReply>
+#include <QtNetwork/QNetworkRequest>
+
+#include <DomainHandler.h>
+#include <SharedUtil.h>
+
+#include "LoadAgent.h"
+
+#include "LoadGenerator.h"
+
+const int MIXER_STATS_REQUEST_INTERVAL_MSECS = 1000;
+const int AGENT_EXIT_TIMEOUT_MSECS = 1000;
+
+MixerLoadStats::MixerLoadStats() :
+    packets(0),
+    bytes(0),
+    frameIntervals(),
+    sleepPercentages(),
+    throttlingRatios()
+{
+
+}
+
+LoadGenerator::LoadGenerator(int numAgents, const QString& domainHostname, int warmupSeconds, int durationSeconds,
+                             const QStringList& agentArguments, QObject* parent) :
+    QObject(parent),
+    _numAgents(numAgents),
+    _domainHostname(domainHostname),
+    _warmupSeconds(warmupSeconds),
+    _durationSeconds(durationSeconds),
+    _agents(),
+    _networkAccessManager(),
+    _startUsecs(usecTimestampNow()),
+    _measureStartUsecs(0),
+    _isMeasuring(false),
+    _sentPackets(0),
+    _mixerStats()
+{
+    qDebug() << "Starting" << numAgents << "load agents against the domain at" << domainHostname;
+
+    // each agent is its own process, since an agent needs a NodeList and there is only one of those per process
+    for (int i = 0; i < numAgents; i++) {
+        QProcess* agent = new QProcess(this);
+        agent->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        connect(agent, SIGNAL(readyReadStandardOutput()), SLOT(readAgentOutput()));
+
+        agent->start(QCoreApplication::applicationFilePath(), QStringList() << "--agent" << QString::number(i)
+                     << agentArguments);
+        _agents.append(agent);
+    }
+
+    connect(&_networkAccessManager, SIGNAL(finished(QNetworkReply*)), SLOT(handleNetworkReply(QNetworkReply*)));
+
+    QTimer* mixerStatsTimer = new QTimer(this);
+    connect(mixerStatsTimer, SIGNAL(timeout()), SLOT(requestMixerStats()));
+    mixerStatsTimer->start(MIXER_STATS_REQUEST_INTERVAL_MSECS);
+
+    // give the agents time to connect to the mixers before anything counts
+    QTimer::singleShot(warmupSeconds * MSECS_PER_SECOND, this, SLOT(startMeasuring()));
+    QTimer::singleShot((warmupSeconds + durationSeconds) * MSECS_PER_SECOND, this, SLOT(finish()));
+}
+
+void LoadGenerator::startMeasuring() {
+    qDebug() << "Warmup done, measuring for" << _durationSeconds << "seconds.";
+    _measureStartUsecs = usecTimestampNow();
+    _isMeasuring = true;
+}
+
+void LoadGenerator::readAgentOutput() {
+    QProcess* agent = qobject_cast<QProcess*>(sender());
+    if (!agent) {
+        return;
+    }
+
+    while (agent->canReadLine()) {
+        QByteArray line = agent->readLine().trimmed();
+        if (line.startsWith(STATS_LINE_PREFIX)) {
+            QJsonDocument statsDocument = QJsonDocument::fromJson(line.mid(strlen(STATS_LINE_PREFIX)));
+            if (_isMeasuring && statsDocument.isObject()) {
+                parseAgentStats(statsDocument.object());
+            }
+        } else if (!line.isEmpty()) {
+            qDebug() << "Agent" << _agents.indexOf(agent) << ":" << line.constData();
+        }
+    }
+}
+
+void LoadGenerator::parseAgentStats(const QJsonObject& statsObject) {
+    _sentPackets += statsObject["sent_packets"].toVariant().toLongLong();
+
+    QStringList mixerTypes = QStringList() << AVATAR_MIXER_STATS_KEY << AUDIO_MIXER_STATS_KEY;
+    foreach (const QString& mixerType, mixerTypes) {
+        QJsonObject streamObject = statsObject[mixerType].toObject();
+        MixerLoadStats& stats = _mixerStats[mixerType];
+
+        stats.packets += streamObject["packets"].toVariant().toLongLong();
+        stats.bytes += streamObject["bytes"].toVariant().toLongLong();
+
+        foreach (const QJsonValue& interval, streamObject["frame_intervals_usecs"].toArray()) {
+            stats.frameIntervals.append((quint64) interval.toDouble());
+        }
+    }
+}
+
+void LoadGenerator::requestMixerStats() {
+    // find the mixers first, the reply for the node list asks for the stats of each one
+    QUrl nodesURL(QString("http://%1:%2/nodes.json").arg(_domainHostname).arg(DOMAIN_SERVER_HTTP_PORT));
+    _networkAccessManager.get(QNetworkRequest(nodesURL));
+}
+
+void LoadGenerator::handleNetworkReply(QNetworkReply* reply) {
+    reply->deleteLater();
+
+    if (reply->error() != QNetworkReply::NoError) {
+        qDebug() << "Could not get" << reply->url().toString() << "from the domain-server -" << reply->errorString();
+        return;
+    }
+
+    QJsonObject replyObject = QJsonDocument::fromJson(reply->readAll()).object();
+
+    if (replyObject.contains("nodes")) {
+        foreach (const QJsonValue& nodeValue, replyObject["nodes"].toArray()) {
+            QJsonObject nodeObject = nodeValue.toObject();
+            QString nodeType = nodeObject["type"].toString();
+
+            if (nodeType == AVATAR_MIXER_STATS_KEY || nodeType == AUDIO_MIXER_STATS_KEY) {
+                QUrl statsURL(QString("http://%1:%2/nodes/%3.json").arg(_domainHostname).arg(DOMAIN_SERVER_HTTP_PORT)
+                              .arg(nodeObject["uuid"].toString()));
+                _networkAccessManager.get(QNetworkRequest(statsURL));
+            }
+        }
+    } else if (_isMeasuring && replyObject.contains("node_type")) {
+        MixerLoadStats& stats = _mixerStats[replyObject["node_type"].toString()];
+        stats.sleepPercentages.append(replyObject["trailing_sleep_percentage"].toDouble());
+        stats.throttlingRatios.append(replyObject["performance_throttling_ratio"].toDouble());
+    }
+}
+
+static quint64 percentile(const QVector<quint64>& sortedValues, float fraction) {
+    if (sortedValues.isEmpty()) {
+        return 0;
+    }
+    return sortedValues[(int) (fraction * (sortedValues.size() - 1))];
+}
+
+void LoadGenerator::printMixerReport(const QString& mixerType, const MixerLoadStats& stats, float seconds) const {
+    qDebug("%s:", qPrintable(mixerType));
+
+    float packetsPerSecond = stats.packets / seconds;
+    qDebug("    received %.1f packets/s, %.1f per listener", packetsPerSecond, packetsPerSecond / _numAgents);
+    qDebug("    received %.1f bytes/s per listener", stats.bytes / seconds / _numAgents);
+
+    QVector<quint64> sortedIntervals = stats.frameIntervals;
+    qSort(sortedIntervals);
+    const float USECS_PER_MSEC_FLOAT = (float) USECS_PER_MSEC;
+    qDebug("    frame interval at listeners (ms) - p50 %.2f, p95 %.2f, p99 %.2f, max %.2f",
+           percentile(sortedIntervals, 0.5f) / USECS_PER_MSEC_FLOAT,
+           percentile(sortedIntervals, 0.95f) / USECS_PER_MSEC_FLOAT,
+           percentile(sortedIntervals, 0.99f) / USECS_PER_MSEC_FLOAT,
+           percentile(sortedIntervals, 1.0f) / USECS_PER_MSEC_FLOAT);
+
+    if (stats.throttlingRatios.isEmpty()) {
+        qDebug("    no stats from the domain-server for this mixer");
+        return;
+    }
+
+    float sumSleep = 0.0f;
+    float minSleep = stats.sleepPercentages[0];
+    foreach (float sleepPercentage, stats.sleepPercentages) {
+        sumSleep += sleepPercentage;
+        minSleep = std::min(minSleep, sleepPercentage);
+    }
+
+    float sumThrottling = 0.0f;
+    float maxThrottling = 0.0f;
+    int numThrottledSamples = 0;
+    foreach (float throttlingRatio, stats.throttlingRatios) {
+        sumThrottling += throttlingRatio;
+        maxThrottling = std::max(maxThrottling, throttlingRatio);
+        if (throttlingRatio > 0.0f) {
+            numThrottledSamples++;
+        }
+    }
+
+    qDebug("    trailing sleep %% - average %.1f, min %.1f", sumSleep / stats.sleepPercentages.size(), minSleep);
+    qDebug("    throttling ratio - average %.2f, max %.2f, throttled for %d of %d seconds",
+           sumThrottling / stats.throttlingRatios.size(), maxThrottling, numThrottledSamples,
+           stats.throttlingRatios.size());
+}
+
+void LoadGenerator::finish() {
+    float seconds = (float) (usecTimestampNow() - _measureStartUsecs) / USECS_PER_SECOND;
+
+    qDebug("%d agents over %.1f seconds, after %.1f seconds of warmup:", _numAgents, seconds,
+           (float) (_measureStartUsecs - _startUsecs) / USECS_PER_SECOND);
+    qDebug("    agents sent %.1f packets/s", _sentPackets / seconds);
+
+    printMixerReport(AVATAR_MIXER_STATS_KEY, _mixerStats.value(AVATAR_MIXER_STATS_KEY), seconds);
+    printMixerReport(AUDIO_MIXER_STATS_KEY, _mixerStats.value(AUDIO_MIXER_STATS_KEY), seconds);
+
+    foreach (QProcess* agent, _agents) {
+        agent->terminate();
+    }
+    foreach (QProcess* agent, _agents) {
+        if (!agent->waitForFinished(AGENT_EXIT_TIMEOUT_MSECS)) {
+            agent->kill();
+        }
+    }
+
+    QCoreApplication::quit();
+}
@@ -0,0 +1,73 @@
+//
+//  LoadGenerator.h
+//  tools/mixer-load/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Runs a set of load agents against a local domain, collects what they and the mixers report, and prints a summary.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#ifndef hifi_LoadGenerator_h
+#define hifi_LoadGenerator_h
+
+#include <QtCore/QHash>
+#include <QtCore/QJsonObject>
+#include <QtCore/QList>
+#include <QtCore/QObject>
+#include <QtCore/QProcess>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+#include <QtNetwork/QNetworkAccessManager>
+
+/// everything measured for one mixer once the warmup is over
+class MixerLoadStats {
+public:
+    MixerLoadStats();
+
+    qint64 packets;
+    qint64 bytes;
+    QVector<quint64> frameIntervals;
+
+    // sampled from the mixer's stats on the domain-server once a second
+    QVector<float> sleepPercentages;
+    QVector<float> throttlingRatios;
+};
+
+class LoadGenerator : public QObject {
+    Q_OBJECT
+public:
+    /// agentArguments are passed on to every agent process after its index
+    LoadGenerator(int numAgents, const QString& domainHostname, int warmupSeconds, int durationSeconds,
+                  const QStringList& agentArguments, QObject* parent = NULL);
+
+private slots:
+    void startMeasuring();
+    void readAgentOutput();
+    void requestMixerStats();
+    void handleNetworkReply(QNetworkReply* reply);
+    void finish();
+
+private:
+    void parseAgentStats(const QJsonObject& statsObject);
+    void printMixerReport(const QString& mixerType, const MixerLoadStats& stats, float seconds) const;
+
+    int _numAgents;
+    QString _domainHostname;
+    int _warmupSeconds;
+    int _durationSeconds;
+
+    QList<QProcess*> _agents;
+    QNetworkAccessManager _networkAccessManager;
+
+    quint64 _startUsecs;
+    quint64 _measureStartUsecs;
+    bool _isMeasuring;
+
+    qint64 _sentPackets;
+    QHash<QString, MixerLoadStats> _mixerStats;
+};
+
+#endif // hifi_LoadGenerator_h
@@ -0,0 +1,75 @@
+//
+//  main.cpp
+//  tools/mixer-load/src
+//
+//  Copyright 2014 High Fidelity, Inc.
+//
+//  Distributed under the Apache License, Version 2.0.
+//  See the accompanying file LICENSE or http://www.apache.org/licenses/LICENSE-2.0.html
+//
+
+#include <iostream>
+#include <stdlib.h>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QStringList>
+
+#include <NodeList.h>
+#include <SharedUtil.h>
+
+#include "LoadAgent.h"
+#include "LoadGenerator.h"
+
+using namespace std;
+
+const int DEFAULT_NUM_AGENTS = 20;
+const int DEFAULT_WARMUP_SECONDS = 10;
+const int DEFAULT_DURATION_SECONDS = 30;
+const char DEFAULT_DOMAIN_HOSTNAME[] = "localhost";
+
+static int intOption(int argc, const char** argv, const char* option, int defaultValue) {
+    const char* value = getCmdOption(argc, argv, option);
+    return value ? atoi(value) : defaultValue;
+}
+
+int main(int argc, char** argv) {
+    QCoreApplication app(argc, argv);
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    const char** constArgv = (const char**) argv;
+
+    if (cmdOptionExists(argc, constArgv, "--help")) {
+        cerr << "Usage: mixer-load [--agents N] [--domain hostname] [--warmup seconds] [--duration seconds]"
+            " [--no-avatar-data] [--no-audio]" << endl;
+        return 0;
+    }
+
+    int numAgents = intOption(argc, constArgv, "--agents", DEFAULT_NUM_AGENTS);
+    const char* domainOption = getCmdOption(argc, constArgv, "--domain");
+    QString domainHostname = domainOption ? domainOption : DEFAULT_DOMAIN_HOSTNAME;
+    bool sendAvatarData = !cmdOptionExists(argc, constArgv, "--no-avatar-data");
+    bool sendAudio = !cmdOptionExists(argc, constArgv, "--no-audio");
+
+    const char* agentIndex = getCmdOption(argc, constArgv, "--agent");
+    if (agentIndex) {
+        // we were started by the load generator to be one of its agents
+        NodeList* nodeList = NodeList::createInstance(NodeType::Agent);
+        nodeList->getDomainHandler().setHostname(domainHostname);
+
+        LoadAgent agent(atoi(agentIndex), numAgents, sendAvatarData, sendAudio);
+        return app.exec();
+    }
+
+    QStringList agentArguments = QStringList() << "--agents" << QString::number(numAgents)
+        << "--domain" << domainHostname;
+    if (!sendAvatarData) {
+        agentArguments << "--no-avatar-data";
+    }
+    if (!sendAudio) {
+        agentArguments << "--no-audio";
+    }
+
+    LoadGenerator generator(numAgents, domainHostname, intOption(argc, constArgv, "--warmup", DEFAULT_WARMUP_SECONDS),
+                            intOption(argc, constArgv, "--duration", DEFAULT_DURATION_SECONDS), agentArguments);
+    return app.exec();
+}